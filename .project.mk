@@ -1,4 +1,7 @@
 CXXFLAGS += -std=c++1z
+# The numeric evaluation can use several threads
+CXXFLAGS += -pthread
+LDFLAGS  += -pthread
 
 # Enable if you need to
 #STATIC_LIBSTDCXX=
@@ -9,12 +12,14 @@ CXXFLAGS += -std=c++1z
 PARSERS.deps          := UTILS
 CASNUMBER.deps        := PARSERS UTILS
 CASEXPR.deps          := CASNUMBER
-CASRENDERING.deps     := CASEXPR UTILS
-CASREDUCTION.deps     := CASEXPR
+CASRENDERING.deps     := NBRS CASEXPR UTILS
+CASPOLY.deps          := NBRS CASEXPR
+CASREDUCTION.deps     := CASEXPR CASPOLY
 
 CLI.deps   := NBRS             \
               CASNUMBER        \
               CASREDUCTION     \
+              CASPOLY          \
               CASEXPR          \
               PARSERS          \
               CASRENDERING
@@ -22,6 +27,7 @@ CLI.deps   := NBRS             \
 IFACE.deps := NBRS             \
               CASNUMBER        \
               CASREDUCTION     \
+              CASPOLY          \
               CASEXPR          \
               PARSERS          \
               CASRENDERING
@@ -2,6 +2,7 @@
 // Name        : CAS.cpp
 //============================================================================
 
+#include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <string>
@@ -9,6 +10,7 @@
 #include <map>
 #include <stdexcept>
 #include <cstdlib>
+#include <cmath>
 
 #include "Float.hpp"
 #include "Expression.hpp"
@@ -19,6 +21,7 @@
 #include "Renderer.hpp"
 #include "ASCIITree.hpp"
 #include "Basic.hpp"
+#include "Rules.hpp"
 #include "String.hpp"
 #include "CharMap.hpp"
 #include "scanner-builder.hpp"
@@ -26,16 +29,24 @@
 #include "tokenizer.hpp"
 #include "token.hpp"
 #include "NumberFactory.hpp"
-#include "NumberFactoryPrototype.hpp"
+#include "NumberFactoryStatic.hpp"
 #include "NumberFormatter.hpp"
 #include "NumberFormatterStandard.hpp"
 #include "NumberProxy.hpp"
 #include "NumberDouble.hpp"
 #include "Standard.hpp"
+#include "Folding.hpp"
+#include "Region.hpp"
 #include "parser.hpp"
 #include "infix-parser.hpp"
+#include "postfix-parser.hpp"
 #include "InfixRender.hpp"
 #include "NumEval.hpp"
+#include "ParallelEval.hpp"
+#include "TaskPool.hpp"
+#include "Bytecode.hpp"
+#include "Batch.hpp"
+#include "Conversion.hpp"
 
 using namespace castle;
 
@@ -49,7 +60,11 @@ using namespace DS::CAS::Expressions::Visitors::Restructurers::Reduction;
 
 template<typename T>
 void reduce(ExprConstSP&);
+void simplify(ExprConstSP&, bool saturate, Restructurers::SaturationReport&);
 ostream& operator<< (ostream& out, ExprConstSP);
+void tabulate(const std::string& symbol, const Polynomials::Dense<Polynomials::Integer>& numerator,
+              const Polynomials::Integer& denominator, double from, double to, unsigned int count);
+bool tabulate(ExprConstSP exp, double from, double to, unsigned int count);
 
 //== CAS Machinery =====================================================
 
@@ -60,9 +75,12 @@ typedef CAS::Numbers::NumberDouble<FloatType>     NumberImp;
 
 std::shared_ptr<scanner_builder>        scannerBuilder_ptr  (new scanner_builder);
 std::shared_ptr<tokenizer>              tokenizer_ptr       (new tokenizer);
-std::shared_ptr<NumberFactory>          nFactory_ptr        (new NumberFactoryPrototype(Proxy::NumberP(new NumberImp())));
+std::shared_ptr<NumberFactory>          nFactory_ptr        (new NumberFactoryStatic<NumberImp>());
 std::shared_ptr<NumberFormatter>        nFormatter_ptr      (new NumberFormatterStandard(nFactory_ptr, scannerBuilder_ptr, sigFigs));
 std::shared_ptr<Builder>                eBuilder_ptr        (new Builders::Standard);
+// The passes fold literal arithmetic as they build; the parser does not,
+// so the input is shown as it was written
+std::shared_ptr<Builder>                rBuilder_ptr        (new Builders::Folding(eBuilder_ptr));
 std::shared_ptr<Parser>                 parser_ptr          (new Parsers::Infix(scannerBuilder_ptr, eBuilder_ptr, nFormatter_ptr, tokenizer_ptr));
 
 int main()
@@ -89,8 +107,24 @@ int main()
 
     std::string expString = "";
 
+    // Each input is built in the region; only the result kept
+    // for _ is promoted out of it
+    Region region;
     ExprConstSP exp, previous;
     bool loop = false;
+    // "engine egraph" switches the main simplification loop to equality
+    // saturation, "engine passes" switches it back; saturation reports the
+    // last input simplified that way
+    bool saturate = false;
+    Restructurers::SaturationReport saturation;
+    // Nodes the last numeric evaluation computed, and those it took
+    // from an equal subtree already computed
+    size_t evaluated = 0, evaluationsSaved = 0;
+    // "threads n" evaluates numerically on n threads, through the pool;
+    // parallel is declared first so that it is destroyed after the pool
+    // has joined its threads
+    std::unique_ptr<ParallelEval<NumberImp> > parallel;
+    std::unique_ptr<TaskPool> pool;
     do
     {
         //== Input ==============================================================
@@ -115,10 +149,168 @@ int main()
             std::system("clear");
             continue;
         }
+        if (expString == "stats")
+        {
+            const Proxy::NumberP::Counters& counters = Proxy::NumberP::counters();
+            cout << "  number payloads: " << counters.heap     << " heap, "
+                                          << counters.inlined  << " inline, "
+                                          << counters.shared   << " shared, "
+                                          << counters.unshared << " unshared" << endl;
+            Restructurers::RuleSet::reportAll(cout);
+            cout << "  numeric evaluation: " << evaluated << " nodes evaluated, "
+                 << evaluationsSaved << " saved by sharing subtrees";
+            if (pool)
+                cout << ", " << parallel->tasksSpawned() << " tasks on "
+                     << pool->numberOfThreads() << " threads";
+            cout << endl;
+            if (saturation.iterations)
+                cout << "  egraph: " << saturation.iterations << " iterations, "
+                     << saturation.nodes << " nodes, " << saturation.classes << " classes, "
+                     << (saturation.saturated ? "saturated" : "stopped at a limit") << ", "
+                     << saturation.milliseconds << " ms" << endl;
+            continue;
+        }
+        if (expString == "engine egraph" || expString == "engine passes")
+        {
+            saturate = (expString == "engine egraph");
+            continue;
+        }
+        if (expString.compare(0, 8, "threads ") == 0)
+        {
+            unsigned int count;
+            istringstream arguments(expString.substr(8));
+            if (!(arguments >> count) || count == 0)
+                cout << "  usage: threads <count>" << endl;
+            else
+            {
+                parallel.reset();
+                pool.reset();
+                if (count > 1)
+                {
+                    pool.reset(new TaskPool(count));
+                    parallel.reset(new ParallelEval<NumberImp>(*pool));
+                }
+            }
+            continue;
+        }
+        // "table a b n" tabulates _, a real expression in one symbol, at
+        // n points evenly spaced from a to b
+        if (expString.compare(0, 6, "table ") == 0)
+        {
+            double from, to;
+            unsigned int count;
+            ExprConstSP symbol;
+            Polynomials::Dense<Polynomials::Integer> numerator;
+            Polynomials::Integer denominator;
+            istringstream arguments(expString.substr(6));
+            if (!(arguments >> from >> to >> count) || count == 0)
+                cout << "  usage: table <from> <to> <count>" << endl;
+            else if (previous && Polynomials::readUnivariate(previous, symbol, numerator, denominator))
+                tabulate(static_cast<const Symbol&>(*symbol).getName(), numerator, denominator, from, to, count);
+            else if (!previous || !tabulate(previous, from, to, count))
+                cout << "  _ is not a real expression in one symbol" << endl;
+            continue;
+        }
+        // "sweep x=1,2,3 y=a,b,c" substitutes the first value of each
+        // symbol into _, then the second, and so on, and simplifies each
+        if (expString.compare(0, 6, "sweep ") == 0)
+        {
+            std::vector<Restructurers::BulkSubstitution::Bindings> sets;
+            bool valid = (previous != nullptr);
+            istringstream arguments(expString.substr(6));
+            std::string binding;
+            // The first binding decides how many sets there are; every
+            // other one must give exactly that many values
+            bool first = true;
+            while (valid && arguments >> binding)
+            {
+                std::string::size_type equals = binding.find('=');
+                if (equals == 0 || equals == std::string::npos)
+                {
+                    valid = false;
+                    break;
+                }
+                Atom symbol(binding.substr(0, equals));
+                istringstream values(binding.substr(equals + 1));
+                std::string value;
+                unsigned int i = 0;
+                for (; std::getline(values, value, ','); i++)
+                {
+                    ExprConstSP parsed = parser_ptr->parse(value);
+                    if (!parsed)
+                    {
+                        valid = false;
+                        break;
+                    }
+                    if (first)
+                        sets.emplace_back();
+                    else if (i == sets.size())
+                    {
+                        valid = false;
+                        break;
+                    }
+                    sets[i][symbol] = parsed;
+                }
+                if (i != sets.size())
+                    valid = false;
+                first = false;
+            }
+            if (!valid || sets.empty())
+            {
+                cout << "  usage: sweep <symbol>=<value>,<value>,... ..., substituting into _" << endl;
+                continue;
+            }
+            Restructurers::BulkSubstitution sweep(eBuilder_ptr, previous);
+            std::vector<ExprConstSP> results = sweep.apply(sets,
+                [&](ExprConstSP e) { simplify(e, saturate, saturation); return e; });
+            for (const ExprConstSP& result : results)
+            {
+                Render::Infixs::String s(nFormatter_ptr);
+                s.visitExpression(result);
+                cout << "  " << s.result() << endl;
+            }
+            continue;
+        }
+        // "postfix file" reads expressions in postfix, one to a line, from
+        // the file and keeps the last one as _
+        if (expString.compare(0, 8, "postfix ") == 0)
+        {
+            std::ifstream file(expString.substr(8), std::ios::binary);
+            if (!file)
+            {
+                cout << "  cannot open " << expString.substr(8) << endl;
+                continue;
+            }
+            Parsers::Postfix postfix(scannerBuilder_ptr, eBuilder_ptr, nFormatter_ptr, tokenizer_ptr);
+            ExprConstSP last;
+            bool success = postfix.read(file, [&](ExprConstSP e) { last = e; });
+            const Parsers::Postfix::ReadStatistics& statistics = postfix.getReadStatistics();
+            if (!success)
+                cout << "  syntax error on line " << statistics.line << endl;
+            cout << "  " << statistics.expressions << " expressions, " << statistics.tokens << " tokens in "
+                 << statistics.seconds << " s (" << statistics.tokensPerSecond() << " tokens/s)" << endl;
+            if (last)
+                previous = last;
+            continue;
+        }
+        }
+
+        // "egraph: e" or "passes: e" simplifies e with that engine, whatever
+        // the session uses.  The prefix is blanked rather than cut, so that
+        // the syntax error marker still lines up with the input
+        bool saturateThis = saturate;
+        if (expString.compare(0, 7, "egraph:") == 0 || expString.compare(0, 7, "passes:") == 0)
+        {
+            saturateThis = (expString[0] == 'e');
+            expString.replace(0, 7, 7, ' ');
         }
 
         //== Parsing ============================================================
 
+        exp.reset();
+        region.release();
+        Region::Scope scope(&region);
+
         exp = parser_ptr->parse(expString);
         if (!exp)
         {
@@ -133,7 +325,7 @@ int main()
 
         if (previous)
         {
-            std::map<std::string, ExprConstSP> dictionary;
+            Restructurers::Substitution::Dictionary dictionary;
             dictionary["_"] = previous;
             Restructurers::Substitution prevSub(nFactory_ptr, eBuilder_ptr, dictionary);
             prevSub.visitExpression(exp);
@@ -146,66 +338,21 @@ int main()
 
         //== Reduction ==========================================================
 
-        reduce<BasicSymbols>(exp);
-        reduce<ComplexSplitter>(exp);
-        reduce<Rationalizer>(exp);
-
-        for (int k = 0; k < 20; k++)
-        {
-            //cout << endl;
-            reduce<ComplexNormalizer>(exp);
-            //cout << exp << endl << "____________________________________________________________________1";
-            reduce<GCDLiteral>(exp);
-            //cout << exp << endl << "____________________________________________________________________2";
-            reduce<SizeOneArray>(exp);
-            reduce<SelfNesting>(exp);
-            reduce<Negatives>(exp);
-            //cout << exp << endl << "____________________________________________________________________3";
-            reduce<FirstOrderBasic>(exp);
-            //cout << exp << endl << "____________________________________________________________________4";
-            reduce<NumberReducerBasic>(exp);
-            //cout << exp << endl << "____________________________________________________________________5";
-        }
-
-        reduce<ComplexExpander>(exp);
-        reduce<ComplexSplitter>(exp);
-        reduce<ComplexNormalizer>(exp);
-        reduce<GCDLiteral>(exp);
-        reduce<SizeOneArray>(exp);
-        reduce<SelfNesting>(exp);
-        reduce<Negatives>(exp);
+        simplify(exp, saturateThis, saturation);
 
         //== Post Processing ====================================================
 
-        previous = exp;
+        previous = promote(exp, *eBuilder_ptr);
 
         //== Post Rendering =====================================================
 
         if (1) {
         cout << endl;
         Render::Infixs::CharMap map(nFormatter_ptr);
-        Render::ASCIITree logger(nFormatter_ptr);
         map.visitExpression(exp);
-        logger.visitExpression(exp);
         std::vector<std::string> strings = map.result().vectorOfStrings();
         for (std::vector<std::string>::const_iterator it = strings.begin(); it != strings.end(); ++it)
             cout << endl << setw(columns) << *it;
-        /*
-        cout << endl;
-        strings = logger.result();
-        unsigned int maxLength = 0;
-        for (std::vector<std::string>::iterator it = strings.begin(); it != strings.end(); ++it)
-            if (it->length() > maxLength)
-                maxLength = it->length();
-        for (std::vector<std::string>::iterator it = strings.begin(); it != strings.end(); ++it)
-        {
-            ostringstream o;
-            o << *it;
-            for (unsigned int i = 0; i < maxLength-it->length(); i++)
-                o << " ";
-            cout << endl << setw(120) << o.str();
-        }
-        */
         //cout << endl << endl;
         //Render::Infixs::String infixString(nFormatter_ptr);
         //infixString.visitExpression(exp);
@@ -220,10 +367,12 @@ int main()
         //}
         //ExprConstSP constantsExp = constantsSub.result();
 
-        NumEval eval;
-        if (eval.visitExpression(exp))
+        NumEvalStatic<NumberImp> eval(true);
+        if (pool ? parallel->evaluate(exp) : eval.visitExpression(exp))
         {
-            Proxy::NumberP result = eval.result();
+            evaluated = pool ? parallel->evaluations() : eval.evaluations();
+            evaluationsSaved = pool ? parallel->evaluationsSaved() : eval.evaluationsSaved();
+            Proxy::NumberP result = pool ? parallel->result() : eval.result();
             if (!(result.isRealPartInteger() && result.isImaginaryPartInteger()))
             {
                 cout << endl << endl;
@@ -314,10 +463,106 @@ ostream& operator<< (ostream& out, ExprConstSP exp)
 template<typename T>
 void reduce(ExprConstSP& exp)
 {
-    T* visitor = new T(nFactory_ptr, eBuilder_ptr);
+    T* visitor = new T(nFactory_ptr, rBuilder_ptr);
     bool success = visitor->visitExpression(exp);
     if (!success)
         throw std::logic_error("success == false in reduce()");
     exp = visitor->result();
     delete visitor;
 }
+
+void simplify(ExprConstSP& exp, bool saturate, Restructurers::SaturationReport& saturation)
+{
+    reduce<BasicSymbols>(exp);
+    reduce<ComplexSplitter>(exp);
+    reduce<Rationalizer>(exp);
+    reduce<Expand>(exp);
+    reduce<Cancel>(exp);
+
+    if (saturate)
+    {
+        SaturatingSimplifier simplifier(nFactory_ptr, rBuilder_ptr);
+        exp = simplifier.run(exp);
+        saturation = simplifier.lastReport();
+    }
+    else
+    {
+        for (int k = 0; k < 20; k++)
+        {
+            ExprConstSP before = exp;
+            reduce<Simplifier>(exp);
+            if (exp == before) // nothing was rewritten, so nothing will be
+                break;
+        }
+    }
+
+    reduce<ComplexExpander>(exp);
+    reduce<ComplexSplitter>(exp);
+    reduce<ComplexNormalizer>(exp);
+    reduce<GCDLiteral>(exp);
+    reduce<SizeOneArray>(exp);
+    reduce<SelfNesting>(exp);
+    reduce<Negatives>(exp);
+}
+
+void tabulate(const std::string& symbol, const Polynomials::Dense<Polynomials::Integer>& numerator,
+              const Polynomials::Integer& denominator, double from, double to, unsigned int count)
+{
+    std::vector<FloatType> coefficients;
+    for (const Polynomials::Integer& coefficient : numerator.getCoefficients())
+        coefficients.push_back(FloatType(coefficient));
+    Polynomials::Dense<FloatType> polynomial(coefficients);
+
+    std::vector<FloatType> points;
+    double step = (count > 1) ? (to - from)/(count - 1) : 0;
+    for (unsigned int i = 0; i < count; i++)
+        points.push_back(FloatType(from + step*i));
+
+    std::vector<FloatType> values = polynomial.evaluate(points);
+    FloatType divisor(denominator);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        values[i] /= divisor;
+        cout << "  " << symbol << " = " << nFormatter_ptr->formatRealPart(NumberImp(points[i]))
+             << "  ->  " << nFormatter_ptr->formatRealPart(NumberImp(values[i])) << endl;
+    }
+}
+
+// Anything other than a polynomial is compiled and run at each point
+bool tabulate(ExprConstSP exp, double from, double to, unsigned int count)
+{
+    Bytecode::Compiler compiler;
+    if (!compiler.visitExpression(exp))
+        return false;
+    Bytecode::Program program = compiler.result();
+    if (program.getVariables().size() != 1)
+        return false;
+
+    // The points go through the batch evaluator in double; any at which
+    // _ is not real come back with an imaginary part
+    std::vector<double> points, real(count), imaginary(count);
+    double step = (count > 1) ? (to - from)/(count - 1) : 0;
+    for (unsigned int i = 0; i < count; i++)
+        points.push_back(from + step*i);
+
+    Bytecode::Batch batch(program);
+    batch.run(std::vector<const double*>(1, points.data()), count, real.data(), imaginary.data());
+    // The values are good to about the precision of a double, and are
+    // shown to that
+    const std::string& symbol = program.getVariables()[0].name();
+    ostringstream line;
+    line << setprecision(15);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        line.str("");
+        line << "  " << symbol << " = " << points[i] << "  ->  ";
+        if (!std::isfinite(real[i]) || !std::isfinite(imaginary[i]))
+            line << "undefined";
+        else if (imaginary[i] == 0)
+            line << real[i];
+        else
+            line << real[i] << ((imaginary[i] < 0) ? " - " : " + ") << std::fabs(imaginary[i]) << "i";
+        cout << line.str() << endl;
+    }
+    return true;
+}
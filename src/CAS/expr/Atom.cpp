@@ -0,0 +1,46 @@
+#include <deque>
+#include <unordered_map>
+
+#include "Atom.hpp"
+
+namespace DS          {
+namespace CAS         {
+namespace Expressions {
+
+namespace {
+
+struct Table
+{
+    // A deque, so the views in the index stay valid as it grows
+    std::deque<std::string> names;
+    std::unordered_map<std::string_view, unsigned int> index;
+};
+
+Table& table(void)
+{
+    static Table instance;
+    return instance;
+}
+
+} // namespace
+
+unsigned int Atom::intern(std::string_view name)
+{
+    Table& t = table();
+    auto it = t.index.find(name);
+    if (it != t.index.end())
+        return it->second;
+    unsigned int id = static_cast<unsigned int>(t.names.size());
+    t.names.emplace_back(name);
+    t.index.emplace(t.names.back(), id);
+    return id;
+}
+
+const std::string& Atom::name(void) const
+{
+    return table().names[index];
+}
+
+} /* namespace Expressions */
+} /* namespace CAS */
+} /* namespace DS */
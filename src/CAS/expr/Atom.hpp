@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace DS          {
+namespace CAS         {
+namespace Expressions {
+
+/**********************************************************
+ *                          Atom
+ *
+ * An interned symbol name.  Each distinct name is stored
+ * once, in a table for the whole program, and an atom is
+ * its index there, so atoms are one word and compare and
+ * hash as integers.  Making an atom from a name looks it up
+ * (adding it the first time); the table is not locked, so
+ * names must not be interned on two threads at once.
+ **********************************************************/
+class Atom
+{
+public:
+    Atom(const std::string& _name) : index(intern(_name)) {}
+    Atom(const char* _name) : index(intern(_name)) {}
+
+    const std::string& name(void) const;
+    unsigned int id(void) const { return index; }
+
+    bool operator== (Atom rhs) const { return index == rhs.index; }
+    bool operator!= (Atom rhs) const { return index != rhs.index; }
+
+    struct Hash
+    {
+        size_t operator()(Atom atom) const { return atom.index; }
+    };
+
+private:
+    static unsigned int intern(std::string_view);
+
+    unsigned int index;
+};
+
+} /* namespace Expressions */
+} /* namespace CAS */
+} /* namespace DS */
@@ -1,59 +1,77 @@
 #include <stdexcept>
 #include "Builder.hpp"
+#include "exprs.hpp"
 
 namespace DS {
 namespace CAS {
 namespace Expressions {
 
-ExprConstSP Builder::operator()(const std::string& name, const std::vector<ExprConstSP>& children) const
+namespace {
+
+enum class Operator { none, add, subtract, multiply, divide, modulus, negate, power, factorial };
+
+// The operator a name stands for, found by its length and characters
+// rather than by comparing it with each operator's string in turn
+Operator operatorOf(const std::string& name)
 {
-    if (name == "+")
-    {
-        if (children.size() == 0)
-            throw std::invalid_argument(name + ": children.size() invalid in DS::CAS::Expressions::Builders::Builder::operator()");
-        return add(children);
-    }
-    if (name == "-")
-    {
-        if (children.size() != 2)
-            throw std::invalid_argument(name + ": children.size() invalid in DS::CAS::Expressions::Builders::Builder::operator()");
-        return subtract(children[0], children[1]);
-    }
-    if (name == "*")
+    if (name.size() == 1)
     {
-        if (children.size() == 0)
-            throw std::invalid_argument(name + ": children.size() invalid in DS::CAS::Expressions::Builders::Builder::operator()");
-        return multiply(children);
+        switch (name[0])
+        {
+            case '+': return Operator::add;
+            case '-': return Operator::subtract;
+            case '*': return Operator::multiply;
+            case '/': return Operator::divide;
+            case '%': return Operator::modulus;
+            case '^': return Operator::power;
+            case '!': return Operator::factorial;
+        }
     }
-    if (name == "/")
-    {
-        if (children.size() != 2)
-            throw std::invalid_argument(name + ": children.size() invalid in DS::CAS::Expressions::Builders::Builder::operator()");
-        return divide(children[0], children[1]);
-    }
-    if (name == "%")
-    {
-        if (children.size() != 2)
-            throw std::invalid_argument(name + ": children.size() invalid in DS::CAS::Expressions::Builders::Builder::operator()");
-        return modulus(children[0], children[1]);
-    }
-    if (name == "ng")
-    {
-        if (children.size() != 1)
-            throw std::invalid_argument(name + ": children.size() invalid in DS::CAS::Expressions::Builders::Builder::operator()");
-        return negate(children[0]);
-    }
-    if (name == "^")
-    {
-        if (children.size() != 2)
-            throw std::invalid_argument(name + ": children.size() invalid in DS::CAS::Expressions::Builders::Builder::operator()");
-        return power(children[0], children[1]);
-    }
-    if (name == "!")
+    else if (name.size() == 2 && name[0] == 'n' && name[1] == 'g')
+        return Operator::negate;
+    return Operator::none;
+}
+
+void checkChildren(bool valid, const std::string& name)
+{
+    if (!valid)
+        throw std::invalid_argument(name + ": children.size() invalid in DS::CAS::Expressions::Builders::Builder::operator()");
+}
+
+} // namespace
+
+// Operators by name, as the postfix parser reads them, and otherwise a
+// symbol; code that knows the kind of node calls the typed methods
+ExprConstSP Builder::operator()(const std::string& name, const std::vector<ExprConstSP>& children) const
+{
+    switch (operatorOf(name))
     {
-        if (children.size() != 1)
-            throw std::invalid_argument(name + ": children.size() invalid in DS::CAS::Expressions::Builders::Builder::operator()");
-        return factorial(children[0]);
+        case Operator::add:
+            checkChildren(children.size() != 0, name);
+            return add(children);
+        case Operator::subtract:
+            checkChildren(children.size() == 2, name);
+            return subtract(children[0], children[1]);
+        case Operator::multiply:
+            checkChildren(children.size() != 0, name);
+            return multiply(children);
+        case Operator::divide:
+            checkChildren(children.size() == 2, name);
+            return divide(children[0], children[1]);
+        case Operator::modulus:
+            checkChildren(children.size() == 2, name);
+            return modulus(children[0], children[1]);
+        case Operator::negate:
+            checkChildren(children.size() == 1, name);
+            return negate(children[0]);
+        case Operator::power:
+            checkChildren(children.size() == 2, name);
+            return power(children[0], children[1]);
+        case Operator::factorial:
+            checkChildren(children.size() == 1, name);
+            return factorial(children[0]);
+        case Operator::none:
+            break;
     }
     if (name == "")
         throw std::invalid_argument("name == empty in DS::CAS::Expressions::Builders::Builder::operator()");
@@ -78,6 +96,22 @@ ExprConstSP Builder::operator()(const std::string& name, ExprConstSP ptr1, ExprC
     children[1] = ptr2;
     return (*this)(name, children);
 }
+ExprConstSP Builder::rebuild(const Expr& exp, const std::vector<ExprConstSP>& children) const
+{
+    switch (exp.id())
+    {
+        case ID::add:       return add(children, static_cast<const Add&>(exp).getSigns());
+        case ID::divide:    return divide(children[0], children[1]);
+        case ID::factorial: return factorial(children[0]);
+        case ID::literal:   return literal(static_cast<const Literal&>(exp).getNumber());
+        case ID::modulus:   return modulus(children[0], children[1]);
+        case ID::multiply:  return multiply(children);
+        case ID::negate:    return negate(children[0]);
+        case ID::power:     return power(children[0], children[1]);
+        case ID::symbol:    return symbol(static_cast<const Symbol&>(exp).getAtom(), children);
+    }
+    throw std::logic_error("unknown expression id in Builder::rebuild()");
+}
 
 
 } /* namespace Expressions */
@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 #include "Expression.hpp"
+#include "Atom.hpp"
 
 namespace DS {
 namespace CAS {
@@ -27,11 +28,12 @@ public:
     virtual ExprConstSP operator()(const std::string& name, ExprConstSP ptr) const;
     virtual ExprConstSP operator()(const std::string& name, ExprConstSP ptr1, ExprConstSP ptr2) const;
 
-    virtual ExprConstSP symbol(const std::string&) const = 0;
-    virtual ExprConstSP symbol(const std::string&, ExprConstSP) const = 0;
-    virtual ExprConstSP symbol(const std::string&, ExprConstSP, ExprConstSP) const = 0;
-    virtual ExprConstSP symbol(const std::string&, const std::vector<ExprConstSP>&) const = 0;
+    virtual ExprConstSP symbol(Atom) const = 0;
+    virtual ExprConstSP symbol(Atom, ExprConstSP) const = 0;
+    virtual ExprConstSP symbol(Atom, ExprConstSP, ExprConstSP) const = 0;
+    virtual ExprConstSP symbol(Atom, const std::vector<ExprConstSP>&) const = 0;
     virtual ExprConstSP literal(Numbers::Number*) const = 0;
+    virtual ExprConstSP literal(Numbers::Number*, unsigned int decimalPlaces) const = 0;
     virtual ExprConstSP literal(const Numbers::Number&) const = 0;
     virtual ExprConstSP add(ExprConstSP, ExprConstSP) const = 0;
     virtual ExprConstSP add(const std::vector<ExprConstSP>&) const = 0;
@@ -44,6 +46,10 @@ public:
     virtual ExprConstSP modulus(ExprConstSP top, ExprConstSP bottom) const = 0;
     virtual ExprConstSP power(ExprConstSP base, ExprConstSP power) const = 0;
     virtual ExprConstSP factorial(ExprConstSP) const = 0;
+
+    // A node of the same kind (and signs, number or name) as exp
+    // over the given children
+    ExprConstSP rebuild(const Expr& exp, const std::vector<ExprConstSP>& children) const;
 };
 
 } /* namespace Expressions */
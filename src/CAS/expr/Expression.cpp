@@ -1,4 +1,9 @@
 #include "Expression.hpp"
+#include "Region.hpp"
+#include "exprs.hpp"
+
+#include <stdexcept>
+#include <vector>
 
 namespace DS          { 
 namespace CAS         {
@@ -6,7 +11,99 @@ namespace Expressions {
 
 int Expr::numberOfExpressions(0);
 
-Expr::Expr()  { numberOfExpressions++; }
-Expr::~Expr() { numberOfExpressions--; }
+Expr::Expr( ID _tag, std::initializer_list<ExprConstSP> children )
+    : tag( _tag ), references( 0 ), count( 0 ), region( Region::current() )
+{
+    initialize( children.begin(), children.end() );
+}
+
+Expr::Expr( ID _tag, std::vector<ExprConstSP> const& children )
+    : tag( _tag ), references( 0 ), count( 0 ), region( Region::current() )
+{
+    initialize( children.begin(), children.end() );
+}
+
+template<typename It>
+void Expr::initialize( It begin, It end )
+{
+    numberOfExpressions++;
+    if( region )
+        region->nodes++;
+    count = static_cast<unsigned int>( end - begin );
+    ExprConstSP* slot = childData();
+    for( ; begin != end; ++begin )
+        new ( slot++ ) ExprConstSP( *begin );
+}
+
+Expr::~Expr()
+{
+    ExprConstSP* children = childData();
+    for( unsigned int i = 0; i < count; i++ )
+        children[i].~ExprConstSP();
+    numberOfExpressions--;
+    if( region )
+        region->nodes--;
+}
+
+std::pmr::memory_resource* Expr::resource() const
+{
+    return resourceFor( region );
+}
+
+Region* Expr::currentRegion()
+{
+    return Region::current();
+}
+
+std::pmr::memory_resource* Expr::resourceFor( Region* region )
+{
+    if( region )
+        return &region->arena;
+    return std::pmr::new_delete_resource();
+}
+
+namespace {
+
+// Nodes whose last reference went away while another node was
+// being destroyed on this thread; see Expr::destroy
+thread_local std::vector<Expr const*> doomed;
+thread_local bool destroying = false;
+
+} // namespace
+
+void Expr::destroyNode( Expr const* exp )
+{
+    switch( exp->tag ) {
+        case ID::add:       destroyAs<Add>( exp );       return;
+        case ID::divide:    destroyAs<Divide>( exp );    return;
+        case ID::factorial: destroyAs<Factorial>( exp ); return;
+        case ID::literal:   destroyAs<Literal>( exp );   return;
+        case ID::modulus:   destroyAs<Modulus>( exp );   return;
+        case ID::multiply:  destroyAs<Multiply>( exp );  return;
+        case ID::negate:    destroyAs<Negate>( exp );    return;
+        case ID::power:     destroyAs<Power>( exp );     return;
+        case ID::symbol:    destroyAs<Symbol>( exp );    return;
+    }
+}
+
+// Destroying a node releases its children, which may in turn
+// have to be destroyed.  Rather than recursing (and running out
+// of stack on very deep trees) those are queued and destroyed
+// by the outermost call.
+void Expr::destroy( Expr const* exp )
+{
+    if( destroying ) {
+        doomed.push_back( exp );
+        return;
+    }
+    destroying = true;
+    destroyNode( exp );
+    while( !doomed.empty() ) {
+        Expr const* next = doomed.back();
+        doomed.pop_back();
+        destroyNode( next );
+    }
+    destroying = false;
+}
 
 } } }
@@ -2,7 +2,13 @@
 
 #include "macros.hpp"
 
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
 #include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
 #include <vector>
 
 namespace DS          {
@@ -11,44 +17,199 @@ namespace Expressions {
 
 enum class Sign { p = true, n = false };
 
-enum class ID {
+enum class ID : std::uint8_t {
     add,      divide, factorial, literal, modulus,
     multiply, negate, power,     symbol
 };
 
 class Visitor;
+class Region;
+class Expr;
+
+/**********************************************************
+ * Owning pointer to a node.  Nodes carry their own (non-
+ * atomic) reference count, so a copy is a plain increment
+ * and a raw node pointer can always be turned back into an
+ * owning one.
+ **********************************************************/
+template<typename T>
+class ExprPtr {
 
-DECLARE_SHARED( Expr )
+public:
+    ExprPtr() : ptr( nullptr ) {}
+    ExprPtr( std::nullptr_t ) : ptr( nullptr ) {}
+    explicit ExprPtr( T* p ) : ptr( p ) { acquire(); }
+
+    ExprPtr( ExprPtr const& rhs ) : ptr( rhs.ptr ) { acquire(); }
+    ExprPtr( ExprPtr&& rhs ) noexcept : ptr( rhs.ptr ) { rhs.ptr = nullptr; }
+
+    template<typename U>
+    ExprPtr( ExprPtr<U> const& rhs ) : ptr( rhs.get() ) { acquire(); }
+
+    ~ExprPtr() { release(); }
+
+    ExprPtr& operator=( ExprPtr rhs ) {
+        std::swap( ptr, rhs.ptr );
+        return *this;
+    }
+
+    void reset() { ExprPtr().swap( *this ); }
+    void swap( ExprPtr& rhs ) { std::swap( ptr, rhs.ptr ); }
+
+    T* get()        const { return ptr;  }
+    T& operator*()  const { return *ptr; }
+    T* operator->() const { return ptr;  }
 
+    explicit operator bool() const { return ptr != nullptr; }
+
+    bool operator==( ExprPtr const& rhs ) const { return ptr == rhs.ptr; }
+    bool operator!=( ExprPtr const& rhs ) const { return ptr != rhs.ptr; }
+
+private:
+    void acquire();
+    void release();
+
+    T* ptr;
+};
+
+typedef ExprPtr<Expr>       ExprSP;
+typedef ExprPtr<Expr const> ExprConstSP;
+
+/**********************************************************
+ * Base of all nodes.  There is no vtable: the kind of node
+ * is the one byte tag returned by id(), and code that needs
+ * the concrete type switches on it.  A node and its children
+ * share one allocation, with the children stored just in
+ * front of the node, so nodes are only ever built through
+ * Expr::create (normally by a Builder).
+ **********************************************************/
 class Expr {
 
 public:
-    Expr();
-    Expr(std::vector<ExprConstSP> children) : children( children ) {}
-    virtual ~Expr();
+    // A view of a node's children
+    class Children {
+    public:
+        Children( ExprConstSP const* _begin, size_t _size ) : first( _begin ), count( _size ) {}
+        ExprConstSP const* begin() const { return first; }
+        ExprConstSP const* end()   const { return first + count; }
+        size_t size() const { return count; }
+        ExprConstSP const& operator[]( size_t i ) const { return first[i]; }
+    private:
+        ExprConstSP const* first;
+        size_t count;
+    };
 
     Expr(Expr const&)                   = delete;
     Expr const& operator= (Expr const&) = delete;
 
-    virtual ID id(void) const = 0;
+    ID id(void) const { return tag; }
 
-    size_t numberOfChildren(void) const { return children.size(); }
+    size_t numberOfChildren(void) const { return count; }
 
-    ExprConstSP getChild(size_t i) const {
-        ASSERT( i < children.size() );
-        return children[i];
+    ExprConstSP const& getChild(size_t i) const {
+        ASSERT( i < count );
+        return childData()[i];
     }
 
-    virtual bool acceptVisitor(Visitor&) const = 0;
-
-    std::vector<ExprConstSP> const& getChildVector() const {
-        return children;
+    Children getChildren() const {
+        return Children( childData(), count );
     }
 
+    bool inRegion() const { return region != nullptr; }
+
+    // Allocates, from the current Region, room for a T with
+    // the given number of children and constructs it there
+    template<typename T, typename... Args>
+    static ExprConstSP create( size_t children, Args&&... args );
+
     static int numberOfExpressions;
 
 protected:
-    std::vector<ExprConstSP> children;
+    // The children are copied into the slots reserved by create
+    Expr( ID _tag, std::initializer_list<ExprConstSP> children );
+    Expr( ID _tag, std::vector<ExprConstSP> const& children );
+    ~Expr();
+
+    // Where this node's memory (and any extra storage a node
+    // type allocates) comes from
+    std::pmr::memory_resource* resource() const;
+
+private:
+    template<typename> friend class ExprPtr;
+
+    ExprConstSP const* childData() const {
+        return reinterpret_cast<ExprConstSP const*>( this ) - count;
+    }
+    ExprConstSP* childData() {
+        return reinterpret_cast<ExprConstSP*>( this ) - count;
+    }
+
+    template<typename It>
+    void initialize( It begin, It end );
+
+    // The children go in front of the node, padded so that the
+    // node itself stays aligned
+    static size_t childSpace( size_t children, size_t align ) {
+        return ( children*sizeof( ExprConstSP ) + align - 1 )/align*align;
+    }
+
+    static Region* currentRegion();
+    static std::pmr::memory_resource* resourceFor( Region* region );
+
+    template<typename T>
+    static void destroyAs( Expr const* exp );
+    static void destroyNode( Expr const* exp );
+    static void destroy( Expr const* exp );
+
+    ID                   tag;
+    mutable unsigned int references;
+    unsigned int         count;
+    Region*              region;
 };
 
+template<typename T, typename... Args>
+ExprConstSP Expr::create( size_t children, Args&&... args )
+{
+    std::pmr::memory_resource* resource = resourceFor( currentRegion() );
+    size_t space = childSpace( children, alignof( T ) );
+    size_t size  = space + sizeof( T );
+    char* memory = static_cast<char*>( resource->allocate( size, alignof( T ) ) );
+    T* node;
+    try {
+        node = new ( memory + space ) T( std::forward<Args>( args )... );
+    }
+    catch( ... ) {
+        resource->deallocate( memory, size, alignof( T ) );
+        throw;
+    }
+    ASSERT( node->count == children );
+    return ExprConstSP( node );
+}
+
+template<typename T>
+void Expr::destroyAs( Expr const* exp )
+{
+    T const* node = static_cast<T const*>( exp );
+    std::pmr::memory_resource* resource = resourceFor( node->region );
+    size_t space = childSpace( node->count, alignof( T ) );
+    char* memory = reinterpret_cast<char*>( const_cast<T*>( node ) ) - space;
+    node->~T();
+    resource->deallocate( memory, space + sizeof( T ), alignof( T ) );
+}
+
+template<typename T>
+void ExprPtr<T>::acquire()
+{
+    if( ptr )
+        ++ptr->references;
+}
+
+template<typename T>
+void ExprPtr<T>::release()
+{
+    if( ptr && --ptr->references == 0 )
+        Expr::destroy( ptr );
+    ptr = nullptr;
+}
+
 } } }
@@ -0,0 +1,154 @@
+#include <stdexcept>
+#include "Folding.hpp"
+#include "Number.hpp"
+#include "exprs.hpp"
+
+namespace DS          {
+namespace CAS         {
+namespace Expressions {
+namespace Builders    {
+
+using Numbers::Proxy::NumberP;
+
+namespace {
+
+// The number of a literal with integer real and imaginary parts, or null
+const Numbers::Number* integer(const ExprConstSP& exp)
+{
+    if (exp->id() != ID::literal)
+        return nullptr;
+    const Numbers::Number& number = static_cast<const Literal&>(*exp).getNumber();
+    return number.isIntegral() ? &number : nullptr;
+}
+
+const Numbers::Number* realInteger(const ExprConstSP& exp)
+{
+    const Numbers::Number* number = integer(exp);
+    return (number && number->isReal()) ? number : nullptr;
+}
+
+} // namespace
+
+ExprConstSP Folding::symbol(Atom name) const
+{
+    return builder->symbol(name);
+}
+ExprConstSP Folding::symbol(Atom name, ExprConstSP child) const
+{
+    return builder->symbol(name, child);
+}
+ExprConstSP Folding::symbol(Atom name, ExprConstSP ptr1, ExprConstSP ptr2) const
+{
+    return builder->symbol(name, ptr1, ptr2);
+}
+ExprConstSP Folding::symbol(Atom name, const std::vector<ExprConstSP>& children) const
+{
+    return builder->symbol(name, children);
+}
+ExprConstSP Folding::literal(Numbers::Number* number) const
+{
+    return builder->literal(number);
+}
+ExprConstSP Folding::literal(Numbers::Number* number, unsigned int decimalPlaces) const
+{
+    return builder->literal(number, decimalPlaces);
+}
+ExprConstSP Folding::literal(const Numbers::Number& number) const
+{
+    return builder->literal(number);
+}
+ExprConstSP Folding::add(ExprConstSP ptr1, ExprConstSP ptr2) const
+{
+    return add(std::vector<ExprConstSP>{ ptr1, ptr2 }, std::vector<Sign>{ Sign::p, Sign::p });
+}
+ExprConstSP Folding::subtract(ExprConstSP ptr1, ExprConstSP ptr2) const
+{
+    return add(std::vector<ExprConstSP>{ ptr1, ptr2 }, std::vector<Sign>{ Sign::p, Sign::n });
+}
+ExprConstSP Folding::add(const std::vector<ExprConstSP>& children) const
+{
+    return add(children, std::vector<Sign>(children.size(), Sign::p));
+}
+ExprConstSP Folding::add(const std::vector<ExprConstSP>& children, const std::vector<Sign>& signs) const
+{
+    if (children.empty() || children.size() != signs.size())
+        return builder->add(children, signs);
+    for (const ExprConstSP& child : children)
+        if (!integer(child))
+            return builder->add(children, signs);
+    NumberP sum = *integer(children[0]);
+    if (signs[0] == Sign::n)
+        sum.negate();
+    for (unsigned int i = 1; i < children.size(); i++)
+    {
+        if (signs[i] == Sign::n)
+            sum.subtract(*integer(children[i]));
+        else
+            sum.add(*integer(children[i]));
+    }
+    if (sum.isComplex())
+        return builder->add(children, signs);
+    return builder->literal(sum);
+}
+ExprConstSP Folding::negate(ExprConstSP child) const
+{
+    return builder->negate(child);
+}
+ExprConstSP Folding::multiply(ExprConstSP ptr1, ExprConstSP ptr2) const
+{
+    return multiply(std::vector<ExprConstSP>{ ptr1, ptr2 });
+}
+ExprConstSP Folding::multiply(const std::vector<ExprConstSP>& children) const
+{
+    if (children.empty())
+        return builder->multiply(children);
+    for (const ExprConstSP& child : children)
+        if (!integer(child))
+            return builder->multiply(children);
+    NumberP product = *integer(children[0]);
+    for (unsigned int i = 1; i < children.size(); i++)
+        product.multiply(*integer(children[i]));
+    return builder->literal(product);
+}
+ExprConstSP Folding::divide(ExprConstSP top, ExprConstSP bottom) const
+{
+    const Numbers::Number* numerator   = realInteger(top);
+    const Numbers::Number* denominator = realInteger(bottom);
+    if (numerator && denominator && !denominator->isZero())
+    {
+        NumberP quotient = *numerator;
+        quotient.divideBy(*denominator);
+        quotient.roundUsingMode(Numbers::Number::RoundClosest);
+        NumberP check = quotient;
+        check.multiply(*denominator);
+        if (check.isEqualReals(*numerator))
+            return builder->literal(quotient);
+    }
+    return builder->divide(top, bottom);
+}
+ExprConstSP Folding::modulus(ExprConstSP top, ExprConstSP bottom) const
+{
+    return builder->modulus(top, bottom);
+}
+ExprConstSP Folding::power(ExprConstSP base, ExprConstSP power) const
+{
+    const Numbers::Number* number   = realInteger(base);
+    const Numbers::Number* exponent = realInteger(power);
+    if (number && exponent && !exponent->isNegativeReal())
+    {
+        NumberP result = *number;
+        result.raiseToPower(*exponent);
+        result.roundUsingMode(Numbers::Number::RoundClosest);
+        return builder->literal(result);
+    }
+    return builder->power(base, power);
+}
+ExprConstSP Folding::factorial(ExprConstSP child) const
+{
+    return builder->factorial(child);
+}
+
+} /* namespace Builders */
+} /* namespace Expressions */
+} /* namespace CAS */
+} /* namespace DS */
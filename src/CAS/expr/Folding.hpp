@@ -0,0 +1,55 @@
+#pragma once
+
+#include <memory>
+#include "Builder.hpp"
+
+namespace DS          {
+namespace CAS         {
+namespace Expressions {
+namespace Builders    {
+
+/****************************************************************************
+ * Builds through another builder, but evaluates exact arithmetic on
+ * literals as the nodes are made: sums (unless they have both real and
+ * imaginary parts, which no literal does), differences and products of
+ * integer literals, quotients of real integers that divide exactly and
+ * real integers raised to nonnegative integer powers become literals
+ * without a node for the operation ever being built.  Anything else is
+ * passed through unchanged.
+ *
+ * Negations are not folded: Negatives writes a negative number as the
+ * negation of a positive literal, for rendering.
+ ****************************************************************************/
+class Folding: public DS::CAS::Expressions::Builder
+{
+public:
+    explicit Folding(std::shared_ptr<Builder> _builder) : builder(_builder) {}
+    virtual ~Folding() {}
+
+    virtual ExprConstSP symbol(Atom) const;
+    virtual ExprConstSP symbol(Atom, ExprConstSP) const;
+    virtual ExprConstSP symbol(Atom, ExprConstSP, ExprConstSP) const;
+    virtual ExprConstSP symbol(Atom, const std::vector<ExprConstSP>&) const;
+    virtual ExprConstSP literal(Numbers::Number*) const;
+    virtual ExprConstSP literal(Numbers::Number*, unsigned int decimalPlaces) const;
+    virtual ExprConstSP literal(const Numbers::Number&) const;
+    virtual ExprConstSP add(ExprConstSP, ExprConstSP) const;
+    virtual ExprConstSP add(const std::vector<ExprConstSP>&) const;
+    virtual ExprConstSP add(const std::vector<ExprConstSP>&, const std::vector<Sign>&) const;
+    virtual ExprConstSP subtract(ExprConstSP, ExprConstSP) const;
+    virtual ExprConstSP negate(ExprConstSP) const;
+    virtual ExprConstSP multiply(ExprConstSP, ExprConstSP) const;
+    virtual ExprConstSP multiply(const std::vector<ExprConstSP>&) const;
+    virtual ExprConstSP divide(ExprConstSP top, ExprConstSP bottom) const;
+    virtual ExprConstSP modulus(ExprConstSP top, ExprConstSP bottom) const;
+    virtual ExprConstSP power(ExprConstSP base, ExprConstSP power) const;
+    virtual ExprConstSP factorial(ExprConstSP) const;
+
+private:
+    std::shared_ptr<Builder> builder;
+};
+
+} /* namespace Builders */
+} /* namespace Expressions */
+} /* namespace CAS */
+} /* namespace DS */
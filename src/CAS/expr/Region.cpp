@@ -0,0 +1,92 @@
+#include "Region.hpp"
+#include "Builder.hpp"
+#include "exprs.hpp"
+
+#include <iterator>
+#include <vector>
+
+namespace DS          {
+namespace CAS         {
+namespace Expressions {
+
+namespace {
+
+thread_local Region* currentRegion = nullptr;
+
+// Post-order walk over the regional part of the tree, with an
+// explicit stack so that deep trees can be promoted
+ExprConstSP copyOut( ExprConstSP const& exp, Builder const& builder )
+{
+    if( !exp->inRegion() )
+        return exp;
+
+    struct Frame { Expr const* node; unsigned int next; };
+    std::vector<Frame>       work{ Frame{ exp.get(), 0 } };
+    std::vector<ExprConstSP> copied;
+    std::vector<ExprConstSP> children;
+    while( !work.empty() ) {
+        Frame& top = work.back();
+        if( top.next < top.node->numberOfChildren() ) {
+            ExprConstSP const& child = top.node->getChild( top.next++ );
+            if( child->inRegion() )
+                work.push_back( Frame{ child.get(), 0 } );
+            else
+                copied.push_back( child );
+            continue;
+        }
+        Expr const& node = *top.node;
+        work.pop_back();
+        auto first = copied.end() - node.numberOfChildren();
+        children.assign( std::make_move_iterator( first ),
+                         std::make_move_iterator( copied.end() ) );
+        copied.erase( first, copied.end() );
+        copied.push_back( builder.rebuild( node, children ) );
+    }
+    return copied.back();
+}
+
+} // namespace
+
+Region::Region( size_t initialSize )
+    : arena( initialSize )
+    , nodes( 0 )
+{ }
+
+Region::~Region() { }
+
+void Region::release()
+{
+    ASSERT( nodes == 0 );
+    arena.release();
+}
+
+Region::Scope::Scope( Region* region )
+    : previous( currentRegion )
+{
+    currentRegion = region;
+}
+
+Region::Scope::~Scope()
+{
+    currentRegion = previous;
+}
+
+Region* Region::current()
+{
+    return currentRegion;
+}
+
+std::pmr::memory_resource* Region::resource()
+{
+    if( currentRegion )
+        return &currentRegion->arena;
+    return std::pmr::new_delete_resource();
+}
+
+ExprConstSP promote( ExprConstSP const& exp, Builder const& builder )
+{
+    Region::Scope heap( nullptr );
+    return copyOut( exp, builder );
+}
+
+} } }
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Expression.hpp"
+
+#include <memory_resource>
+
+namespace DS          {
+namespace CAS         {
+namespace Expressions {
+
+class Builder;
+
+/**********************************************************
+ * A bump allocated arena for expression nodes.  While a
+ * Region::Scope is alive, nodes built on this thread (along
+ * with their child arrays) are carved out of the region and
+ * freeing them costs nothing; the memory is reclaimed all at
+ * once by release().  Nodes must therefore not outlive the
+ * region they were built in: anything that has to survive
+ * it is copied out with promote().  Nodes built outside of
+ * any region must not point into one.
+ **********************************************************/
+class Region
+{
+public:
+    Region( size_t initialSize = 64*1024 );
+    ~Region();
+
+    Region( Region const& )             = delete;
+    Region const& operator=( Region const& ) = delete;
+
+    // Frees everything at once; all nodes must be gone by now
+    void release();
+
+    size_t liveNodes() const { return nodes; }
+
+    // Makes a region (or the heap, when given NULL) the
+    // source of new nodes for the lifetime of the Scope
+    class Scope
+    {
+    public:
+        Scope( Region* region );
+        ~Scope();
+
+        Scope( Scope const& )             = delete;
+        Scope const& operator=( Scope const& ) = delete;
+
+    private:
+        Region* previous;
+    };
+
+    static Region* current();
+
+    // Where nodes and child arrays come from right now
+    static std::pmr::memory_resource* resource();
+
+private:
+    friend class Expr;
+
+    std::pmr::monotonic_buffer_resource arena;
+    size_t nodes;
+};
+
+// Deep copies the parts of exp that live in a region onto
+// the heap, sharing any subtrees that are already there.
+ExprConstSP promote( ExprConstSP const& exp, Builder const& builder );
+
+} } }
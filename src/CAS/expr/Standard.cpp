@@ -17,92 +17,96 @@ Standard::~Standard() {
     // TODO Auto-generated destructor stub
 }
 
-ExprConstSP Standard::symbol(const std::string& name) const
+ExprConstSP Standard::symbol(Atom name) const
 {
-    return ExprConstSP(new Symbol(name));
+    return Expr::create<Symbol>(0, name);
 }
-ExprConstSP Standard::symbol(const std::string& name, ExprConstSP child) const
+ExprConstSP Standard::symbol(Atom name, ExprConstSP child) const
 {
     std::vector<ExprConstSP> children(1);
     children[0] = child;
-    return ExprConstSP(new Symbol(name, children));
+    return Expr::create<Symbol>(children.size(), name, children);
 }
-ExprConstSP Standard::symbol(const std::string& name, ExprConstSP ptr1, ExprConstSP ptr2) const
+ExprConstSP Standard::symbol(Atom name, ExprConstSP ptr1, ExprConstSP ptr2) const
 {
     std::vector<ExprConstSP> children(2);
     children[0] = ptr1;
     children[1] = ptr2;
-    return ExprConstSP(new Symbol(name, children));
+    return Expr::create<Symbol>(children.size(), name, children);
 }
-ExprConstSP Standard::symbol(const std::string& name, const std::vector<ExprConstSP>& children) const
+ExprConstSP Standard::symbol(Atom name, const std::vector<ExprConstSP>& children) const
 {
-    return ExprConstSP(new Symbol(name, children));
+    return Expr::create<Symbol>(children.size(), name, children);
 }
 ExprConstSP Standard::literal(Numbers::Number* number) const
 {
-    return ExprConstSP(new Literal(number));
+    return Expr::create<Literal>(0, number);
+}
+ExprConstSP Standard::literal(Numbers::Number* number, unsigned int decimalPlaces) const
+{
+    return Expr::create<Literal>(0, number, decimalPlaces);
 }
 ExprConstSP Standard::literal(const Numbers::Number& number) const
 {
-    return ExprConstSP(new Literal(number));
+    return Expr::create<Literal>(0, number);
 }
 ExprConstSP Standard::add(ExprConstSP ptr1, ExprConstSP ptr2) const
 {
     std::vector<Sign> signs(2);
     signs[0] = Sign::p;
     signs[1] = Sign::p;
-    return ExprConstSP(new Add({ ptr1, ptr2 }, signs));
+    return Expr::create<Add>(2, std::vector<ExprConstSP>{ ptr1, ptr2 }, signs);
 }
 ExprConstSP Standard::subtract(ExprConstSP ptr1, ExprConstSP ptr2) const
 {
     std::vector<Sign> signs(2);
     signs[0] = Sign::p;
     signs[1] = Sign::n;
-    return ExprConstSP(new Add( { ptr1, ptr2 }, signs));
+    return Expr::create<Add>(2, std::vector<ExprConstSP>{ ptr1, ptr2 }, signs);
 }
 ExprConstSP Standard::add(const std::vector<ExprConstSP>& children) const
 {
     std::vector<Sign> signs(children.size());
     for (unsigned int i = 0; i < children.size(); i++)
         signs[i] = Sign::p;
-    return ExprConstSP(new Add(children, signs));
+    return Expr::create<Add>(children.size(), children, signs);
 }
 ExprConstSP Standard::add(const std::vector<ExprConstSP>& children, const std::vector<Sign>& signs) const
 {
     if (children.size() != signs.size())
         throw std::invalid_argument("children.size() != signs.size() in Builders::Standard::addArray");
-    return ExprConstSP(new Add(children, signs));
+    return Expr::create<Add>(children.size(), children, signs);
 }
 ExprConstSP Standard::negate(ExprConstSP child) const
 {
-    return ExprConstSP(new Negate(child));
+    return Expr::create<Negate>(1, child);
 }
 ExprConstSP Standard::multiply(ExprConstSP ptr1, ExprConstSP ptr2) const
 {
     std::vector<ExprConstSP> children(2);
     children[0] = ptr1;
     children[1] = ptr2;
-    return ExprConstSP(new Multiply(children));
+    return Expr::create<Multiply>(children.size(), children);
 }
 ExprConstSP Standard::multiply(const std::vector<ExprConstSP>& children) const
 {
-    return ExprConstSP(new Multiply(children));
+    return Expr::create<Multiply>(children.size(), children);
 }
 ExprConstSP Standard::divide(ExprConstSP top, ExprConstSP bottom) const
 {
-    return ExprConstSP(new Divide(top, bottom));
+    return Expr::create<Divide>(2, top, bottom);
 }
 ExprConstSP Standard::modulus(ExprConstSP top, ExprConstSP bottom) const
 {
-    return ExprConstSP(new Modulus(top, bottom));
+    return Expr::create<Modulus>(2, top, bottom);
 }
 ExprConstSP Standard::power(ExprConstSP base, ExprConstSP power) const
 {
-    return ExprConstSP(new Power(base, power));
+    return Expr::create<Power>(2, base, power);
 }
 ExprConstSP Standard::factorial(ExprConstSP child) const
 {
-    return ExprConstSP(new Factorial(child));
+    return Expr::create<Factorial>(1, child);
 }
 
 } /* namespace Builders */
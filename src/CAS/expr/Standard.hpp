@@ -13,11 +13,12 @@ public:
     Standard();
     virtual ~Standard();
 
-    virtual ExprConstSP symbol(const std::string&) const;
-    virtual ExprConstSP symbol(const std::string&, ExprConstSP) const;
-    virtual ExprConstSP symbol(const std::string&, ExprConstSP, ExprConstSP) const;
-    virtual ExprConstSP symbol(const std::string&, const std::vector<ExprConstSP>&) const;
+    virtual ExprConstSP symbol(Atom) const;
+    virtual ExprConstSP symbol(Atom, ExprConstSP) const;
+    virtual ExprConstSP symbol(Atom, ExprConstSP, ExprConstSP) const;
+    virtual ExprConstSP symbol(Atom, const std::vector<ExprConstSP>&) const;
     virtual ExprConstSP literal(Numbers::Number*) const;
+    virtual ExprConstSP literal(Numbers::Number*, unsigned int decimalPlaces) const;
     virtual ExprConstSP literal(const Numbers::Number&) const;
     virtual ExprConstSP add(ExprConstSP, ExprConstSP) const;
     virtual ExprConstSP add(const std::vector<ExprConstSP>&) const;
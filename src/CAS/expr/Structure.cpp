@@ -0,0 +1,197 @@
+#include "Structure.hpp"
+#include "exprs.hpp"
+
+#include <functional>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace DS          {
+namespace CAS         {
+namespace Expressions {
+
+namespace {
+
+void combine( size_t& seed, size_t value )
+{
+    seed ^= value + 0x9e3779b97f4a7c15ull + ( seed << 6 ) + ( seed >> 2 );
+}
+
+int compareNumbers( Numbers::Number const& lhs, Numbers::Number const& rhs )
+{
+    if( lhs.isLessReals( rhs ) )        return -1;
+    if( rhs.isLessReals( lhs ) )        return  1;
+    if( lhs.isLessImaginaries( rhs ) )  return -1;
+    if( rhs.isLessImaginaries( lhs ) )  return  1;
+    return 0;
+}
+
+// Everything about two nodes but their children and signs,
+// which are left to the walk in structuralCompare
+int shallowCompare( Expr const& lhs, Expr const& rhs )
+{
+    if( lhs.id() != rhs.id() )
+        return lhs.id() < rhs.id() ? -1 : 1;
+    if( lhs.id() == ID::literal )
+        return compareNumbers( static_cast<Literal const&>( lhs ).getNumber(),
+                               static_cast<Literal const&>( rhs ).getNumber() );
+    if( lhs.id() == ID::symbol ) {
+        Symbol const& l = static_cast<Symbol const&>( lhs );
+        Symbol const& r = static_cast<Symbol const&>( rhs );
+        // Ordered by name, but equal names are equal atoms
+        if( l.getAtom() != r.getAtom() )
+            return l.getName() < r.getName() ? -1 : 1;
+    }
+    if( lhs.numberOfChildren() != rhs.numberOfChildren() )
+        return lhs.numberOfChildren() < rhs.numberOfChildren() ? -1 : 1;
+    return 0;
+}
+
+int compareSigns( Add const& lhs, Add const& rhs )
+{
+    for( size_t i = 0; i < lhs.numberOfChildren(); ++i ) {
+        Sign l = lhs.getSignForChild( i ), r = rhs.getSignForChild( i );
+        if( l != r )
+            return l == Sign::p ? -1 : 1;
+    }
+    return 0;
+}
+
+} // namespace
+
+size_t shallowHash( Expr const& exp )
+{
+    size_t seed = static_cast<size_t>( exp.id() );
+    combine( seed, exp.numberOfChildren() );
+    if( exp.id() == ID::literal )
+        combine( seed, static_cast<Literal const&>( exp ).getNumber().hash() );
+    else if( exp.id() == ID::symbol )
+        combine( seed, static_cast<Symbol const&>( exp ).getAtom().id() );
+    else if( exp.id() == ID::add ) {
+        Add const& add = static_cast<Add const&>( exp );
+        for( size_t i = 0; i < add.numberOfChildren(); ++i )
+            combine( seed, add.getSignForChild( i ) == Sign::p );
+    }
+    return seed;
+}
+
+bool shallowEqual( Expr const& lhs, Expr const& rhs )
+{
+    if( shallowCompare( lhs, rhs ) != 0 )
+        return false;
+    return lhs.id() != ID::add ||
+           compareSigns( static_cast<Add const&>( lhs ), static_cast<Add const&>( rhs ) ) == 0;
+}
+
+size_t structuralHash( Expr const& exp )
+{
+    size_t seed = 0;
+    std::vector<Expr const*> work( 1, &exp );
+    while( !work.empty() ) {
+        Expr const* top = work.back();
+        work.pop_back();
+        combine( seed, shallowHash( *top ) );
+        for( size_t i = top->numberOfChildren(); i > 0; --i )
+            work.push_back( top->getChild( i-1 ).get() );
+    }
+    return seed;
+}
+
+int structuralCompare( Expr const& lhs, Expr const& rhs )
+{
+    // Pairs of nodes in preorder; two Adds that agree on their
+    // children are then told apart by their signs
+    std::vector<std::pair<Expr const*, Expr const*> > work( 1, std::make_pair( &lhs, &rhs ) );
+    std::vector<std::pair<Add const*, Add const*> > adds;
+    while( !work.empty() ) {
+        std::pair<Expr const*, Expr const*> top = work.back();
+        work.pop_back();
+        if( top.first == top.second )
+            continue;
+        if( int order = shallowCompare( *top.first, *top.second ) )
+            return order;
+        if( top.first->id() == ID::add )
+            adds.push_back( std::make_pair( static_cast<Add const*>( top.first ),
+                                            static_cast<Add const*>( top.second ) ) );
+        for( size_t i = top.first->numberOfChildren(); i > 0; --i )
+            work.push_back( std::make_pair( top.first->getChild( i-1 ).get(),
+                                            top.second->getChild( i-1 ).get() ) );
+    }
+    for( auto const& add : adds )
+        if( int order = compareSigns( *add.first, *add.second ) )
+            return order;
+    return 0;
+}
+
+size_t SharedSubtrees::hashStep( Expr const& node, unsigned int firstChild ) const
+{
+    size_t seed = shallowHash( node );
+    for( size_t i = 0; i < node.numberOfChildren(); ++i )
+        combine( seed, children[firstChild + i] );
+    return seed;
+}
+
+bool SharedSubtrees::equalSteps( Step const& lhs, Expr const& node, unsigned int firstChild ) const
+{
+    if( !shallowEqual( *lhs.node, node ) )
+        return false;
+    for( size_t i = 0; i < node.numberOfChildren(); ++i )
+        if( children[lhs.firstChild + i] != children[firstChild + i] )
+            return false;
+    return true;
+}
+
+void SharedSubtrees::number( Expr const& exp )
+{
+    steps.clear();
+    children.clear();
+    byNode.clear();
+    byHash.clear();
+    treeSizes.clear();
+    size_t const most = std::numeric_limits<size_t>::max();
+
+    // Post-order, not descending into a node already numbered
+    work.push_back( Frame{ &exp, 0 } );
+    while( !work.empty() ) {
+        Frame& top = work.back();
+        if( top.next < top.node->numberOfChildren() ) {
+            Expr const* child = top.node->getChild( top.next++ ).get();
+            if( byNode.find( child ) == byNode.end() )
+                work.push_back( Frame{ child, 0 } );
+            continue;
+        }
+        Expr const* node = top.node;
+        work.pop_back();
+
+        // The children's numbers go on the end of children, and
+        // stay there only if this is a new step
+        unsigned int firstChild = children.size();
+        size_t size = 1;
+        for( size_t i = 0; i < node->numberOfChildren(); ++i ) {
+            unsigned int n = byNode[node->getChild( i ).get()];
+            children.push_back( n );
+            size = ( size > most - treeSizes[n] ) ? most : size + treeSizes[n];
+        }
+        size_t hash = hashStep( *node, firstChild );
+        unsigned int number = steps.size();
+        auto range = byHash.equal_range( hash );
+        for( auto it = range.first; it != range.second; ++it )
+            if( equalSteps( steps[it->second], *node, firstChild ) ) {
+                number = it->second;
+                break;
+            }
+        if( number == steps.size() ) {
+            steps.push_back( Step{ node, firstChild } );
+            byHash.insert( std::make_pair( hash, number ) );
+            treeSizes.push_back( size );
+        }
+        else
+            children.resize( firstChild );
+        byNode[node] = number;
+    }
+    root = byNode[&exp];
+    repeated = treeSizes[root] - steps.size();
+}
+
+} } }
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Expression.hpp"
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+namespace DS          {
+namespace CAS         {
+namespace Expressions {
+
+/**********************************************************
+ * Structural hashing and ordering of expressions, i.e. by
+ * what the trees contain rather than by which nodes they
+ * are.  structuralCompare is a total order: kinds in the
+ * order of ID (literals neither first nor last; Canonical
+ * sets numbers apart itself), then symbol names and
+ * literal values (real part, then imaginary part), then
+ * the number of children and the children themselves from
+ * left to right, and signs last.  Structurally equal trees
+ * hash equally (literals by Number::hash, which need not
+ * tell every pair of numbers apart).  Neither recurses, so
+ * deep trees are fine.
+ **********************************************************/
+size_t structuralHash( Expr const& exp );
+
+// < 0, 0 or > 0 as lhs comes before, is equal to, or comes
+// after rhs
+int structuralCompare( Expr const& lhs, Expr const& rhs );
+
+inline bool structurallyEqual( ExprConstSP const& lhs, ExprConstSP const& rhs )
+{
+    return lhs == rhs || structuralCompare( *lhs, *rhs ) == 0;
+}
+
+// Everything about a node but its children, an Add's signs
+// included; with the children told apart some other way, as
+// by SharedSubtrees, this is all that is left to compare
+size_t shallowHash( Expr const& exp );
+bool shallowEqual( Expr const& lhs, Expr const& rhs );
+
+/**********************************************************
+ * Numbers the distinct subtrees of an expression, bottom
+ * up, so that structurally equal subtrees (whether they are
+ * one shared node or equal copies) get the same number.
+ * Each number is defined by a step: a node standing for
+ * all the subtrees with that number, and the numbers of its
+ * children.  The steps come children first, so going
+ * through them in order computes anything over the tree
+ * once per distinct subtree.
+ **********************************************************/
+class SharedSubtrees
+{
+public:
+    struct Step
+    {
+        Expr const*  node;
+        unsigned int firstChild; // into getChildren()
+    };
+
+    void number( Expr const& root );
+
+    std::vector<Step> const& getSteps() const { return steps; }
+    std::vector<unsigned int> const& getChildren() const { return children; }
+    unsigned int child( Step const& step, unsigned int i ) const { return children[step.firstChild + i]; }
+    unsigned int getRoot() const { return root; }
+
+    // Nodes the tree would have with nothing shared (saturating
+    // at the largest size_t), less the number of steps
+    size_t repeatedNodes() const { return repeated; }
+
+private:
+    size_t hashStep( Expr const& node, unsigned int firstChild ) const;
+    bool equalSteps( Step const& lhs, Expr const& node, unsigned int firstChild ) const;
+
+    std::vector<Step> steps;
+    std::vector<unsigned int> children;
+    unsigned int root = 0;
+    size_t repeated = 0;
+
+    // Reused from one numbering to the next
+    std::unordered_map<Expr const*, unsigned int> byNode;
+    std::unordered_multimap<size_t, unsigned int> byHash;
+    std::vector<size_t> treeSizes;
+    struct Frame
+    {
+        Expr const*  node;
+        unsigned int next;
+    };
+    std::vector<Frame> work;
+};
+
+} } }
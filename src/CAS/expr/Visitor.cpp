@@ -1,5 +1,6 @@
 #include <stdexcept>
 #include "Visitor.hpp"
+#include "exprs.hpp"
 
 namespace DS          {
 namespace CAS         {
@@ -7,21 +8,45 @@ namespace Expressions {
 
 bool Visitor::visitExpression(ExprConstSP ptr)
 {
-    unsigned int numberOfChildren = ptr->numberOfChildren();
-    for (unsigned int index = 0; index < numberOfChildren; index++)
+    // Frames below base belong to an enclosing traversal
+    size_t base = work.size();
+    work.push_back(Frame{ptr.get(), 0});
+    while (work.size() > base)
     {
-        if (!visitExpression(ptr->getChild(index)))
+        Frame& top = work.back();
+        if (top.next < top.node->numberOfChildren())
         {
+            const Expr* child = top.node->getChild(top.next++).get();
+            work.push_back(Frame{child, 0});
+            continue;
+        }
+        const Expr* node = top.node;
+        work.pop_back();
+        if (!visitNode(*node))
+        {
+            work.resize(base);
             reset();
             return false;
         }
     }
-    if (!(ptr->acceptVisitor(*this)))
+    return true;
+}
+
+bool Visitor::visitNode(const Expr& exp)
+{
+    switch (exp.id())
     {
-        reset();
-        return false;
+        case ID::add:       return visitAdd(static_cast<const Add&>(exp));
+        case ID::divide:    return visitDivide(static_cast<const Divide&>(exp));
+        case ID::factorial: return visitFactorial(static_cast<const Factorial&>(exp));
+        case ID::literal:   return visitLiteral(static_cast<const Literal&>(exp));
+        case ID::modulus:   return visitModulus(static_cast<const Modulus&>(exp));
+        case ID::multiply:  return visitMultiply(static_cast<const Multiply&>(exp));
+        case ID::negate:    return visitNegate(static_cast<const Negate&>(exp));
+        case ID::power:     return visitPower(static_cast<const Power&>(exp));
+        case ID::symbol:    return visitSymbol(static_cast<const Symbol&>(exp));
     }
-    return true;
+    throw std::logic_error("unknown expression id in Visitor::visitNode");
 }
 
 } /* namespace Expressions */
@@ -3,10 +3,18 @@
 #include "Expression.hpp"
 #include "exprfwd.hpp"
 
+#include <stack>
+#include <vector>
+
 namespace DS          {
 namespace CAS         {
 namespace Expressions {
 
+// Stack of intermediate results kept by visitors; backed by a
+// vector so that popping keeps the storage around for the next pass
+template<typename T>
+using ResultStack = std::stack<T, std::vector<T> >;
+
 class Visitor
 {
 public:
@@ -17,7 +25,13 @@ public:
 
     virtual void reset(void) {}
 
-    virtual bool visitExpression(ExprConstSP); // default visits children then node
+    // Default visits children then node (post-order), without
+    // recursing, so that the depth of the tree is not limited
+    // by the native stack; stops and calls reset() as soon as
+    // any visitX returns false
+    virtual bool visitExpression(ExprConstSP);
+
+    bool visitNode(const Expr&); // calls the visitX matching exp.id()
 
     virtual bool visitAdd(const Add&)                = 0;
     virtual bool visitDivide(const Divide&)          = 0;
@@ -31,6 +45,18 @@ public:
 
 protected:
     Visitor() {}
+
+private:
+    // A node whose children are being visited, along with the
+    // index of the next one to descend into
+    struct Frame
+    {
+        const Expr*  node;
+        unsigned int next;
+    };
+
+    // Reused from one traversal to the next
+    std::vector<Frame> work;
 };
 
 } } }
@@ -1,6 +1,7 @@
 #include "macros.hpp"
 #include "exprs.hpp"
 #include "Visitor.hpp"
+#include "Region.hpp"
 
 #include <stdexcept>
 
@@ -9,82 +10,53 @@ namespace CAS         {
 namespace Expressions {
 
 Add::Add( std::vector<ExprConstSP> const& exprs,
-          std::vector<Sign>        const& _signs ) {
+          std::vector<Sign>        const& _signs )
+    : Expr( ID::add, exprs ) {
     ASSERT( exprs.size() == _signs.size() );
     ASSERT( exprs.size() > 0 );
-    children = exprs;
-    signs    = _signs;
+    std::uint64_t* words = &signs.bits;
+    if( _signs.size() > inline_signs ) {
+        size_t n = ( _signs.size() + 63 )/64;
+        words = static_cast<std::uint64_t*>( resource()->allocate( n*sizeof( std::uint64_t ), alignof( std::uint64_t ) ) );
+        for( size_t i = 0; i < n; ++i )
+            words[i] = 0;
+        signs.words = words;
+    }
+    else
+        signs.bits = 0;
+    for( size_t i = 0; i < _signs.size(); ++i )
+        if( _signs[i] == Sign::p )
+            words[i/64] |= std::uint64_t( 1 ) << ( i%64 );
 }
 
-bool Add::acceptVisitor(Visitor& visitor) const
+Add::~Add()
 {
-    return visitor.visitAdd(*this);
+    if( numberOfChildren() > inline_signs ) {
+        size_t n = ( numberOfChildren() + 63 )/64;
+        resource()->deallocate( signs.words, n*sizeof( std::uint64_t ), alignof( std::uint64_t ) );
+    }
 }
 
 Sign Add::getSignForChild(size_t i) const
 {
-    ASSERT( i < signs.size() );
-    return signs[i];
+    ASSERT( i < numberOfChildren() );
+    std::uint64_t const* words = ( numberOfChildren() > inline_signs ) ? signs.words : &signs.bits;
+    return ( words[i/64] >> ( i%64 ) ) & 1 ? Sign::p : Sign::n;
 }
 
-std::vector<Sign> const& Add::getSignVector(void) const
+std::vector<Sign> Add::getSigns(void) const
 {
-    return signs;
-}
-
-bool Divide::acceptVisitor(Visitor& visitor) const
-{
-    return visitor.visitDivide(*this);
-}
-
-bool Factorial::acceptVisitor(Visitor& visitor) const
-{
-    return visitor.visitFactorial(*this);
-}
-
-using namespace DS::CAS::Numbers;
-using namespace DS::CAS::Numbers::Proxy;
-
-bool Literal::acceptVisitor(Visitor& visitor) const
-{
-    return visitor.visitLiteral(*this);
-}
-
-bool Modulus::acceptVisitor(Visitor& visitor) const
-{
-    return visitor.visitModulus(*this);
+    std::vector<Sign> result( numberOfChildren() );
+    for( size_t i = 0; i < result.size(); ++i )
+        result[i] = getSignForChild( i );
+    return result;
 }
 
 Multiply::Multiply(const std::vector<ExprConstSP>& _children)
+    : Expr( ID::multiply, _children )
 {
     if (_children.size() == 0)
         throw std::invalid_argument("_children == 0 in Multiply::Multiply(vector)");
-    children = _children;
-}
-
-bool Multiply::acceptVisitor(Visitor& visitor) const
-{
-    return visitor.visitMultiply(*this);
-}
-
-bool Negate::acceptVisitor(Visitor& visitor) const
-{
-    return visitor.visitNegate(*this);
-}
-
-bool Power::acceptVisitor(Visitor& visitor) const
-{
-    return visitor.visitPower(*this);
-}
-
-bool Symbol::acceptVisitor(Visitor& visitor) const
-{
-    return visitor.visitSymbol(*this);
-}
-
-const std::string& Symbol::getName(void) const
-{
-    return name;
 }
 
 } /* namespace Expressions */
@@ -3,7 +3,9 @@
 #include "Number.hpp"
 #include "NumberProxy.hpp"
 #include "Expression.hpp"
+#include "Atom.hpp"
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <exception>
@@ -14,8 +16,11 @@ namespace DS          {
 namespace CAS         {
 namespace Expressions {
 
+// Nodes are built with Expr::create, which is why their
+// constructors and destructors are private.
+
 /**********************************************************
- *                           Add 
+ *                           Add
  **********************************************************/
 class Add: public Expr
 {
@@ -23,18 +28,24 @@ public:
     using SignedExpr    = std::pair<Sign, ExprConstSP>;
     using SignedExprVec = std::vector<SignedExpr>;
 
-    Add( std::vector<ExprConstSP> const& exprs,
-         std::vector<Sign>        const& signs );
+    Sign getSignForChild( size_t ) const;
+    std::vector<Sign> getSigns() const;
 
-    virtual ID id( void ) const { return ID::add; }
+private:
+    friend class Expr;
 
-    virtual bool acceptVisitor( Visitor& ) const;
+    Add( std::vector<ExprConstSP> const& exprs,
+         std::vector<Sign>        const& signs );
+    ~Add();
 
-    Sign getSignForChild( size_t ) const;
-    std::vector<Sign> const& getSignVector() const;
+    static constexpr size_t inline_signs = 64;
 
-protected:
-    std::vector<Sign> signs;
+    // One bit per child, set for Sign::p; held in place up to
+    // inline_signs children
+    union {
+        std::uint64_t  bits;
+        std::uint64_t* words;
+    } signs;
 };
 
 /**********************************************************
@@ -42,13 +53,12 @@ protected:
  **********************************************************/
 class Divide: public Expr
 {
-public:
-    Divide( ExprConstSP numerator, ExprConstSP denominator)
-        : Expr( { numerator, denominator } ) {}
-
-    virtual ID id(void) const { return ID::divide; }
+private:
+    friend class Expr;
 
-    virtual bool acceptVisitor(Visitor&) const;
+    Divide( ExprConstSP numerator, ExprConstSP denominator)
+        : Expr( ID::divide, { numerator, denominator } ) {}
+    ~Divide() {}
 };
 
 /**********************************************************
@@ -56,14 +66,11 @@ public:
  **********************************************************/
 class Factorial: public DS::CAS::Expressions::Expr
 {
-public:
-    Factorial(ExprConstSP ptr) : Expr( { ptr } ) {}
-
-    virtual ~Factorial() {}
+private:
+    friend class Expr;
 
-    virtual ID id(void) const { return ID::factorial; }
-
-    virtual bool acceptVisitor(Visitor&) const;
+    Factorial(ExprConstSP ptr) : Expr( ID::factorial, { ptr } ) {}
+    ~Factorial() {}
 };
 
 /**********************************************************
@@ -72,50 +79,49 @@ public:
 class Literal : public DS::CAS::Expressions::Expr
 {
 public:
-    Literal(Numbers::Number* _number) : number(_number) {} // number will take ownership of this
-    Literal(const Numbers::Number& _number) : number(_number) {} // number will copy this
-
-    virtual ~Literal() {}
-
-    virtual ID id(void) const { return ID::literal; }
-
-    virtual bool acceptVisitor(Visitor&) const;
-
     const Numbers::Number& getNumber(void) const
     {
         return number;
     }
+    // For a literal read from a decimal, the digits written after the point
+    // net of the exponent; the number times ten to this is an integer
+    unsigned int getDecimalPlaces(void) const
+    {
+        return decimalPlaces;
+    }
+
+private:
+    friend class Expr;
+
+    Literal(Numbers::Number* _number, unsigned int _decimalPlaces = 0) // number will take ownership of this
+        : Expr( ID::literal, {} ), number(_number), decimalPlaces(_decimalPlaces) {}
+    Literal(const Numbers::Number& _number) : Expr( ID::literal, {} ), number(_number), decimalPlaces(0) {} // number will copy this
+    ~Literal() {}
 
-protected:
     Numbers::Proxy::NumberP number;
+    unsigned int decimalPlaces;
 };
 
 /**********************************************************
  *                         Modulus
  **********************************************************/
 class Modulus: public DS::CAS::Expressions::Expr {
-public:
-    Modulus(ExprConstSP n, ExprConstSP d) : Expr( { n, d } ) {}
-
-    virtual ~Modulus() {}
+private:
+    friend class Expr;
 
-    virtual ID id(void) const { return ID::modulus; }
-
-    virtual bool acceptVisitor(Visitor& visitor) const;
+    Modulus(ExprConstSP n, ExprConstSP d) : Expr( ID::modulus, { n, d } ) {}
+    ~Modulus() {}
 };
 
 /**********************************************************
  *                        Multiply
  **********************************************************/
 class Multiply: public DS::CAS::Expressions::Expr {
-public:
-    Multiply(const std::vector<ExprConstSP>&);
-
-    virtual ~Multiply() {}
-
-    virtual ID id(void) const { return ID::multiply; }
+private:
+    friend class Expr;
 
-    virtual bool acceptVisitor(Visitor&) const;
+    Multiply(const std::vector<ExprConstSP>&);
+    ~Multiply() {}
 };
 
 /**********************************************************
@@ -123,27 +129,23 @@ public:
  **********************************************************/
 class Negate: public DS::CAS::Expressions::Expr
 {
-public:
-    Negate(const ExprConstSP ptr) : Expr( { ptr } ) {}
-    virtual ~Negate() {}
-
-    virtual ID id(void) const { return ID::negate; }
+private:
+    friend class Expr;
 
-    virtual bool acceptVisitor(Visitor&) const;
+    Negate(const ExprConstSP ptr) : Expr( ID::negate, { ptr } ) {}
+    ~Negate() {}
 };
 
 /**********************************************************
  *                          Power
  **********************************************************/
 class Power: public DS::CAS::Expressions::Expr {
-public:
-    Power(const ExprConstSP base, const ExprConstSP exponent)
-        : Expr( { base, exponent } ) {}
-    virtual ~Power() {}
+private:
+    friend class Expr;
 
-    virtual ID id(void) const { return ID::power; }
-
-    virtual bool acceptVisitor(Visitor&) const;
+    Power(const ExprConstSP base, const ExprConstSP exponent)
+        : Expr( ID::power, { base, exponent } ) {}
+    ~Power() {}
 };
 
 /**********************************************************
@@ -152,20 +154,18 @@ public:
 class Symbol: public DS::CAS::Expressions::Expr
 {
 public:
-    Symbol(const std::string& _name) : name(_name) {}
-    Symbol(const std::string& _name, const std::vector<ExprConstSP>& _children)
-        : Expr( _children ), name(_name) {}
-
-    virtual ~Symbol() {}
-
-    virtual ID id(void) const { return ID::symbol; }
+    const std::string& getName(void) const { return atom.name(); }
+    Atom getAtom(void) const { return atom; }
 
-    virtual bool acceptVisitor(Visitor&) const;
+private:
+    friend class Expr;
 
-    const std::string& getName(void) const;
+    Symbol(Atom _atom) : Expr( ID::symbol, {} ), atom(_atom) {}
+    Symbol(Atom _atom, const std::vector<ExprConstSP>& _children)
+        : Expr( ID::symbol, _children ), atom(_atom) {}
+    ~Symbol() {}
 
-protected:
-    std::string name;
+    Atom atom;
 };
 
 } /* namespace Expressions */
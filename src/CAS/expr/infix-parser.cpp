@@ -1,6 +1,3 @@
-#include <stdexcept>
-#include <stack>
-
 #include "infix-parser.hpp"
 #include "scanner-builder.hpp"
 
@@ -45,302 +42,269 @@ void Infix::buildScanners(std::vector<scanner::ptr>& scanners, std::shared_ptr<s
     scanners.push_back(sBuilder->pop());
 }
 
-int getOperatorPrecedence(const std::string& str)
-{
-    if (str == "!")
-        return 5;
-    if (str == "^")
-        return 4;
-    if (str == "*" || str == "/" || str == "%")
-        return 3;
-    if (str == "ng")
-          return 4;
-    if (str == "+" || str == "-")
-        return 2;
-    throw std::invalid_argument("invalid operator in getOperatorPrecedence()");
-}
+namespace {
 
-int getOperatorChildren(const std::string& str)
-{
-    if (str == "!" || str == "ng")
-        return 1;
-    if (str == "^" || str == "*" || str == "/" || str == "+" || str == "-" || str == "%")
-        return 2;
-    throw std::invalid_argument("invalid operator in getOperatorChildren()");
-}
+enum { spaces, minus, binaryOp, factorial, number, leftP, rightP, comma, var };
 
-bool isLeftAssociative(const std::string& str)
-{
-    if (str == "!")
-        return true;
-    if (str == "^")
-        return false;
-    if (str == "ng")
-        return false;
-    if (str == "*" || str == "/" || str == "%")
-        return true;
-    if (str == "+" || str == "-")
-        return true;
-    throw std::invalid_argument("invalid operator in isLeftAssociative()");
-}
+// Binding powers: an operator continues an expression being parsed at
+// level min only when its precedence is at least min.  Right associative
+// operators parse their right side at their own precedence, left
+// associative ones one above it.
+enum { sumPrecedence = 2, productPrecedence = 3, powerPrecedence = 4, factorialPrecedence = 5 };
 
-bool Infix::parseTokens(const std::vector<token>& tokens, std::vector<Command>& commands)
+/****************************************************************************
+ * Precedence climbing without recursion: each operator waiting for its
+ * right side (and each open parenthesis or function call) is a Pending on
+ * an explicit stack, holding the level min its right side is parsed at, so
+ * nesting is limited by memory rather than by the call stack.  An operator
+ * of precedence p continues the innermost pending right side when p >= min;
+ * otherwise that right side is complete and the pending operator is built.
+ ****************************************************************************/
+class PrattParser
 {
-    enum { spaces, minus, binaryOp, factorial, number, leftP, rightP, comma, var };
-    std::stack<token> operatorStack;
-    std::stack<int> functionArgStack;
-    std::vector<token>::const_iterator it = tokens.begin();
-    bool lookingForValue = true;
-
-      //While there are tokens to be read:
-    //    Read a token.
-
-    while (1)
+public:
+    PrattParser(const std::vector<token_view>& tokens, std::string::const_iterator& stopLocation,
+                const Builder& eBuilder, Numbers::NumberFormatter& nFormatter)
+        : it(tokens.begin()), end(tokens.end()), stopLocation(stopLocation), eB(eBuilder), nF(nFormatter)
     {
-        while (it != tokens.end())
-        {
-            if ((*it).id() == spaces)
-            {
-                stopLocation += (*it).string().length();
-                ++it;
-            }
-            else
-                break;
-        }
-        if (it == tokens.end())
-            break;
-        int id = (*it).id();
-        std::string str = (*it).string();
+        skipSpaces();
+    }
 
-        if (lookingForValue)
+    // A whole expression, or null on a syntax error, with the stop location
+    // left at the start of the token where it was found
+    ExprConstSP parse()
+    {
+        pending.assign(1, Pending(Pending::whole, 0));
+        while (1)
         {
-            //    If the token is a number, then add it to the output queue.
-            if (id == number)
+            ExprConstSP left = operand();
+            if (!left)
+                return left;
+            // left is a complete operand: climb from it, building pending
+            // operators, until the next operand is due
+            while (1)
             {
-                commands.push_back(Command(Command::literal, str, 0));
-                stopLocation += (*it).string().length();
-                ++it;
-                lookingForValue = false;
-            }
-            //  If the token is a variable or function
-            else if (id == var)
-            {
-                // if we're at the end then it's a variable, add it to output
-                if ((it+1) == tokens.end())
+                int p = precedence();
+                if (p == factorialPrecedence)
                 {
-                    commands.push_back(Command(Command::symbol, str, 0));
-                    stopLocation += (*it).string().length();
-                    ++it;
-                    lookingForValue = false;
+                    advance();
+                    left = eB.factorial(left);
+                    continue;
                 }
-                // could be a variable or function
-                else
+                if (p >= pending.back().min)
                 {
-                    // if next token is not '(' then it's a variable, add it to output
-                    if ((*(it+1)).id() != leftP)
+                    if (p == sumPrecedence)
                     {
-                        commands.push_back(Command(Command::symbol, str, 0));
-                        stopLocation += (*it).string().length();
-                        ++it;
-                        lookingForValue = false;
+                        // a chain of terms becomes a single Add
+                        pending.emplace_back(Pending::sum, sumPrecedence + 1);
+                        pending.back().signs.push_back(Sign::p);
+                        pending.back().signs.push_back(peek() == minus ? Sign::n : Sign::p);
                     }
-                    // it's a function, add it and '(' to stack
+                    else if (op() == '*')
+                        // and a chain of factors a single Multiply
+                        pending.emplace_back(Pending::product, productPrecedence + 1);
                     else
                     {
-                        operatorStack.push(*it);
-                        operatorStack.push(*(it+1));
-                        stopLocation += (*it).string().length();
-                        ++it;
-                        stopLocation += (*it).string().length();
-                        ++it;
-                        functionArgStack.push(1);
-                        lookingForValue = true;
+                        pending.emplace_back(Pending::binary, op() == '^' ? powerPrecedence : productPrecedence + 1);
+                        pending.back().symbol = op();
                     }
+                    pending.back().operands.push_back(left);
+                    advance();
+                    break;
                 }
-            }
-            //    If the token is a minus sign
-            else if (id == minus)
-            {
-                // remove operators from stack with higher precedence
-                while (!operatorStack.empty())
+                Completion completion = complete(left, p);
+                if (completion == finished)
+                    return left;
+                if (completion == failed)
+                    return ExprConstSP();
+                if (completion == operandNext)
                 {
-                    token o2 = operatorStack.top();
-                    int o2Id = o2.id();
-                    std::string o2Str = o2.string();
-                    if (o2Id != minus && o2Id != binaryOp && o2Id != factorial)
-                        break;
-                    int ngPrecedence = getOperatorPrecedence("ng");
-                    int o2Precedence = getOperatorPrecedence(o2Str);
-                    if ((ngPrecedence < o2Precedence) || ((ngPrecedence <= o2Precedence) && isLeftAssociative("ng")))
-                    {
-                        commands.push_back(Command(Command::symbol, o2Str, getOperatorChildren(o2Str)));
-                        operatorStack.pop();
-                    }
-                    else
-                        break;
+                    advance();
+                    break;
                 }
-                // add it to stack
-                token newToken("ng", minus);
-                operatorStack.push(newToken);
-                stopLocation += (*it).string().length();
-                ++it;
-                lookingForValue = true;
             }
-            //    If the token is a left parenthesis then add it to stack
-            else if (id == leftP)
+        }
+    }
+
+private:
+    struct Pending
+    {
+        enum Kind { whole, group, call, negation, binary, sum, product };
+
+        Pending(Kind _kind, int _min) : kind(_kind), min(_min), symbol(0) {}
+
+        Kind kind;
+        int  min;
+        char symbol;
+        std::string name;
+        // The left side of a binary operator, the terms or factors so
+        // far of a chain, or the arguments so far of a call
+        std::vector<ExprConstSP> operands;
+        std::vector<Sign> signs;
+    };
+
+    bool atEnd() const { return it == end; }
+    int  peek()  const { return it->id(); }
+    char op()    const { return it->text()[0]; }
+
+    void skipSpaces()
+    {
+        while (it != end && it->id() == spaces)
+        {
+            stopLocation += it->length();
+            ++it;
+        }
+    }
+    void advance()
+    {
+        stopLocation += it->length();
+        ++it;
+        skipSpaces();
+    }
+
+    // The precedence of the operator at the current token, or -1 if the
+    // token does not continue an expression
+    int precedence() const
+    {
+        if (atEnd())
+            return -1;
+        switch (peek())
+        {
+        case minus:
+            return sumPrecedence;
+        case factorial:
+            return factorialPrecedence;
+        case binaryOp:
+            switch (op())
+            {
+            case '+':                       return sumPrecedence;
+            case '*': case '/': case '%':   return productPrecedence;
+            case '^':                       return powerPrecedence;
+            }
+        }
+        return -1;
+    }
+
+    enum Completion { built, operandNext, finished, failed };
+
+    // Gives left, a complete right side, to the innermost pending operator,
+    // the operator at the current token having precedence p below its min:
+    // built, with left the result, when the operator is done; operandNext
+    // when the current token is to be skipped and an operand read, for a
+    // chain going on or the next argument of a call; finished at the end of
+    // the whole expression
+    Completion complete(ExprConstSP& left, int p)
+    {
+        Pending& top = pending.back();
+        switch (top.kind)
+        {
+        case Pending::whole:
+            return atEnd() ? finished : failed;
+        case Pending::group:
+            if (atEnd() || peek() != rightP)
+                return failed;
+            advance();
+            break;
+        case Pending::call:
+            top.operands.push_back(left);
+            if (atEnd() || (peek() != comma && peek() != rightP))
+                return failed;
+            if (peek() == comma)
+                return operandNext;
+            advance();
+            left = eB.symbol(top.name, top.operands);
+            break;
+        case Pending::negation:
+            left = eB.negate(left);
+            break;
+        case Pending::binary:
+            switch (top.symbol)
             {
-                operatorStack.push(*it);
-                stopLocation += (*it).string().length();
-                ++it;
-                lookingForValue = true;
+            case '/': left = eB.divide(top.operands[0], left);  break;
+            case '%': left = eB.modulus(top.operands[0], left); break;
+            case '^': left = eB.power(top.operands[0], left);   break;
             }
-            // looking for a value and haven't found one, problem
-            else
+            break;
+        case Pending::sum:
+            top.operands.push_back(left);
+            if (p == sumPrecedence)
             {
-                commands.clear();
-                return false;
+                top.signs.push_back(peek() == minus ? Sign::n : Sign::p);
+                return operandNext;
             }
+            left = eB.add(top.operands, top.signs);
+            break;
+        case Pending::product:
+            top.operands.push_back(left);
+            if (p == productPrecedence && op() == '*')
+                return operandNext;
+            left = eB.multiply(top.operands);
+            break;
         }
-        // Looking for an operator
-        else
+        pending.pop_back();
+        return built;
+    }
+
+    // A number or variable, after pushing whatever function calls,
+    // parentheses and negations open before it; a negation's operand
+    // binds as tightly as a power's right side
+    ExprConstSP operand()
+    {
+        while (1)
         {
-            //    If the token is an operator, o1, then:
-            //        while there is an operator token, o2, at the top of the stack, and either o1 is left-associative and its precedence is less than or equal to that of o2, or o1 has precedence less than that of o2,
-            //            pop o2 off the stack, onto the output queue;
-            //        push o1 onto the stack.
-            if (id == minus || id == binaryOp || id == factorial)
+            if (atEnd())
+                return ExprConstSP();
+            switch (peek())
             {
-                while (!operatorStack.empty())
-                {
-                    token o2 = operatorStack.top();
-                    int o2Id = o2.id();
-                    std::string o2Str = o2.string();
-                    if (o2Id != minus && o2Id != binaryOp && o2Id != factorial)
-                        break;
-                    int o1Precedence = getOperatorPrecedence(str);
-                    int o2Precedence = getOperatorPrecedence(o2Str);
-                    if ((o1Precedence < o2Precedence) || ((o1Precedence <= o2Precedence) && isLeftAssociative(str)))
-                    {
-                        commands.push_back(Command(Command::symbol, o2Str, getOperatorChildren(o2Str)));
-                        operatorStack.pop();
-                    }
-                    else
-                        break;
-                }
-                // add it to stack
-                operatorStack.push(*it);
-                stopLocation += (*it).string().length();
-                ++it;
-                if (id == minus || id == binaryOp)
-                    lookingForValue = true;
-                else
-                    lookingForValue = false;
-            }
-            //    If the token is a function argument separator (e.g., a comma):
-            //        Until the token at the top of the stack is a left parenthesis, pop operators off the stack onto the output queue.
-            //        If no left parentheses are encountered, either the separator was misplaced or parentheses were mismatched.
-            else if (id == comma)
+            case number:
             {
-                // misplaced comma?
-                if (functionArgStack.empty())
-                {
-                    commands.clear();
-                    return false;
-                }
-                ++(functionArgStack.top());
-                stopLocation += (*it).string().length();
-                ++it;
-                while (1)
-                {
-                    if (operatorStack.empty())
-                    {
-                        commands.clear();
-                        return false;
-                    }
-                    token token = operatorStack.top();
-                    if (token.string() == "(")
-                        break;
-                    commands.push_back(Command(Command::symbol, token.string(), getOperatorChildren(token.string())));
-                    operatorStack.pop();
-                }
-                lookingForValue = true;
+                unsigned int decimalPlaces;
+                Numbers::Number* value = nF.format(it->string(), decimalPlaces);
+                if (!value)
+                    return ExprConstSP();
+                advance();
+                return eB.literal(value, decimalPlaces);
             }
-            //    If the token is a right parenthesis:
-            //        Until the token at the top of the stack is a left parenthesis
-            //            pop operators off the stack onto the output queue.
-            //        Pop the left parenthesis from the stack, but not onto the output queue.
-            //        If the token at the top of the stack is a function token, pop it onto the output queue.
-            //        If the stack runs out without finding a left parenthesis, then there are mismatched parentheses.
-            else if (id == rightP)
+            case var:
             {
-                while (1)
+                std::string name = it->string();
+                if (it + 1 == end || (it + 1)->id() != leftP)
                 {
-                    if (operatorStack.empty())
-                    {
-                        commands.clear();
-                        return false;
-                    }
-                    token token = operatorStack.top();
-                    if (token.string() == "(")
-                        break;
-                    commands.push_back(Command(Command::symbol, token.string(), getOperatorChildren(token.string())));
-                    operatorStack.pop();
+                    advance();
+                    return eB.symbol(name);
                 }
-                operatorStack.pop();
-                if (!operatorStack.empty())
-                {
-                    token token = operatorStack.top();
-                    if (token.id() == var)
-                    {
-                        if (functionArgStack.empty())
-                        {
-                            commands.clear();
-                            return false;
-                        }
-                        int children = functionArgStack.top();
-                        functionArgStack.pop();
-                        commands.push_back(Command(Command::symbol, token.string(), children));
-                        operatorStack.pop();
-                    }
-                }
-                stopLocation += (*it).string().length();
-                ++it;
-                lookingForValue = false;
+                advance();
+                advance();
+                pending.emplace_back(Pending::call, 0);
+                pending.back().name = name;
+                break;
             }
-            else
-            {
-                commands.clear();
-                return false;
+            case minus:
+                advance();
+                pending.emplace_back(Pending::negation, powerPrecedence);
+                break;
+            case leftP:
+                advance();
+                pending.emplace_back(Pending::group, 0);
+                break;
+            default:
+                return ExprConstSP();
             }
         }
     }
 
-    if (lookingForValue || !functionArgStack.empty())
-    {
-        commands.clear();
-        return false;
-    }
+    std::vector<Pending> pending;
+    std::vector<token_view>::const_iterator it, end;
+    std::string::const_iterator&            stopLocation;
+    const Builder&                          eB;
+    Numbers::NumberFormatter&               nF;
+};
 
-    //When there are no more tokens to read:
-    //    While there are still operator tokens in the stack:
-    //        If the operator token on the top of the stack is a parenthesis, then there are mismatched parentheses.
-    //        Pop the operator onto the output queue.
-    while (!operatorStack.empty())
-    {
-        token token = operatorStack.top();
-        operatorStack.pop();
-        int id = token.id();
-        std::string str = token.string();
+} // namespace
 
-        if (id != minus && id != binaryOp && id != factorial)
-        {
-            commands.clear();
-            return false;
-        }
-        commands.push_back(Command(Command::symbol, str, getOperatorChildren(str)));
-    }
-
-    return true;
+ExprConstSP Infix::parseExpression(const std::vector<token_view>& tokens)
+{
+    return PrattParser(tokens, stopLocation, *eBuilder, *nFormatter).parse();
 }
 
 } /* namespace Parsers */
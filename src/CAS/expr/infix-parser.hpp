@@ -16,7 +16,9 @@ public:
     virtual ~Infix() {}
 
     virtual void buildScanners(std::vector<castle::scanner::ptr>&, std::shared_ptr<castle::scanner_builder>);
-    virtual bool parseTokens(const std::vector<castle::token>&, std::vector<Command>&);
+    // Precedence climbing straight to the tree, with chains of + and - and
+    // of * each built as a single n-ary node
+    virtual ExprConstSP parseExpression(const std::vector<castle::token_view>&);
 };
 
 } /* namespace Parsers */
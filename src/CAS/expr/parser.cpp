@@ -18,69 +18,82 @@ Parser::Parser(std::shared_ptr<scanner_builder> _sBuilder, std::shared_ptr<Expre
     m_tokenizer  = _tokenizer;
 }
 
-ExprConstSP Parser::parse(const std::string& source)
+castle::dfa& Parser::getLexer()
 {
-    if (scanners.empty())
+    if (!lexer)
+    {
         buildScanners(scanners, sBuilder);
-    std::vector<token> tokens;
+        lexer.reset(new dfa(scanners));
+    }
+    return *lexer;
+}
+
+ExprConstSP Parser::parse(const std::string& source)
+{
+    std::vector<token_view> tokens;
     stopLocation = source.begin();
-    bool success = m_tokenizer->tokenize_priority(source, scanners, tokens);
+    bool success = getLexer().tokenize(source, tokens);
     if (!success)
     {
-        stopLocation = m_tokenizer->stop_location();
+        stopLocation = getLexer().stop_location();
         return ExprConstSP();
     }
+    return parseExpression(tokens);
+}
+
+ExprConstSP Parser::parseExpression(const std::vector<token_view>& tokens)
+{
     std::vector<Command> commands;
     if (!parseTokens(tokens, commands))
         return ExprConstSP();
-    for (std::vector<Command>::const_iterator it = commands.begin(); it != commands.end(); ++it)
-    {
-        //cout << endl << (*it).getNodeName() << ",  " << (*it).getNodeType() << ",  " << (*it).getNumberOfChildren();
-    }
     return buildExpression(commands);
 }
 
 ExprConstSP Parser::buildExpression(const std::vector<Command>& commands)
 {
     stack<ExprConstSP> expStack;
-    ExprConstSP node, nullShared;
-    Numbers::Number* number;
-    std::vector<ExprConstSP> children;
 
     for (std::vector<Command>::const_iterator it = commands.begin(); it != commands.end(); ++it)
-    {
-        switch ((*it).getNodeType())
-        {
-        case Command::literal:
-            number = nFormatter->format((*it).getNodeName());
-            if (!number)
-                return nullShared;
-            node = eBuilder->literal(number);
-            expStack.push(node);
-            break;
-        case Command::symbol:
-            for (unsigned int i = 0; i < (*it).getNumberOfChildren(); i++)
-            {
-                if (expStack.size() == 0)
-                    return ExprConstSP();
-                children.insert(children.begin(), getPop(expStack));
-            }
-            node = eBuilder->operator()((*it).getNodeName(), children);
-            if (!node)
-                return nullShared;
-            expStack.push(node);
-            children.resize(0);
-            break;
-        default:
-            throw std::invalid_argument("invalid node type in Expressions::Parser::buildExpressions(std::vector<Command>)");
-        }
-    }
+        if (!buildNode(*it, expStack))
+            return ExprConstSP();
     if (expStack.size() != 1)
-        return nullShared;
+        return ExprConstSP();
 
     return expStack.top();
 }
 
+bool Parser::buildNode(const Command& command, std::stack<ExprConstSP>& expStack)
+{
+    ExprConstSP node;
+    Numbers::Number* number;
+    unsigned int decimalPlaces;
+    std::vector<ExprConstSP> children;
+
+    switch (command.getNodeType())
+    {
+    case Command::literal:
+        number = nFormatter->format(command.getNodeName(), decimalPlaces);
+        if (!number)
+            return false;
+        node = eBuilder->literal(number, decimalPlaces);
+        break;
+    case Command::symbol:
+        if (expStack.size() < command.getNumberOfChildren())
+            return false;
+        children.resize(command.getNumberOfChildren());
+        for (unsigned int i = children.size(); i-- > 0; )
+            children[i] = getPop(expStack);
+        node = eBuilder->operator()(command.getNodeName(), children);
+        if (!node)
+            return false;
+        break;
+    default:
+        throw std::invalid_argument("invalid node type in Expressions::Parser::buildNode(Command)");
+    }
+    expStack.push(node);
+    return true;
+}
+
 } /* namespace Expressions */
 } /* namespace CAS */
 } /* namespace DS */
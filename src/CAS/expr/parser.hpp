@@ -1,8 +1,11 @@
 #pragma once
 
+#include <memory>
+#include <stack>
 #include <string>
 #include <vector>
 #include "tokenizer.hpp"
+#include "dfa.hpp"
 #include "Builder.hpp"
 #include "NumberFormatter.hpp"
 
@@ -43,8 +46,17 @@ public:
 
 protected:
     virtual void buildScanners(std::vector<castle::scanner::ptr>&, std::shared_ptr<castle::scanner_builder>) = 0;
-    virtual bool parseTokens(const std::vector<castle::token>&, std::vector<Command>&) = 0;
+    // By default the tokens are put in postfix order by parseTokens and the
+    // tree built from that by buildExpression
+    virtual ExprConstSP parseExpression(const std::vector<castle::token_view>&);
+    virtual bool parseTokens(const std::vector<castle::token_view>&, std::vector<Command>&) { return false; }
     virtual ExprConstSP buildExpression(const std::vector<Command>&);
+    // One step of buildExpression: pushes the node for the command, built
+    // from the children on top of the stack.  False if there are too few
+    // children or the node cannot be made.
+    bool buildNode(const Command&, std::stack<ExprConstSP>&);
+
+    castle::dfa& getLexer();
 
     std::shared_ptr<Expressions::Builder>     eBuilder;
     std::shared_ptr<Numbers::NumberFormatter> nFormatter;
@@ -54,7 +66,9 @@ protected:
     std::string::const_iterator stopLocation;
 
 private:
+    // The scanners are compiled into a lexer on first use
     std::vector<castle::scanner::ptr> scanners;
+    std::unique_ptr<castle::dfa>      lexer;
 };
 
 } /* namespace Expressions */
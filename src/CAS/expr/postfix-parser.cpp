@@ -1,8 +1,11 @@
 #include <stdlib.h>
+#include <algorithm>
+#include <chrono>
 #include <stdexcept>
 
 #include "postfix-parser.hpp"
 #include "scanner-builder.hpp"
+#include "Templates.hpp"
 
 using namespace castle;
 
@@ -96,47 +99,51 @@ unsigned int Postfix::defaultChildrenForSymbol(const std::string& symbol)
     return 0;
 }
 
-bool Postfix::parseTokens(const std::vector<token>& tokens, std::vector<Command>& commands)
+namespace {
+    enum { spaces, number, symbolChildren, symbolNoChildren };
+}
+
+Parser::Command Postfix::command(const token_view& token)
+{
+    std::string name;
+    switch (token.id())
+    {
+    case number:
+        return Command(Command::literal, token.string(), 0);
+    case symbolNoChildren:
+        name = token.string();
+        return Command(Command::symbol, name, defaultChildrenForSymbol(name));
+    case symbolChildren:
+    {
+        name = token.string();
+        unsigned int numberOfChildren = extractNumberOfChildren(name);
+        return Command(Command::symbol, name, numberOfChildren);
+    }
+    default:
+        throw std::invalid_argument("invalid token type in Postfix::command()");
+    }
+}
+
+bool Postfix::parseTokens(const std::vector<token_view>& tokens, std::vector<Command>& commands)
 {
     if (tokens.empty())
         return false;
 
-    enum { spaces, number, symbolChildren, symbolNoChildren };
-    std::string newToken;
-    unsigned int numberOfChildren;
-    std::vector<token>::const_iterator it = tokens.begin();
+    std::vector<token_view>::const_iterator it = tokens.begin();
 
     if (it != tokens.end())
     {
         if ((*it).id() == spaces)
         {
-            stopLocation += (*it).string().length();
+            stopLocation += (*it).length();
             ++it;
         }
     }
 
     while (it != tokens.end())
     {
-        switch ((*it).id())
-        {
-        case number:
-            commands.push_back(Command(Command::literal, (*it).string(), 0));
-            break;
-        case symbolNoChildren:
-            numberOfChildren = defaultChildrenForSymbol((*it).string());
-            commands.push_back(Command(Command::symbol, (*it).string(), numberOfChildren));
-            break;
-        case symbolChildren:
-            newToken = (*it).string();
-            numberOfChildren = extractNumberOfChildren(newToken);
-            commands.push_back(Command(Command::symbol, newToken, numberOfChildren));
-            break;
-        default:
-            commands.clear();
-            throw std::invalid_argument("invalid token type in Postfix::parseTokens()");
-        }
-
-        stopLocation += (*it).string().length();
+        commands.push_back(command(*it));
+        stopLocation += (*it).length();
         ++it;
         if (it != tokens.end())
         {
@@ -145,13 +152,97 @@ bool Postfix::parseTokens(const std::vector<token>& tokens, std::vector<Command>
                 commands.clear();
                 return false;
             }
-            stopLocation += (*it).string().length();
+            stopLocation += (*it).length();
             ++it;
         }
     }
     return true;
 }
 
+bool Postfix::read(std::istream& in, const std::function<void (ExprConstSP)>& callback, size_t chunkSize)
+{
+    auto start = std::chrono::steady_clock::now();
+    statistics = ReadStatistics{ 0, 0, 0, 1, 0 };
+
+    std::stack<ExprConstSP> expStack;
+    std::string chunk, rest;
+    std::vector<token_view> tokens;
+    bool separated = true, success = true;
+
+    // the line ends, and the one expression on the stack is finished
+    auto endLine = [&]() {
+        if (expStack.empty())
+            return true;
+        if (expStack.size() != 1)
+            return false;
+        callback(getPop(expStack));
+        statistics.expressions++;
+        return true;
+    };
+
+    while (success && (in || !rest.empty()))
+    {
+        // Read on to the last whitespace, so no token is split between
+        // chunks
+        chunk.swap(rest);
+        rest.clear();
+        if (in)
+        {
+            size_t size = chunk.size();
+            chunk.resize(size + chunkSize);
+            in.read(&chunk[size], chunkSize);
+            chunk.resize(size + in.gcount());
+            statistics.bytes += in.gcount();
+            if (in)
+            {
+                size_t cut = chunk.find_last_of(" \t\n");
+                if (cut == std::string::npos)
+                {
+                    chunk.swap(rest);
+                    continue;
+                }
+                rest.assign(chunk, cut + 1, std::string::npos);
+                chunk.resize(cut + 1);
+            }
+        }
+
+        tokens.clear();
+        if (!getLexer().tokenize(chunk, tokens))
+        {
+            statistics.line += std::count(std::string::const_iterator(chunk.begin()), getLexer().stop_location(), '\n');
+            success = false;
+            break;
+        }
+        for (const token_view& token : tokens)
+        {
+            if (token.id() == spaces)
+            {
+                size_t lines = std::count(token.text().begin(), token.text().end(), '\n');
+                if (lines > 0 && !endLine())
+                {
+                    success = false;
+                    break;
+                }
+                statistics.line += lines;
+                separated = true;
+                continue;
+            }
+            if (!separated || !buildNode(command(token), expStack))
+            {
+                success = false;
+                break;
+            }
+            statistics.tokens++;
+            separated = false;
+        }
+    }
+    if (success)
+        success = endLine();
+
+    statistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return success;
+}
+
 } /* namespace Parsers */
 } /* namespace Expressions */
 } /* namespace CAS */
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <functional>
+#include <istream>
+
 #include "parser.hpp"
 
 namespace DS          {
@@ -15,12 +18,31 @@ public:
     virtual ~Postfix() {}
 
     virtual void buildScanners(std::vector<castle::scanner::ptr>&, std::shared_ptr<castle::scanner_builder>);
-    virtual bool parseTokens(const std::vector<castle::token>&, std::vector<Command>&);
+    virtual bool parseTokens(const std::vector<castle::token_view>&, std::vector<Command>&);
+
+    struct ReadStatistics
+    {
+        size_t bytes, tokens, expressions;
+        // The line being read when reading stopped, from 1
+        size_t line;
+        double seconds;
+        double tokensPerSecond(void) const { return seconds > 0 ? tokens/seconds : 0; }
+    };
+
+    // Reads expressions, one to a line, from the stream a chunk at a time,
+    // building each on a stack as its tokens arrive and handing it to the
+    // callback at the end of its line.  Memory is bounded by the chunk size
+    // and the unfinished subtrees on the stack, however long the input.
+    // Returns false at the first syntax error.
+    bool read(std::istream&, const std::function<void (ExprConstSP)>&, size_t chunkSize = 64*1024);
+    const ReadStatistics& getReadStatistics(void) const { return statistics; }
 
 protected:
+    Command command(const castle::token_view&);
     unsigned int extractNumberOfChildren(std::string&);
     unsigned int defaultChildrenForSymbol(const std::string&);
     std::vector<castle::scanner::ptr> childNumberScanners;
+    ReadStatistics statistics;
 };
 
 } /* namespace Parsers */
@@ -1,13 +1,24 @@
 #pragma once
 
+#include <atomic>
+#include <cstddef>
+
 namespace DS {
 namespace CAS {
 namespace Numbers {
 
+// Identifies the concrete class of a Number without RTTI.  Each concrete
+// implementation hands out the address of its own static tag.
+typedef const void* NumberKind;
+
+namespace Proxy {
+    class NumberProxy;
+}
+
 class Number
 {
 public:
-    Number() {}
+    Number() : kind(NULL), references(1) {}
     Number(const Number&) = delete;
 
     virtual Number* create(double realPart = 0, double imaginaryPart = 0) const = 0;
@@ -190,9 +201,29 @@ public:
         copy->copyFrom(*this);
         return copy;
     }
+    // Copy constructs into the given buffer (which is suitably aligned for
+    // any type) if the number fits, returning NULL otherwise
+    virtual Number* cloneInto(void*, size_t) const
+    {
+        return NULL;
+    }
 
     virtual ~Number() {};
 
+    // Equal numbers must hash alike; this one cannot tell any apart
+    virtual size_t hash(void) const
+    {
+        return 0;
+    }
+
+    // The real part as a machine integer, when it is an integer that
+    // converts exactly, so that formatting can skip the digit by digit
+    // arithmetic; this one never converts
+    virtual bool realPartAsInteger(long long&) const
+    {
+        return false;
+    }
+
     virtual bool isIntegral(void) const
     {
         return isRealPartInteger() && isImaginaryPartInteger();
@@ -349,9 +380,23 @@ public:
         multiply(*i);
         delete i;
     }
+
+    NumberKind getKind(void) const { return kind; }
+
+protected:
+    Number(NumberKind _kind) : kind(_kind), references(1) {}
+
+private:
+    friend class Proxy::NumberProxy;
+
+    NumberKind kind;
+    // Number of NumberProxys sharing this number, which may be on
+    // different threads
+    std::atomic<unsigned int> references;
 };
 
 // use these instead of dynamic_cast to cast downcast in the Number hierarchy
+// (number_static_cast below avoids RTTI for tagged classes)
 template<typename TO>
 inline TO number_cast(const Number* from)
 {
@@ -363,4 +408,20 @@ inline TO number_cast(const Number& from)
     return dynamic_cast<TO>(from.implementation());
 }
 
+// Downcasts to the concrete class TO (which must provide a staticKind()
+// tag), looking through proxies by implementation().  Returns NULL for any
+// other class, in which case callers can fall back to number_cast.  The
+// version for a Number that may be modified, which must unshare a proxy's
+// payload first, is in NumberProxy.hpp.
+template<typename TO>
+inline const TO* number_static_cast(const Number& from)
+{
+    if (from.getKind() == TO::staticKind())
+        return static_cast<const TO*>(&from);
+    const Number& number = from.implementation();
+    if (number.getKind() != TO::staticKind())
+        return NULL;
+    return static_cast<const TO*>(&number);
+}
+
 } } }
@@ -3,6 +3,8 @@
 #include <iostream>
 #include <stdexcept>
 #include <cmath>
+#include <functional>
+#include <new>
 #include "Number.hpp"
 
 using namespace std;
@@ -11,22 +13,35 @@ namespace DS {
 namespace CAS {
 namespace Numbers {
 
+// NumberDouble is final so that calls made through a NumberDouble<T> (rather
+// than through a Number) are bound statically; the typed overloads below let
+// arithmetic between two NumberDouble<T>s skip the downcast entirely.
 template<typename T>
-class NumberDouble : public Number
+class NumberDouble final : public Number
 {
 public:
-    NumberDouble() {}
-    NumberDouble(const T& _real, const T& _imaginary = 0) : realPart(_real), imaginaryPart(_imaginary) { }
-    NumberDouble(const NumberDouble<T>& number) : Number(), realPart(number.realPart), imaginaryPart(number.imaginaryPart) { }
+    NumberDouble() : Number(staticKind()) {}
+    NumberDouble(const T& _real, const T& _imaginary = 0) : Number(staticKind()), realPart(_real), imaginaryPart(_imaginary) { }
+    NumberDouble(const NumberDouble<T>& number) : Number(staticKind()), realPart(number.realPart), imaginaryPart(number.imaginaryPart) { }
+
+    NumberDouble<T>& operator= (const NumberDouble<T>& rhs)
+    {
+        realPart = rhs.realPart;
+        imaginaryPart = rhs.imaginaryPart;
+        return *this;
+    }
 
     virtual ~NumberDouble() { }
 
+    static NumberKind staticKind(void) { static const char tag = 0; return &tag; }
+
     T getRealPart(void) const         { return realPart;         }
     T getImaginaryPart(void) const { return imaginaryPart; }
 
     virtual Number* create(double _realPart = 0, double _imaginaryPart = 0) const { return new NumberDouble<T>(_realPart, _imaginaryPart); }
 
-    virtual void copyFrom(const Number& rhs);
+    virtual void copyFrom(const Number& rhs) { copyFrom(cast(rhs)); }
+    void copyFrom(const NumberDouble<T>& rhs) { *this = rhs; }
 
     virtual bool isReal(void)                    const;
     virtual bool isImaginary(void)                const;
@@ -58,31 +73,94 @@ public:
     virtual void modulus(void);
     virtual void argument(void);
 
-    virtual void add(const Number&);
-    virtual void multiply(const Number&);
-    virtual void divideBy(const Number&);
+    virtual void add(const Number& rhs)          { add(cast(rhs));          }
+    virtual void multiply(const Number& rhs)     { multiply(cast(rhs));     }
+    virtual void divideBy(const Number& rhs)     { divideBy(cast(rhs));     }
+    virtual void raiseToPower(const Number& rhs) { raiseToPower(cast(rhs)); }
+    virtual void GCD(const Number& rhs)          { GCD(cast(rhs));          }
     virtual void naturalLog(void);
     virtual void raiseEToSelf(void);
-    virtual void raiseToPower(const Number&);
-    virtual void GCD(const Number&);
+
+    void add(const NumberDouble<T>&);
+    void multiply(const NumberDouble<T>&);
+    void divideBy(const NumberDouble<T>&);
+    void raiseToPower(const NumberDouble<T>&);
+    void GCD(const NumberDouble<T>&);
 
     virtual void makePi(void);
 
     virtual void roundUsingMode(enum RoundingMode roundingMode);
 
+    // Overrides of the optional methods that would otherwise go through
+    // heap allocated temporaries
+    virtual Number* clone(void) const { return new NumberDouble<T>(*this); }
+    virtual Number* cloneInto(void* buffer, size_t size) const
+    {
+        if (size < sizeof(NumberDouble<T>))
+            return NULL;
+        return new (buffer) NumberDouble<T>(*this);
+    }
+
+    virtual Number& operator= (const Number& rhs) { copyFrom(cast(rhs)); return *this; }
+    virtual Number& operator= (double rhs)
+    {
+        realPart = rhs;
+        imaginaryPart = 0;
+        return *this;
+    }
+
+    virtual bool operator<  (double rhs) const { return realPart < T(rhs);                             }
+    virtual bool operator<= (double rhs) const { return realPart < T(rhs) || realPart == T(rhs);       }
+    virtual bool operator>  (double rhs) const { return !(realPart < T(rhs) || realPart == T(rhs));    }
+    virtual bool operator>= (double rhs) const { return !(realPart < T(rhs));                          }
+    virtual bool operator== (double rhs) const { return realPart == T(rhs) && imaginaryPart == 0;      }
+
+    virtual size_t hash(void) const
+    {
+        std::hash<double> hasher;
+        return hasher(toDouble(realPart))*31 + hasher(toDouble(imaginaryPart));
+    }
+    // Below 2^53 an integer converts to a double exactly
+    virtual bool realPartAsInteger(long long& value) const
+    {
+        if (!isRealPartInteger() || !(abs(realPart) < T(9007199254740992.0)))
+            return false;
+        value = static_cast<long long>(toDouble(realPart));
+        return true;
+    }
+
+    virtual bool isIntegral(void) const { return isRealPartInteger() && isImaginaryPartInteger(); }
+    virtual bool isComplex(void)  const { return !(isReal() || isImaginary());                    }
+
+    virtual void makeImaginaryPart(void)
+    {
+        realPart = 0;
+    }
+
+    void subtract(const NumberDouble<T>& rhs)
+    {
+        NumberDouble<T> negated = rhs;
+        negated.negate();
+        add(negated);
+    }
+    virtual void subtract(const Number& rhs) { subtract(cast(rhs)); }
+
+private:
+    // Downcast used by the virtual methods: a tag comparison when rhs is (or
+    // wraps) a NumberDouble<T>, dynamic_cast otherwise
+    static const NumberDouble<T>& cast(const Number& rhs)
+    {
+        const NumberDouble<T>* number = number_static_cast<NumberDouble<T>>(rhs);
+        if (number != NULL)
+            return *number;
+        return number_cast<const NumberDouble<T>&>(rhs);
+    }
+
 protected:
     T realPart;
     T imaginaryPart;
 };
 
-template<typename T>
-void NumberDouble<T>::copyFrom(const Number& _rhs)
-{
-    const NumberDouble<T>& rhs = number_cast<const NumberDouble<T>&>(_rhs);
-
-    realPart = rhs.realPart;
-    imaginaryPart = rhs.imaginaryPart;
-}
 template<typename T>
 bool NumberDouble<T>::isReal(void)              const
 {
@@ -177,25 +255,25 @@ bool NumberDouble<T>::isNotANumber(void)       const
 template<typename T>
 bool NumberDouble<T>::isEqualReals(const Number& _rhs)     const
 {
-    const NumberDouble<T>& rhs = number_cast<const NumberDouble<T>&>(_rhs);
+    const NumberDouble<T>& rhs = cast(_rhs);
     return realPart == rhs.realPart;
 }
 template<typename T>
 bool NumberDouble<T>::isEqualImaginary(const Number& _rhs) const
 {
-    const NumberDouble<T>& rhs = number_cast<const NumberDouble<T>&>(_rhs);
+    const NumberDouble<T>& rhs = cast(_rhs);
     return imaginaryPart == rhs.imaginaryPart;
 }
 template<typename T>
 bool NumberDouble<T>::isLessReals(const Number& _rhs)         const
 {
-    const NumberDouble<T>& rhs = number_cast<const NumberDouble<T>&>(_rhs);
+    const NumberDouble<T>& rhs = cast(_rhs);
     return realPart < rhs.realPart;
 }
 template<typename T>
 bool NumberDouble<T>::isLessImaginaries(const Number& _rhs)         const
 {
-    const NumberDouble<T>& rhs = number_cast<const NumberDouble<T>&>(_rhs);
+    const NumberDouble<T>& rhs = cast(_rhs);
     return imaginaryPart < rhs.imaginaryPart;
 }
 
@@ -239,6 +317,10 @@ void NumberDouble<T>::modulus(void)
     realPart = sqrt(realPart*realPart + imaginaryPart*imaginaryPart);
     imaginaryPart = 0;
 }
+inline double toDouble(double number)
+{
+    return number;
+}
 inline void createPi(double& number)
 {
     number = 3.141592653589793238462643383279;
@@ -279,25 +361,22 @@ void NumberDouble<T>::argument(void)
 }
 
 template<typename T>
-void NumberDouble<T>::add(const Number& _rhs)
+void NumberDouble<T>::add(const NumberDouble<T>& rhs)
 {
-    const NumberDouble<T>& rhs = number_cast<const NumberDouble<T>&>(_rhs);
     realPart += rhs.realPart;
     imaginaryPart += rhs.imaginaryPart;
 }
 template<typename T>
-void NumberDouble<T>::multiply(const Number& _rhs)
+void NumberDouble<T>::multiply(const NumberDouble<T>& rhs)
 {
-    const NumberDouble<T>& rhs = number_cast<const NumberDouble<T>&>(_rhs);
     T _realPart       = realPart*rhs.realPart - imaginaryPart*rhs.imaginaryPart;
     T _imaginaryPart = realPart*rhs.imaginaryPart + imaginaryPart*rhs.realPart;
     realPart = _realPart;
     imaginaryPart = _imaginaryPart;
 }
 template<typename T>
-void NumberDouble<T>::divideBy(const Number& _rhs)
+void NumberDouble<T>::divideBy(const NumberDouble<T>& rhs)
 {
-    const NumberDouble<T>& rhs = number_cast<const NumberDouble<T>&>(_rhs);
     T _realPart      = rhs.realPart;
     T _imaginaryPart = rhs.imaginaryPart;
     T modSquared = _realPart*_realPart + _imaginaryPart*_imaginaryPart;
@@ -332,9 +411,8 @@ void NumberDouble<T>::raiseEToSelf(void)
     imaginaryPart = _imaginaryPart;
 }
 template<typename T>
-void NumberDouble<T>::raiseToPower(const Number& _rhs)
+void NumberDouble<T>::raiseToPower(const NumberDouble<T>& rhs)
 {
-    const NumberDouble<T>& rhs = number_cast<const NumberDouble<T>&>(_rhs);
 
     if (isZero() && !rhs.isZero())
         return;
@@ -380,9 +458,8 @@ inline double gcd(const double& _a, const double& _b)
     return 2*gcd(a/2, b/2);
 }
 template<typename T>
-void NumberDouble<T>::GCD(const Number& _second)
+void NumberDouble<T>::GCD(const NumberDouble<T>& second)
 {
-    const NumberDouble<T>& second = number_cast<const NumberDouble<T>&>(_second);
 
     if (!this->isReal() || !second.isReal())
         throw invalid_argument("arguments not real in NumberDouble<T>::GCD()");
@@ -1,8 +1,12 @@
 #pragma once
 
 #include <math.h>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 #include "Number.hpp"
 #include "NumberProxy.hpp"
+#include "NumberKernels.hpp"
 
 namespace DS {
 namespace CAS {
@@ -42,29 +46,44 @@ public:
         return this->number(number);
     }
 
-    virtual Number* zero(void)      const
-    {
-        return number();
-    }
-    virtual Number* one(void)      const
-    {
-        return number(1.0);
-    }
-    virtual Number* i(void)      const
-    {
-        return number(0,1.0);
-    }
-    virtual Number* negOne(void) const
-    {
-        return number(-1);
-    }
-    virtual Number* two(void)      const
+    // Interned constants.  They are built on first use and kept for the
+    // lifetime of the factory, whose numbers all share one precision, so the
+    // transcendental ones are computed once and none are ever reallocated.
+    // Each is built under its own once_flag, so threads evaluating with one
+    // factory (see ParallelEval) may reach them first at the same time.
+    const Number& zero(void)   const { return smallInteger(0);  }
+    const Number& one(void)    const { return smallInteger(1);  }
+    const Number& negOne(void) const { return smallInteger(-1); }
+    const Number& two(void)    const { return smallInteger(2);  }
+    const Number& ten(void)    const { return smallInteger(10); }
+    const Number& i(void)      const { return constant(I,  0, 1); }
+    const Number& PI(void)     const { return constant(Pi, 0, 0); }
+    const Number& e(void)      const { return constant(E,  0, 0); }
+
+    static constexpr int minSmallInteger = -16;
+    static constexpr int maxSmallInteger =  16;
+
+    // Integers in [minSmallInteger, maxSmallInteger], for digits, counters
+    // and comparisons
+    const Number& smallInteger(int value) const
     {
-        return number(2);
+        if (value < minSmallInteger || value > maxSmallInteger)
+            throw std::out_of_range("value out of range in NumberFactory::smallInteger()");
+        return constant(numberOfConstants + value - minSmallInteger, value, 0);
     }
-    virtual Number* ten(void)      const
+
+    // 10^n, by repeated squaring
+    Proxy::NumberP powerOfTen(unsigned int n) const
     {
-        return number(10);
+        Proxy::NumberP result = one(), square = ten();
+        for (; n > 0; n >>= 1)
+        {
+            if (n & 1)
+                result *= square;
+            if (n > 1)
+                square *= square;
+        }
+        return result;
     }
 
     virtual Number* numberFromRealParts(const Number* realPart, const Number* imaginaryPart) const
@@ -93,13 +112,48 @@ public:
         return number(realPart, imaginaryPart);
     }
 
-    virtual Number* PI(void) const = 0;
-    virtual Number* e(void) const
+    // Kernels used by the reduction passes; factories that know their
+    // concrete number type can override these with statically bound versions
+    virtual void reduceFraction(Proxy::NumberP& num, Proxy::NumberP& den) const
+    {
+        Numbers::reduceFraction(num, den);
+    }
+    virtual void addFraction(Proxy::NumberP& num, Proxy::NumberP& den,
+                             const Proxy::NumberP& num2, const Proxy::NumberP& den2) const
+    {
+        Numbers::addFraction(num, den, num2, den2);
+    }
+
+protected:
+    // Used to build the interned constants
+    virtual Number* makePI(void) const = 0;
+    virtual Number* makeE(void) const
     {
         Number* result = number(1.0);
         result->raiseEToSelf();
         return result;
     }
+
+private:
+    enum { I, Pi, E, numberOfConstants };
+
+    const Number& constant(int index, double realPart, double imaginaryPart) const
+    {
+        std::unique_ptr<const Number>& entry = constants[index];
+        std::call_once(built[index], [&]() {
+            if (index == Pi)
+                entry.reset(makePI());
+            else if (index == E)
+                entry.reset(makeE());
+            else
+                entry.reset(number(realPart, imaginaryPart));
+        });
+        return *entry;
+    }
+
+    enum { numberOfEntries = numberOfConstants + maxSmallInteger - minSmallInteger + 1 };
+    mutable std::unique_ptr<const Number> constants[numberOfEntries];
+    mutable std::once_flag                built[numberOfEntries];
 };
 
 } } }
@@ -33,7 +33,7 @@ Number* NumberFactoryPrototype::number(double realPart = 0, double imaginaryPart
     return prototype->create(realPart, imaginaryPart);
 }
 
-Number* NumberFactoryPrototype::PI(void) const
+Number* NumberFactoryPrototype::makePI(void) const
 {
     Number* result = prototype->create();
     result->makePi();
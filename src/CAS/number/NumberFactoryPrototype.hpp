@@ -17,9 +17,10 @@ public:
     //NumberFactoryPrototype& operator=(const NumberFactoryPrototype&);
 
     virtual Number* number(double realPart, double imaginaryPart) const;
-    virtual Number* PI(void) const;
 
 protected:
+    virtual Number* makePI(void) const;
+
     const Number* prototype;
 };
 
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "NumberFactory.hpp"
+#include "NumberKernels.hpp"
+
+namespace DS {
+namespace CAS {
+namespace Numbers {
+
+// A factory for a single, compile-time known Number implementation N (which
+// must provide staticKind()).  Numbers are created without going through a
+// prototype, and the reduction kernels operate on N directly whenever the
+// operands are N, falling back to the polymorphic versions otherwise.
+template<typename N>
+class NumberFactoryStatic: public NumberFactory
+{
+public:
+    NumberFactoryStatic() {}
+    virtual ~NumberFactoryStatic() {}
+
+    virtual Number* number(double realPart = 0, double imaginaryPart = 0) const
+    {
+        return new N(realPart, imaginaryPart);
+    }
+
+    virtual void reduceFraction(Proxy::NumberP& num, Proxy::NumberP& den) const
+    {
+        N* _num = number_static_cast<N>(num);
+        N* _den = number_static_cast<N>(den);
+        if (_num == NULL || _den == NULL)
+            return NumberFactory::reduceFraction(num, den);
+        Numbers::reduceFraction(*_num, *_den);
+    }
+    virtual void addFraction(Proxy::NumberP& num, Proxy::NumberP& den,
+                             const Proxy::NumberP& num2, const Proxy::NumberP& den2) const
+    {
+        N*       _num  = number_static_cast<N>(num);
+        N*       _den  = number_static_cast<N>(den);
+        const N* _num2 = number_static_cast<N>(num2);
+        const N* _den2 = number_static_cast<N>(den2);
+        if (_num == NULL || _den == NULL || _num2 == NULL || _den2 == NULL)
+            return NumberFactory::addFraction(num, den, num2, den2);
+        Numbers::addFraction(*_num, *_den, *_num2, *_den2);
+    }
+
+protected:
+    virtual Number* makePI(void) const
+    {
+        N* result = new N();
+        result->makePi();
+        return result;
+    }
+};
+
+} } }
@@ -22,6 +22,13 @@ public:
     virtual ~NumberFormatter() { }
 
     virtual Number*              format(const string&) = 0;
+    // Also gives the number of digits written after the decimal point, net
+    // of the exponent: the number times ten to that many is an integer
+    virtual Number*              format(const string& aString, unsigned int& decimalPlaces)
+    {
+        decimalPlaces = 0;
+        return format(aString);
+    }
     virtual pair<string, string> format(const Number& number)
     {
         pair<string,string> result;
@@ -7,11 +7,6 @@
 #include "NumberFormatterStandard.hpp"
 #include "NumberDouble.hpp"
 
-#include "tokenizer.hpp"
-#include "scanner-builder.hpp"
-
-using namespace castle;
-
 namespace DS      {
 namespace CAS     {
 namespace Numbers {
@@ -24,6 +19,9 @@ string NumberFormatterStandard::formatRealPart(const Number& _number)
     if (intSizeLimit.isNegativeReal())
         intSizeLimit = format("1e20");
 
+    long long integer;
+    if (_number.realPartAsInteger(integer))
+        return to_string(integer);
     if (_number.isRealPartInteger())
         if (_number.isLessReals(intSizeLimit))
             return formatRealDecimal(_number, 21);
@@ -32,7 +30,7 @@ string NumberFormatterStandard::formatRealPart(const Number& _number)
 
 string NumberFormatterStandard::formatRealDecimal(const Number& _number, unsigned int maxSigDigits)
 {
-    NumberP ten = factory->ten();
+    const Number& ten = factory->ten();
     NumberP one = factory->one();
     NumberP buffer = factory->number(.1);
 
@@ -54,7 +52,7 @@ string NumberFormatterStandard::formatRealDecimal(const Number& _number, unsigne
         return result;
     }
 
-    NumberP order = factory->number(-1), nextOrder = factory->one();
+    NumberP order = factory->negOne(), nextOrder = factory->one();
     unsigned int sigFigs = 0;
 
     while (number >= nextOrder)
@@ -197,7 +195,8 @@ string NumberFormatterStandard::formatRealScientific(const Number& _number, unsi
         negativeFlag = true;
     }
 
-    NumberP tenThousand = factory->number(10000.0), one = factory->one(), ten = factory->ten();
+    NumberP tenThousand = factory->number(10000.0), one = factory->one();
+    const Number& ten = factory->ten();
     NumberP oneTenThousanth = one/tenThousand, oneTenth = one/ten;
 
     if (number.isLessReals(oneTenThousanth))
@@ -253,155 +252,137 @@ string NumberFormatterStandard::formatRealScientific(const Number& _number, unsi
     }
 }
 
-void NumberFormatterStandard::buildScanners(void)
+Number* NumberFormatterStandard::format(const string& _number)
 {
-    //enum {spaces1, scientific, img, spaces2}; real/img scientific
-    //enum {number, exp}; real scientific
-    //enum {neg, whole, point, fraction}; real float
-
-    sBuilder->spaces();
-    optionalFlags.push_back(true);
-    scanners.push_back(sBuilder->pop());
-    sBuilder->float_scientific();
-    sBuilder->float_number();
-    sBuilder->or_list(2);
-    optionalFlags.push_back(false);
-    scanners.push_back(sBuilder->pop());
-    sBuilder->char_string("i");
-    optionalFlags.push_back(true);
-    scanners.push_back(sBuilder->pop());
-    sBuilder->spaces();
-    optionalFlags.push_back(true);
-    scanners.push_back(sBuilder->pop());
-
-    sBuilder->float_number();
-    realScientificOptionalFlags.push_back(false);
-    realScientificScanners.push_back(sBuilder->pop());
-    sBuilder->char_string("e");
-    sBuilder->push_flag(false);
-    sBuilder->integer();
-    sBuilder->push_flag(false);
-    sBuilder->optional_list(2);
-    realScientificOptionalFlags.push_back(true);
-    realScientificScanners.push_back(sBuilder->pop());
-
-    sBuilder->char_string("-");
-    realFloatOptionalFlags.push_back(true);
-    realFloatScanners.push_back(sBuilder->pop());
-    sBuilder->pos_integer();
-    realFloatOptionalFlags.push_back(true);
-    realFloatScanners.push_back(sBuilder->pop());
-    sBuilder->char_string(".");
-    realFloatOptionalFlags.push_back(true);
-    realFloatScanners.push_back(sBuilder->pop());
-    sBuilder->pos_integer();
-    realFloatOptionalFlags.push_back(true);
-    realFloatScanners.push_back(sBuilder->pop());
+    unsigned int decimalPlaces;
+    return format(_number, decimalPlaces);
 }
 
-Number* NumberFormatterStandard::format(const string& _number)
+// [spaces] [-] (digits [. [digits]] | . digits) [e [-] digits] [i] [spaces]
+//
+// The digits, with the point dropped, are read as one integer, so the
+// number is that integer times a power of ten and is exact whenever the
+// integer fits in the precision.
+Number* NumberFormatterStandard::format(const string& _number, unsigned int& decimalPlaces)
 {
-    enum {spaces1, scientific, img, spaces2};
+    const char* it  = _number.data();
+    const char* end = it + _number.size();
+    auto isSpace = [](char c) { return c == ' ' || c == '\t' || c == '\n'; };
+    auto isDigit = [](char c) { return c >= '0' && c <= '9'; };
 
-    if (scanners.size() == 0)
-        buildScanners();
+    while (it != end && isSpace(*it))
+        ++it;
+    bool negative = (it != end && *it == '-');
+    if (negative)
+        ++it;
 
-    tokenizer t;
-    vector<token> tokens;
-    if (!t.tokenize_ordered(_number, scanners, optionalFlags, tokens, true))
+    // Skip the leading zeros, and keep the position of the point
+    string digits;
+    long exponent = 0;
+    bool anyDigits = false;
+    for (; it != end && isDigit(*it); ++it)
+    {
+        anyDigits = true;
+        if (*it != '0' || !digits.empty())
+            digits += *it;
+    }
+    if (it != end && *it == '.')
+        for (++it; it != end && isDigit(*it); ++it)
+        {
+            anyDigits = true;
+            if (*it != '0' || !digits.empty())
+                digits += *it;
+            exponent--;
+        }
+    if (!anyDigits)
         return NULL;
 
-    NumberP result = formatRealScientific(tokens[scientific].string());
-    if (tokens[img].string() != "")
+    if (it != end && *it == 'e')
+    {
+        ++it;
+        bool negativeExponent = (it != end && *it == '-');
+        if (negativeExponent)
+            ++it;
+        if (it == end || !isDigit(*it))
+            return NULL;
+        long written = 0;
+        for (; it != end && isDigit(*it); ++it)
+        {
+            written = written*10 + (*it - '0');
+            if (written > 100000000)
+                return NULL;
+        }
+        exponent += negativeExponent ? -written : written;
+    }
+    bool imaginary = (it != end && *it == 'i');
+    if (imaginary)
+        ++it;
+    while (it != end && isSpace(*it))
+        ++it;
+    if (it != end)
+        return NULL;
+
+    // Trailing zeros after the point are only a larger power of ten
+    while (exponent < 0 && !digits.empty() && digits.back() == '0')
+    {
+        digits.pop_back();
+        exponent++;
+    }
+    if (digits.empty())
+        exponent = 0;
+
+    NumberP result = formatRealInteger(digits.data(), digits.size());
+    decimalPlaces = 0;
+    if (exponent > 0)
+        result *= factory->powerOfTen(exponent);
+    else if (exponent < 0)
+    {
+        decimalPlaces = -exponent;
+        result /= factory->powerOfTen(decimalPlaces);
+    }
+    if (negative)
+        result.negate();
+    if (imaginary)
         result.multiplyByImaginaryUnit();
 
     return result.clone();
 }
-Numbers::Proxy::NumberP NumberFormatterStandard::formatRealScientific(const string& _number)
-{
-    enum {number, exp};
-
-    if (realScientificScanners.size() == 0)
-        buildScanners();
 
-    tokenizer t;
-    vector<token> tokens;
-    if (!t.tokenize_ordered(_number, realScientificScanners, realScientificOptionalFlags, tokens, true))
-        throw invalid_argument("Tokenizer failed in NumberFormatterStandard::formatRealScientific()");
-
-    string numberString = tokens[number].string();
-
-    NumberP result = formatRealFloat(numberString);
+// Divide and conquer, so that the multiplications are few and balanced: the
+// low digits are a whole number of chunks, 2^k of them, below the high ones
+NumberP NumberFormatterStandard::formatRealInteger(const char* digits, size_t count)
+{
+    static const size_t digitsPerChunk = 9;
 
-    if (tokens[exp].string() != "")
+    if (count <= digitsPerChunk)
     {
-        NumberP zero = factory->zero(), one = factory->one(), ten = factory->ten();
-        string exponentString(tokens[exp].string().begin()+1, tokens[exp].string().end());
-        NumberP exponent = formatRealInteger(exponentString);
-        bool negateFlag = false;
-        if (exponent.isLessReals(zero))
+        NumberP result = factory->zero();
+        const Number& ten = factory->ten();
+        for (size_t i = 0; i < count; i++)
         {
-            negateFlag = true;
-            exponent.negate();
+            if (i > 0)
+                result *= ten;
+            result += factory->smallInteger(digits[i] - '0');
         }
-        NumberP multiplier = one;
-        for (NumberP i = zero; i < exponent; ++i)
-            multiplier.multiply(ten);
-        if (negateFlag)
-            multiplier.invert();
-        result.multiply(multiplier);
+        return result;
     }
-    return result;
-}
-Numbers::Proxy::NumberP NumberFormatterStandard::formatRealFloat(const string& _number)
-{
-    // Assumes a valid real float format -1234.4321, .456, 876, etc.
-
-    enum {neg, whole, point, fraction};
 
-    if (realFloatScanners.size() == 0)
-        buildScanners();
-
-    tokenizer t;
-    vector<token> tokens;
-    if (!t.tokenize_ordered(_number, realFloatScanners, realFloatOptionalFlags, tokens, true))
-        throw invalid_argument("Tokenizer failed in NumberFormatterStandard::formatRealFloat()");
-
-    NumberP wholePart = factory->zero(), fracPart = factory->zero();
-    if (tokens[whole].string() != "")
-        wholePart = formatRealInteger(tokens[whole].string());
-    if (tokens[fraction].string() != "")
+    size_t k = 0, low = digitsPerChunk;
+    while (2*low < count)
     {
-        fracPart = formatRealInteger(tokens[fraction].string());
-        NumberP one = factory->one(), ten = factory->ten();
-        NumberP powerOfTen = one, oneTenth = one/ten;
-        unsigned int numberOfDigits = tokens[fraction].string().length();
-        for (unsigned int i = 0; i < numberOfDigits; i++)
-            powerOfTen *= oneTenth;
-        fracPart.multiply(powerOfTen);
+        low *= 2;
+        k++;
     }
-    NumberP result = wholePart + fracPart;
-    if (tokens[neg].string() != "")
-        result.negate();
-    return result;
-}
-NumberP NumberFormatterStandard::formatRealInteger(const string& _number)
-{
-    // Assumes _number is valid
-
-    NumberP result = factory->zero(), ten = factory->ten();
-    string::const_iterator it = _number.begin();
-    if (*it == '-')
-        ++it;
-    while (1)
+    while (chunkPowers.size() <= k)
     {
-        result += NumberP(factory->number(double(*it++ - '0')));
-        if (it == _number.end())
-            break;
-        result *= ten;
+        if (chunkPowers.empty())
+            chunkPowers.push_back(factory->powerOfTen(digitsPerChunk));
+        else
+            chunkPowers.push_back(chunkPowers.back()*chunkPowers.back());
     }
-    if (_number[0] == '-')
-        result.negate();
+    NumberP result = formatRealInteger(digits, count - low);
+    result *= chunkPowers[k];
+    result += formatRealInteger(digits + count - low, low);
     return result;
 }
 
@@ -28,6 +28,7 @@ public:
 
     virtual string  formatRealPart(const Number&);
     virtual Number* format(const string&);
+    virtual Number* format(const string&, unsigned int& decimalPlaces);
 
     unsigned int getSigFigs(void) const;
     void setSigFigs(unsigned int _sigFigs) { maximumSigFigs = _sigFigs; }
@@ -36,21 +37,13 @@ protected:
     shared_ptr<castle::scanner_builder> sBuilder;
     unsigned int maximumSigFigs;
 
-    void buildScanners(void);
-    Numbers::Proxy::NumberP formatRealInteger(const string&);
-    Numbers::Proxy::NumberP formatRealFloat(const string&);
-    Numbers::Proxy::NumberP formatRealScientific(const string&);
+    Numbers::Proxy::NumberP formatRealInteger(const char* digits, size_t count);
 
     string formatRealDecimal(const Number& _number, unsigned int maxSigDigits);
     string formatRealScientific(const Number& _number, unsigned int maxSigDigits);
 
-    vector<castle::scanner::ptr> scanners;
-    vector<bool> optionalFlags;
-
-    vector<castle::scanner::ptr> realScientificScanners;
-    vector<bool> realScientificOptionalFlags;
-    vector<castle::scanner::ptr> realFloatScanners;
-    vector<bool> realFloatOptionalFlags;
+    // 10^(digitsPerChunk*2^k), for formatRealInteger
+    vector<Numbers::Proxy::NumberP> chunkPowers;
 };
 
 } } }
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdexcept>
+#include "Number.hpp"
+
+namespace DS {
+namespace CAS {
+namespace Numbers {
+
+// Arithmetic kernels shared by the reduction passes.  They are written
+// against the Number interface but templated on the concrete type, so when
+// instantiated with a final class (e.g. NumberDouble<T>) every call is bound
+// statically and the temporaries live on the stack.
+
+// Divides numerator and denominator by their (gaussian) gcd
+template<typename N>
+void reduceFraction(N& litNum, N& litDen)
+{
+    if (litDen.isZero())
+    {
+        if (!litNum.isZero())
+            litNum = 1.0;
+        return;
+    }
+    if (!litNum.isRealPartInteger() || !litNum.isImaginaryPartInteger() ||
+        !litDen.isRealPartInteger() || !litDen.isImaginaryPartInteger())
+        throw std::logic_error("parameters not integer in CAS::Numbers::reduceFraction()");
+    N gcd = litDen;
+    if (gcd.isComplex())
+        throw std::logic_error("gcd is complex in CAS::Numbers::reduceFraction()");
+    if (gcd.isImaginary())
+        gcd.exchangeRealAndImaginary();
+    if (gcd.isNegativeReal())
+        gcd.negate();
+    N litNumReal = litNum;
+    N litNumImg  = litNum;
+    litNumReal.makeRealPart();
+    litNumImg.exchangeRealAndImaginary();
+    litNumImg.makeRealPart();
+    if (litNumReal.isNegativeReal())
+        litNumReal.negate();
+    if (litNumImg.isNegativeReal())
+        litNumImg.negate();
+
+    if (!litNumReal.isZero())
+        gcd.GCD(litNumReal);
+    if (!litNumImg.isZero())
+        gcd.GCD(litNumImg);
+
+    litNum.divideBy(gcd);
+    litDen.divideBy(gcd);
+
+    litNum.roundUsingMode(Number::RoundClosest);
+    litDen.roundUsingMode(Number::RoundClosest);
+}
+
+// num/den += num2/den2, without reducing
+template<typename N>
+void addFraction(N& num, N& den, const N& num2, const N& den2)
+{
+    N cross = num2;
+    cross.multiply(den);
+    num.multiply(den2);
+    num.add(cross);
+    den.multiply(den2);
+}
+
+} } }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iostream>
+#include <cstddef>
 #include "Number.hpp"
 
 namespace DS {
@@ -8,21 +9,37 @@ namespace CAS {
 namespace Numbers {
 namespace Proxy { // to prevent strange compiler errors
 
+// NumberProxy gives value semantics to a Number.  Payloads that provide
+// cloneInto() and fit in inline_size bytes are stored inside the proxy;
+// anything else lives on the heap and is shared between copies of the proxy
+// until one of them is mutated (copy-on-write).
 class NumberProxy : public Number {
 public:
+    static constexpr size_t inline_size = 128;
+
+    // Counts of how payloads were obtained, for checking that hot paths do
+    // not allocate.  heap counts payloads allocated by or handed to a proxy.
+    // The counts are kept for each thread, of the proxies it works on.
+    struct Counters
+    {
+        unsigned long heap;
+        unsigned long inlined;
+        unsigned long shared;
+        unsigned long unshared;
+    };
+    static Counters& counters(void) { static thread_local Counters c = {0, 0, 0, 0}; return c; }
 
-    // NumberProxy owns the number that you give it and will free on destruction
     NumberProxy(const NumberProxy& aNumberProxy) // need this otherwise compiler generates a default version
-        : Number() {
-        number = aNumberProxy.clone();
+        : Number(staticKind()) {
+        assign(aNumberProxy);
     }
 
-    NumberProxy(const Number& aNumber) { number = aNumber.clone(); }
-    NumberProxy(Number* aNumber)       { number = aNumber;         }
+    NumberProxy(const Number& aNumber) : Number(staticKind()) { assign(aNumber); }
+    NumberProxy(Number* aNumber)       : Number(staticKind()) { adopt(aNumber); }
 
     NumberProxy& operator= (Number* aNumber) {
-        delete number;
-        number = aNumber;
+        release();
+        adopt(aNumber);
         return *this;
     }
 
@@ -30,14 +47,21 @@ public:
         return operator=(static_cast<const Number&>(aNumber));
     }
 
-    virtual ~NumberProxy() { delete number; }
+    virtual ~NumberProxy() { release(); }
 
     virtual bool isValid(void) const { return (number != NULL); }
 
+    static NumberKind staticKind(void) { static const char tag = 0; return &tag; }
+
+    // The wrapped number, reached without a virtual call.  The non-const
+    // version unshares the payload since the caller may modify it.
+    Number*       get(void)       { detach(); return number; }
+    const Number* get(void) const { return number; }
+
     // Fowarded methods
     virtual Number* create(double realPart = 0, double imaginaryPart = 0) const { return number->create(realPart, imaginaryPart); }
 
-    virtual void copyFrom(const Number& rhs) { number->copyFrom(rhs); }
+    virtual void copyFrom(const Number& rhs) { detach(); number->copyFrom(rhs); }
 
     virtual bool isReal                 ( void ) const { return number->isReal();                 }
     virtual bool isImaginary            ( void ) const { return number->isImaginary();            }
@@ -70,54 +94,67 @@ public:
     virtual bool operator>         ( double rhs        ) const { return number->operator>         ( rhs ); }
     virtual bool operator>=        ( double rhs        ) const { return number->operator>=        ( rhs ); }
 
-    virtual void negate                   ( void ) { number->negate();                   }
-    virtual void conjugate                ( void ) { number->conjugate();                }
-    virtual void makeRealPart             ( void ) { number->makeRealPart();             }
-    virtual void exchangeRealAndImaginary ( void ) { number->exchangeRealAndImaginary(); }
-    virtual void modulusSquared           ( void ) { number->modulusSquared();           }
-    virtual void modulus                  ( void ) { number->modulus();                  }
-    virtual void argument                 ( void ) { number->argument();                 }
-
-    virtual void add          ( const Number& rhs    ) { number->add          ( rhs    ) ; }
-    virtual void multiply     ( const Number& rhs    ) { number->multiply     ( rhs    ) ; }
-    virtual void divideBy     ( const Number& rhs    ) { number->divideBy     ( rhs    ) ; }
-    virtual void naturalLog   ( void                 ) { number->naturalLog   (        ) ; }
-    virtual void raiseEToSelf ( void                 ) { number->raiseEToSelf (        ) ; }
-    virtual void raiseToPower ( const Number& rhs    ) { number->raiseToPower ( rhs    ) ; }
-    virtual void GCD          ( const Number& second ) { number->GCD          ( second ) ; }
-    virtual void makePi       ( void                 ) { number->makePi       (        ) ; }
-
-    virtual Number& operator+= ( const Number& rhs ) { return number->operator+= ( rhs ) ; }
-    virtual Number& operator-= ( const Number& rhs ) { return number->operator-= ( rhs ) ; }
-    virtual Number& operator*= ( const Number& rhs ) { return number->operator*= ( rhs ) ; }
-    virtual Number& operator/= ( const Number& rhs ) { return number->operator/= ( rhs ) ; }
-    virtual Number& operator+= ( double        rhs ) { return number->operator+= ( rhs ) ; }
-    virtual Number& operator-= ( double        rhs ) { return number->operator-= ( rhs ) ; }
-    virtual Number& operator*= ( double        rhs ) { return number->operator*= ( rhs ) ; }
-    virtual Number& operator/= ( double        rhs ) { return number->operator/= ( rhs ) ; }
-
-    virtual Number& operator++ (void) { return number->operator++(); }
-    virtual Number& operator-- (void) { return number->operator--(); }
-
-    virtual void roundUsingMode(enum RoundingMode roundingMode) { number->roundUsingMode(roundingMode); }
+    virtual void negate                   ( void ) { detach(); number->negate();                   }
+    virtual void conjugate                ( void ) { detach(); number->conjugate();                }
+    virtual void makeRealPart             ( void ) { detach(); number->makeRealPart();             }
+    virtual void exchangeRealAndImaginary ( void ) { detach(); number->exchangeRealAndImaginary(); }
+    virtual void modulusSquared           ( void ) { detach(); number->modulusSquared();           }
+    virtual void modulus                  ( void ) { detach(); number->modulus();                  }
+    virtual void argument                 ( void ) { detach(); number->argument();                 }
+
+    virtual void add          ( const Number& rhs    ) { detach(); number->add          ( rhs    ) ; }
+    virtual void multiply     ( const Number& rhs    ) { detach(); number->multiply     ( rhs    ) ; }
+    virtual void divideBy     ( const Number& rhs    ) { detach(); number->divideBy     ( rhs    ) ; }
+    virtual void naturalLog   ( void                 ) { detach(); number->naturalLog   (        ) ; }
+    virtual void raiseEToSelf ( void                 ) { detach(); number->raiseEToSelf (        ) ; }
+    virtual void raiseToPower ( const Number& rhs    ) { detach(); number->raiseToPower ( rhs    ) ; }
+    virtual void GCD          ( const Number& second ) { detach(); number->GCD          ( second ) ; }
+    virtual void makePi       ( void                 ) { detach(); number->makePi       (        ) ; }
+
+    virtual Number& operator+= ( const Number& rhs ) { detach(); return number->operator+= ( rhs ) ; }
+    virtual Number& operator-= ( const Number& rhs ) { detach(); return number->operator-= ( rhs ) ; }
+    virtual Number& operator*= ( const Number& rhs ) { detach(); return number->operator*= ( rhs ) ; }
+    virtual Number& operator/= ( const Number& rhs ) { detach(); return number->operator/= ( rhs ) ; }
+    virtual Number& operator+= ( double        rhs ) { detach(); return number->operator+= ( rhs ) ; }
+    virtual Number& operator-= ( double        rhs ) { detach(); return number->operator-= ( rhs ) ; }
+    virtual Number& operator*= ( double        rhs ) { detach(); return number->operator*= ( rhs ) ; }
+    virtual Number& operator/= ( double        rhs ) { detach(); return number->operator/= ( rhs ) ; }
+
+    virtual Number& operator++ (void) { detach(); return number->operator++(); }
+    virtual Number& operator-- (void) { detach(); return number->operator--(); }
+
+    virtual void roundUsingMode(enum RoundingMode roundingMode) { detach(); number->roundUsingMode(roundingMode); }
 
     virtual const Number& implementation(void) const { return number->implementation();  }
+    virtual size_t hash(void) const { return number->hash(); }
+    virtual bool realPartAsInteger(long long& value) const { return number->realPartAsInteger(value); }
     virtual Number& operator= (const Number& rhs)
     {
-        *number = rhs;
+        if (&rhs == this)
+            return *this;
+        // write through a payload we own alone, unless rhs can simply be shared
+        bool shareable = rhs.getKind() == staticKind() && !static_cast<const NumberProxy&>(rhs).inlined;
+        if (number != NULL && !shareable && (inlined || number->references == 1))
+        {
+            *number = rhs;
+            return *this;
+        }
+        release();
+        assign(rhs);
         return *this;
     }
-    virtual Number& operator= (double rhs) { return number->operator= (rhs); }
+    virtual Number& operator= (double rhs) { detach(); return number->operator= (rhs); }
 
     virtual Number* clone(void) const { return number->clone();    }
+    virtual Number* cloneInto(void* buffer, size_t size) const { return number->cloneInto(buffer, size); }
 
     virtual bool isIntegral              ( void) const { return number->isIntegral                          ( ); }
     virtual bool isComplex               ( void) const { return number->isComplex                           ( ); }
     virtual bool isFiniteAndExists       ( void) const { return number->isFiniteAndExists                   ( ); }
 
-    virtual void imaginaryPart           ( void) { number->imaginaryPart                                    ( ); }
-    virtual void fractionalPart          ( void) { number->fractionalPart                                   ( ); }
-    virtual void makeImaginaryPart       ( void) { number->makeImaginaryPart                                ( ); }
+    virtual void imaginaryPart           ( void) { detach(); number->imaginaryPart                                    ( ); }
+    virtual void fractionalPart          ( void) { detach(); number->fractionalPart                                   ( ); }
+    virtual void makeImaginaryPart       ( void) { detach(); number->makeImaginaryPart                                ( ); }
 
     virtual bool operator==              ( const Number& rhs ) const { return number->operator==            ( rhs ) ; }
     virtual bool operator==              ( double        rhs ) const { return number->operator==            ( rhs ) ; }
@@ -125,31 +162,114 @@ public:
     virtual bool isGreaterReals          ( const Number& rhs )       { return number->isGreaterReals        ( rhs ) ; }
     virtual bool isGreaterOrEqualReals   ( const Number& rhs )       { return number->isGreaterOrEqualReals ( rhs ) ; }
 
-    virtual void decRealPart             ( void               ) { number->decRealPart                       (      ) ; }
-    virtual void divideByTen             ( void               ) { number->divideByTen                       (      ) ; }
-    virtual void divideByTwo             ( void               ) { number->divideByTwo                       (      ) ; }
-    virtual void incRealPart             ( void               ) { number->incRealPart                       (      ) ; }
-    virtual void invert                  ( void               ) { number->invert                            (      ) ; }
-    virtual void logWithBase             ( const Number& base ) { number->logWithBase                       ( base ) ; }
-    virtual void logWithBaseTen          ( void               ) { number->logWithBaseTen                    (      ) ; }
-    virtual void logWithBaseTwo          ( void               ) { number->logWithBaseTwo                    (      ) ; }
-    virtual void multiplyByImaginaryUnit ( void               ) { number->multiplyByImaginaryUnit           (      ) ; }
-    virtual void multiplyByTen           ( void               ) { number->multiplyByTen                     (      ) ; }
-    virtual void multiplyByTwo           ( void               ) { number->multiplyByTwo                     (      ) ; }
-    virtual void raiseBaseToSelf         ( const Number& base ) { number->raiseBaseToSelf                   ( base ) ; }
-    virtual void squareRoot              ( void               ) { number->squareRoot                        (      ) ; }
-    virtual void square                  ( void               ) { number->square                            (      ) ; }
-    virtual void subtract                ( const Number& rhs  ) { number->subtract                          ( rhs  ) ; }
-
-    virtual void rotateByRealPartOfNumber(const Number& angle) { number->rotateByRealPartOfNumber(angle); }
+    virtual void decRealPart             ( void               ) { detach(); number->decRealPart                       (      ) ; }
+    virtual void divideByTen             ( void               ) { detach(); number->divideByTen                       (      ) ; }
+    virtual void divideByTwo             ( void               ) { detach(); number->divideByTwo                       (      ) ; }
+    virtual void incRealPart             ( void               ) { detach(); number->incRealPart                       (      ) ; }
+    virtual void invert                  ( void               ) { detach(); number->invert                            (      ) ; }
+    virtual void logWithBase             ( const Number& base ) { detach(); number->logWithBase                       ( base ) ; }
+    virtual void logWithBaseTen          ( void               ) { detach(); number->logWithBaseTen                    (      ) ; }
+    virtual void logWithBaseTwo          ( void               ) { detach(); number->logWithBaseTwo                    (      ) ; }
+    virtual void multiplyByImaginaryUnit ( void               ) { detach(); number->multiplyByImaginaryUnit           (      ) ; }
+    virtual void multiplyByTen           ( void               ) { detach(); number->multiplyByTen                     (      ) ; }
+    virtual void multiplyByTwo           ( void               ) { detach(); number->multiplyByTwo                     (      ) ; }
+    virtual void raiseBaseToSelf         ( const Number& base ) { detach(); number->raiseBaseToSelf                   ( base ) ; }
+    virtual void squareRoot              ( void               ) { detach(); number->squareRoot                        (      ) ; }
+    virtual void square                  ( void               ) { detach(); number->square                            (      ) ; }
+    virtual void subtract                ( const Number& rhs  ) { detach(); number->subtract                          ( rhs  ) ; }
+
+    virtual void rotateByRealPartOfNumber(const Number& angle) { detach(); number->rotateByRealPartOfNumber(angle); }
 
 protected:
     NumberProxy();
+
+    // Takes ownership of a heap allocated number
+    void adopt(Number* aNumber)
+    {
+        number = aNumber;
+        inlined = false;
+        if (number != NULL)
+        {
+            number->references = 1;
+            ++counters().heap;
+        }
+    }
+    // Copies (or shares) aNumber into this proxy, which must be empty
+    void assign(const Number& aNumber)
+    {
+        if (aNumber.getKind() == staticKind())
+        {
+            const NumberProxy& proxy = static_cast<const NumberProxy&>(aNumber);
+            if (proxy.number != NULL && !proxy.inlined)
+            {
+                number = proxy.number;
+                inlined = false;
+                ++number->references;
+                ++counters().shared;
+                return;
+            }
+            if (proxy.number == NULL)
+            {
+                number = NULL;
+                inlined = false;
+                return;
+            }
+        }
+        number = aNumber.cloneInto(buffer, inline_size);
+        inlined = (number != NULL);
+        if (inlined)
+            ++counters().inlined;
+        else
+            adopt(aNumber.clone());
+    }
+    void release(void)
+    {
+        if (number == NULL)
+            return;
+        if (inlined)
+            number->~Number();
+        else if (--number->references == 0)
+            delete number;
+        number = NULL;
+    }
+    // Gives this proxy its own copy of a shared payload before mutation.
+    // The copy is taken before letting go of the shared payload, which
+    // another thread may otherwise find unshared and change meanwhile.
+    void detach(void)
+    {
+        if (number == NULL || inlined || number->references == 1)
+            return;
+        Number* shared = number;
+        ++counters().unshared;
+        assign(*shared);
+        if (--shared->references == 0)
+            delete shared;
+    }
+
     Number* number;
+    bool inlined;
+    alignas(std::max_align_t) unsigned char buffer[inline_size];
 };
 
 typedef NumberProxy NumberP;
 
+} // namespace Proxy
+
+// number_static_cast for a Number that may be modified: a proxy's payload
+// is unshared, since the caller may change it through the result
+template<typename TO>
+inline TO* number_static_cast(Number& from)
+{
+    Number* number = &from;
+    while (number->getKind() == Proxy::NumberProxy::staticKind())
+        number = static_cast<Proxy::NumberProxy*>(number)->get();
+    if (number->getKind() != TO::staticKind())
+        return NULL;
+    return static_cast<TO*>(number);
+}
+
+namespace Proxy {
+
 inline NumberProxy operator+ (const NumberProxy& lhs, const NumberProxy& rhs) {
     NumberProxy result = lhs;
     result += rhs;
@@ -0,0 +1,419 @@
+#include <algorithm>
+#include <stdexcept>
+#include "Conversion.hpp"
+#include "Builder.hpp"
+#include "NumberFactory.hpp"
+#include "Structure.hpp"
+#include "exprs.hpp"
+
+namespace DS            {
+namespace CAS           {
+namespace Polynomials   {
+
+using Expressions::Expr;
+using Expressions::ID;
+using Expressions::Sign;
+
+namespace {
+
+typedef DS::Numbers::BaseArray::unit_t unit_t;
+
+// Powers beyond this are left alone rather than expanded
+const double maxPower = 1000;
+
+bool isRealInteger(const Numbers::Number& number)
+{
+    return number.isReal() && number.isRealPartInteger() && number.isFiniteAndExists();
+}
+
+const Numbers::Number& literalNumber(const Expr& exp)
+{
+    return static_cast<const Expressions::Literal&>(exp).getNumber();
+}
+
+// The operands read() takes apart: not the exponent of a power or the
+// divisor of a quotient
+size_t operands(const Expr& exp)
+{
+    if (exp.id() == ID::power || exp.id() == ID::divide)
+        return 1;
+    return exp.numberOfChildren();
+}
+
+// a/d + b/e over the least common denominator; subtracts if asked
+void addTo(Rational& sum, const Rational& term, bool subtract)
+{
+    if (sum.denominator == term.denominator)
+    {
+        if (subtract)
+            sum.numerator -= term.numerator;
+        else
+            sum.numerator += term.numerator;
+        return;
+    }
+    Integer common = gcd(sum.denominator, term.denominator);
+    Integer toSum  = term.denominator / common;
+    Integer toTerm = sum.denominator / common;
+    Sparse scaled = term.numerator;
+    scaled *= toTerm;
+    sum.numerator *= toSum;
+    sum.denominator *= toSum;
+    if (subtract)
+        sum.numerator -= scaled;
+    else
+        sum.numerator += scaled;
+    sum.normalize();
+}
+
+} // namespace
+
+bool toInteger(const Numbers::Number& number, Integer& value)
+{
+    if (!isRealInteger(number))
+        return false;
+    Numbers::Proxy::NumberP magnitude = number;
+    bool negative = magnitude.isNegativeReal();
+    if (negative)
+        magnitude.negate();
+
+    // A bit at a time, least significant first
+    std::vector<unit_t> units;
+    unit_t unit = 0;
+    unsigned int bit = 0;
+    while (!magnitude.isZero())
+    {
+        magnitude.divideByTwo();
+        if (!magnitude.isRealPartInteger())
+        {
+            unit |= unit_t(1) << bit;
+            magnitude.roundUsingMode(Numbers::Number::RoundDown);
+        }
+        if (++bit == 64)
+        {
+            units.push_back(unit);
+            unit = 0;
+            bit = 0;
+        }
+    }
+    if (bit != 0)
+        units.push_back(unit);
+
+    value = Integer();
+    for (std::vector<unit_t>::reverse_iterator it = units.rbegin(); it != units.rend(); ++it)
+    {
+        value.shiftLeftByUnits(1);
+        value += Integer(*it);
+    }
+    if (negative)
+        value.negate();
+    return true;
+}
+
+Numbers::Proxy::NumberP toNumber(const Integer& value, const Numbers::NumberFactory& nF)
+{
+    Integer magnitude = value;
+    magnitude.makeAbs();
+    std::vector<unit_t> units;
+    while (bool(magnitude))
+    {
+        units.push_back(magnitude.getModByOneUnit());
+        magnitude.shiftRightByUnits(1);
+    }
+
+    Numbers::Proxy::NumberP result = nF.zero();
+    if (units.size() == 1 && units[0] < (unit_t(1) << 53))
+        result = nF.number(double(units[0]));
+    else if (!units.empty())
+    {
+        // Half a unit at a time, since a double holds 53 bits
+        Numbers::Proxy::NumberP half = nF.number(4294967296.0);
+        for (std::vector<unit_t>::reverse_iterator it = units.rbegin(); it != units.rend(); ++it)
+        {
+            result.multiply(half);
+            result.add(Numbers::Proxy::NumberP(nF.number(double(*it >> 32))));
+            result.multiply(half);
+            result.add(Numbers::Proxy::NumberP(nF.number(double(*it & 0xffffffffu))));
+        }
+    }
+    if (value.isNegative())
+        result.negate();
+    return result;
+}
+
+void Rational::normalize(void)
+{
+    if (numerator.isZero())
+    {
+        denominator = Integer(1);
+        return;
+    }
+    if (denominator == Integer(1))
+        return;
+    Integer common = gcd(numerator.content(), denominator);
+    if (common == Integer(1))
+        return;
+    numerator /= common;
+    denominator /= common;
+}
+
+bool isPolynomialNode(const Expr& exp)
+{
+    switch (exp.id())
+    {
+        case ID::add:
+        case ID::multiply:
+        case ID::negate:
+            return true;
+        case ID::literal:
+            return isRealInteger(literalNumber(exp));
+        case ID::power:
+        {
+            const Expr& exponent = *exp.getChild(1);
+            if (exponent.id() != ID::literal)
+                return false;
+            const Numbers::Number& number = literalNumber(exponent);
+            return isRealInteger(number) && !number.isNegativeReal() && number <= maxPower;
+        }
+        case ID::divide:
+        {
+            const Expr& denominator = *exp.getChild(1);
+            return denominator.id() == ID::literal && isRealInteger(literalNumber(denominator)) &&
+                   !literalNumber(denominator).isZero();
+        }
+        default:
+            return false;
+    }
+}
+
+void Atoms::collect(const ExprConstSP& exp)
+{
+    std::vector<const Expr*> work(1, exp.get());
+    while (!work.empty())
+    {
+        const Expr* top = work.back();
+        work.pop_back();
+        if (isPolynomialNode(*top))
+        {
+            for (size_t i = 0; i < operands(*top); i++)
+                work.push_back(top->getChild(i).get());
+            continue;
+        }
+        std::vector<ExprConstSP>::iterator it = std::lower_bound(atoms.begin(), atoms.end(), top,
+            [](const ExprConstSP& atom, const Expr* exp) { return Expressions::structuralCompare(*atom, *exp) < 0; });
+        if (it == atoms.end() || Expressions::structuralCompare(**it, *top) != 0)
+            atoms.insert(it, ExprConstSP(top));
+    }
+}
+
+int Atoms::find(const Expr& exp) const
+{
+    std::vector<ExprConstSP>::const_iterator it = std::lower_bound(atoms.begin(), atoms.end(), &exp,
+        [](const ExprConstSP& atom, const Expr* exp) { return Expressions::structuralCompare(*atom, *exp) < 0; });
+    if (it == atoms.end() || Expressions::structuralCompare(**it, exp) != 0)
+        return -1;
+    return int(it - atoms.begin());
+}
+
+// Post-order, with an explicit stack, as for the visitors
+Rational read(const ExprConstSP& exp, const Atoms& atoms)
+{
+    unsigned int variables = unsigned(atoms.size());
+    if (variables > Sparse::maxVariables)
+        throw std::overflow_error("too many atoms in Polynomials::read");
+
+    struct Frame { const Expr* node; size_t next; };
+    std::vector<Frame> work(1, Frame{ exp.get(), 0 });
+    std::vector<Rational> results;
+    while (!work.empty())
+    {
+        const Expr& e = *work.back().node;
+        if (!isPolynomialNode(e))
+        {
+            int variable = atoms.find(e);
+            if (variable < 0)
+                throw std::invalid_argument("unknown atom in Polynomials::read");
+            results.push_back(Rational(Sparse::variable(variables, unsigned(variable))));
+            work.pop_back();
+            continue;
+        }
+        if (e.id() == ID::literal)
+        {
+            Integer value;
+            toInteger(literalNumber(e), value);
+            results.push_back(Rational(Sparse::constant(variables, value)));
+            work.pop_back();
+            continue;
+        }
+        if (work.back().next < operands(e))
+        {
+            const Expr* child = e.getChild(work.back().next++).get();
+            work.push_back(Frame{ child, 0 });
+            continue;
+        }
+        work.pop_back();
+
+        std::vector<Rational>::iterator first = results.end() - operands(e);
+        Rational result = *first;
+        switch (e.id())
+        {
+            case ID::add:
+            {
+                const Expressions::Add& add = static_cast<const Expressions::Add&>(e);
+                if (add.getSignForChild(0) == Sign::n)
+                    result.numerator.negate();
+                for (size_t i = 1; i < add.numberOfChildren(); i++)
+                    addTo(result, first[i], add.getSignForChild(i) == Sign::n);
+                break;
+            }
+            case ID::multiply:
+                for (size_t i = 1; i < e.numberOfChildren(); i++)
+                {
+                    result.numerator   = result.numerator * first[i].numerator;
+                    result.denominator *= first[i].denominator;
+                    result.normalize();
+                }
+                break;
+            case ID::negate:
+                result.numerator.negate();
+                break;
+            case ID::power:
+            {
+                Integer power;
+                toInteger(literalNumber(*e.getChild(1)), power);
+                unsigned int n = unsigned(power.getModByOneUnit());
+                result.numerator = result.numerator.pow(n);
+                Integer denominator(1);
+                for (unsigned int k = 0; k < n && !(result.denominator == Integer(1)); k++)
+                    denominator *= result.denominator;
+                result.denominator = denominator;
+                break;
+            }
+            case ID::divide:
+            {
+                Integer divisor;
+                toInteger(literalNumber(*e.getChild(1)), divisor);
+                if (divisor.isNegative())
+                {
+                    result.numerator.negate();
+                    divisor.makeAbs();
+                }
+                result.denominator *= divisor;
+                result.normalize();
+                break;
+            }
+            default:
+                throw std::logic_error("unexpected node in Polynomials::read");
+        }
+        results.erase(first, results.end());
+        results.push_back(std::move(result));
+    }
+    return results.back();
+}
+
+ExprConstSP write(const Rational& polynomial, const Atoms& atoms,
+                  const Numbers::NumberFactory& nF, const Expressions::Builder& eB)
+{
+    const Sparse& numerator = polynomial.numerator;
+    if (numerator.isZero())
+        return eB.literal(nF.zero());
+
+    // Each term with what its coefficient multiplies, null for the
+    // constant term, by which they are put in Canonical's order
+    struct Written
+    {
+        ExprConstSP monomial, term;
+        Sign sign;
+    };
+    std::vector<Written> written;
+    for (const Sparse::Term& term : numerator.getTerms())
+    {
+        Integer coefficient = term.coefficient, denominator = polynomial.denominator;
+        bool negative = coefficient.isNegative();
+        coefficient.makeAbs();
+        Integer common = gcd(coefficient, denominator);
+        if (!(common == Integer(1)))
+        {
+            coefficient /= common;
+            denominator /= common;
+        }
+
+        std::vector<ExprConstSP> factors;
+        for (unsigned int v = 0; v < numerator.numberOfVariables(); v++)
+        {
+            unsigned int power = numerator.exponent(term.monomial, v);
+            if (power == 1)
+                factors.push_back(atoms[v]);
+            else if (power > 1)
+                factors.push_back(eB.power(atoms[v], eB.literal(nF.number(double(power)))));
+        }
+        ExprConstSP monomial;
+        if (factors.size() == 1)
+            monomial = factors[0];
+        else if (!factors.empty())
+            monomial = eB.multiply(factors);
+        ExprConstSP result = monomial;
+        if (!(coefficient == Integer(1)) || factors.empty())
+        {
+            factors.push_back(eB.literal(toNumber(coefficient, nF)));
+            result = (factors.size() == 1) ? factors[0] : eB.multiply(factors);
+        }
+        if (!(denominator == Integer(1)))
+            result = eB.divide(result, eB.literal(toNumber(denominator, nF)));
+        written.push_back(Written{ monomial, result, negative ? Sign::n : Sign::p });
+    }
+    std::stable_sort(written.begin(), written.end(), [](const Written& lhs, const Written& rhs) {
+        if (!lhs.monomial || !rhs.monomial)
+            return bool(lhs.monomial) && !rhs.monomial;
+        return Expressions::structuralCompare(*lhs.monomial, *rhs.monomial) < 0;
+    });
+
+    if (written.size() == 1)
+        return (written[0].sign == Sign::p) ? written[0].term : eB.negate(written[0].term);
+    std::vector<ExprConstSP> terms;
+    std::vector<Sign> signs;
+    for (const Written& w : written)
+    {
+        terms.push_back(w.term);
+        signs.push_back(w.sign);
+    }
+    return eB.add(terms, signs);
+}
+
+Dense<Integer> toDense(const Sparse& polynomial)
+{
+    if (polynomial.numberOfVariables() != 1)
+        throw std::invalid_argument("not univariate in Polynomials::toDense");
+    if (polynomial.isZero())
+        return Dense<Integer>();
+    // Terms are sorted by decreasing degree
+    std::vector<Integer> coefficients(polynomial.exponent(polynomial.getTerms()[0].monomial, 0) + 1);
+    for (const Sparse::Term& term : polynomial.getTerms())
+        coefficients[polynomial.exponent(term.monomial, 0)] = term.coefficient;
+    return Dense<Integer>(coefficients);
+}
+
+bool readUnivariate(const ExprConstSP& exp, ExprConstSP& symbol,
+                    Dense<Integer>& numerator, Integer& denominator)
+{
+    Atoms atoms;
+    atoms.collect(exp);
+    if (atoms.size() != 1 || atoms[0]->id() != ID::symbol || atoms[0]->numberOfChildren() != 0)
+        return false;
+    Rational polynomial;
+    try
+    {
+        polynomial = read(exp, atoms);
+    }
+    catch (const std::overflow_error&)
+    {
+        return false;
+    }
+    symbol      = atoms[0];
+    numerator   = toDense(polynomial.numerator);
+    denominator = polynomial.denominator;
+    return true;
+}
+
+} /* namespace Polynomials */
+} /* namespace CAS */
+} /* namespace DS */
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <vector>
+#include "Expression.hpp"
+#include "NumberProxy.hpp"
+#include "Sparse.hpp"
+#include "Dense.hpp"
+
+namespace DS { namespace CAS { namespace Numbers {
+    class NumberFactory;
+} } }
+
+namespace DS { namespace CAS { namespace Expressions {
+    class Builder;
+} } }
+
+namespace DS            {
+namespace CAS           {
+namespace Polynomials   {
+
+typedef Expressions::ExprConstSP ExprConstSP;
+
+// Exact conversions between Integers and real integer Numbers; toInteger
+// returns false if the number is not one
+bool toInteger(const Numbers::Number&, Integer&);
+Numbers::Proxy::NumberP toNumber(const Integer&, const Numbers::NumberFactory&);
+
+/****************************************************************************
+ * A polynomial with rational coefficients, as an Integer polynomial over a
+ * positive common denominator.
+ ****************************************************************************/
+struct Rational
+{
+    Sparse numerator;
+    Integer denominator;
+
+    explicit Rational(unsigned int variables = 0) : numerator(variables), denominator(1) {}
+    Rational(const Sparse& _numerator, const Integer& _denominator = Integer(1))
+        : numerator(_numerator), denominator(_denominator) {}
+
+    // Divides out the gcd of the denominator and the content
+    void normalize(void);
+};
+
+/****************************************************************************
+ * Reading expressions as polynomials.  Sums, differences, products,
+ * negations, powers to a literal natural number and quotients by a nonzero
+ * integer literal are taken apart; anything else (a symbol, a function, a
+ * literal that is not a real integer, x^y, x/y) is an atom, and the atoms
+ * are the variables of the polynomial.  The children of an atom are not
+ * looked into.
+ *
+ * Atoms are kept in structural order (see Structure.hpp), which is also the
+ * order of the variables, so the leading term of a polynomial comes from the
+ * first atom.
+ ****************************************************************************/
+class Atoms
+{
+public:
+    // Adds the atoms of exp
+    void collect(const ExprConstSP& exp);
+
+    size_t size(void) const { return atoms.size(); }
+    const ExprConstSP& operator[](size_t i) const { return atoms[i]; }
+
+    // The variable for an atom, or -1 if it is not one of these
+    int find(const Expressions::Expr&) const;
+
+private:
+    std::vector<ExprConstSP> atoms;
+};
+
+// Whether read() takes exp apart rather than treating it as an atom
+bool isPolynomialNode(const Expressions::Expr& exp);
+
+// Throws std::overflow_error if there are too many atoms or an exponent is
+// too large for the packing, and std::invalid_argument for an atom that is
+// not in atoms
+Rational read(const ExprConstSP& exp, const Atoms& atoms);
+
+// The expanded sum of terms, each with its coefficient in lowest terms, in
+// the order Canonical puts them in (by what the coefficient multiplies, the
+// constant last), so that simplifying does not have to sort them again
+ExprConstSP write(const Rational&, const Atoms& atoms,
+                  const Numbers::NumberFactory&, const Expressions::Builder&);
+
+// The coefficients of a polynomial in one variable, lowest degree first
+Dense<Integer> toDense(const Sparse&);
+
+// Reads exp as numerator/denominator with numerator a polynomial in one
+// symbol, which is returned; false if exp is not one (a constant is not)
+bool readUnivariate(const ExprConstSP& exp, ExprConstSP& symbol,
+                    Dense<Integer>& numerator, Integer& denominator);
+
+} /* namespace Polynomials */
+} /* namespace CAS */
+} /* namespace DS */
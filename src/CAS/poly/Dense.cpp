@@ -0,0 +1,111 @@
+#include "Dense.hpp"
+
+namespace DS            {
+namespace CAS           {
+namespace Polynomials   {
+
+namespace {
+
+// Below this many coefficients the packing costs more than it saves
+const size_t kroneckerThreshold = 32;
+
+// sum c[i] * 2^(64*slot*i) over [first, last), halving the range so that
+// no partial sum is shifted more than log n times
+Integer pack(const Integer* first, const Integer* last, int slot)
+{
+    if (last - first == 1)
+        return *first;
+    const Integer* middle = first + (last - first)/2;
+    Integer high = pack(middle, last, slot);
+    high.shiftLeftByUnits(slot * int(middle - first));
+    high += pack(first, middle, slot);
+    return high;
+}
+
+// The inverse of pack for nonnegative coefficients each below 2^(64*slot),
+// added into out[0 .. count)
+void unpack(Integer value, Integer* out, size_t count, int slot, bool subtract)
+{
+    if (!bool(value))
+        return;
+    if (count == 1)
+    {
+        if (subtract)
+            out[0] -= value;
+        else
+            out[0] += value;
+        return;
+    }
+    size_t half = count/2;
+    Integer high = value;
+    high.shiftRightByUnits(slot * int(half));
+    value.modByUnits(slot * int(half));
+    unpack(value, out, half, slot, subtract);
+    unpack(high, out + half, count - half, slot, subtract);
+}
+
+// The magnitudes of the positive and of the negative coefficients, and the
+// size of the largest in units
+void split(const std::vector<Integer>& a, std::vector<Integer>& positive,
+           std::vector<Integer>& negative, int& units)
+{
+    positive.assign(a.size(), Integer());
+    negative.assign(a.size(), Integer());
+    units = 0;
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        Integer& part = a[i].isNegative() ? negative[i] : positive[i];
+        part = a[i];
+        part.makeAbs();
+        units = std::max(units, part.numberOfDigits());
+    }
+}
+
+bool anyNonzero(const std::vector<Integer>& a)
+{
+    for (const Integer& value : a)
+        if (bool(value))
+            return true;
+    return false;
+}
+
+} // namespace
+
+// a*b = a+ b+ + a- b- - a+ b- - a- b+, each product of nonnegative parts
+// done as one Integer product of the packed operands.  A slot holds the
+// largest product of coefficients times the number of terms summed into it.
+void multiplyInto(const std::vector<Integer>& a, const std::vector<Integer>& b, std::vector<Integer>& out)
+{
+    if (std::min(a.size(), b.size()) < kroneckerThreshold)
+    {
+        multiplyInto<Integer>(a, b, out);
+        return;
+    }
+    std::vector<Integer> aParts[2], bParts[2];
+    int aUnits, bUnits;
+    split(a, aParts[0], aParts[1], aUnits);
+    split(b, bParts[0], bParts[1], bUnits);
+    int slot = aUnits + bUnits + 1;
+
+    Integer packed[2][2];
+    for (int i = 0; i < 2; i++)
+    {
+        if (anyNonzero(aParts[i]))
+            packed[0][i] = pack(aParts[i].data(), aParts[i].data() + aParts[i].size(), slot);
+        if (anyNonzero(bParts[i]))
+            packed[1][i] = pack(bParts[i].data(), bParts[i].data() + bParts[i].size(), slot);
+    }
+    for (int i = 0; i < 2; i++)
+        for (int j = 0; j < 2; j++)
+        {
+            if (!bool(packed[0][i]) || !bool(packed[1][j]))
+                continue;
+            Integer product = packed[0][i];
+            product *= packed[1][j];
+            unpack(product, out.data(), a.size() + b.size() - 1, slot, i != j);
+        }
+}
+
+} /* namespace Polynomials */
+} /* namespace CAS */
+} /* namespace DS */
@@ -0,0 +1,339 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include "Integer.hpp"
+
+namespace DS            {
+namespace CAS           {
+namespace Polynomials   {
+
+typedef DS::Numbers::Integer Integer;
+
+/****************************************************************************
+ * A dense polynomial in one variable, coefficients lowest degree first with
+ * no trailing zeros.  T is Integer, Float or double; it needs a value
+ * initialized zero and the arithmetic assignment operators.
+ *
+ * Products go through Karatsuba above a few dozen coefficients.  For
+ * Integer coefficients they go through one long Integer multiplication
+ * instead (Kronecker substitution: each operand packed into an Integer with
+ * a slot of units per coefficient), which leaves the inner loops to the
+ * Integer kernels.
+ ****************************************************************************/
+template<typename T>
+class Dense
+{
+public:
+    Dense() {}
+    explicit Dense(const std::vector<T>& _coefficients) : coefficients(_coefficients) { trim(); }
+
+    static Dense constant(const T& value) { return Dense(std::vector<T>(1, value)); }
+    // x - root
+    static Dense linear(const T& root);
+
+    // -1 for the zero polynomial
+    int degree(void) const { return int(coefficients.size()) - 1; }
+    bool isZero(void) const { return coefficients.empty(); }
+    const std::vector<T>& getCoefficients(void) const { return coefficients; }
+    const T& operator[](size_t i) const { return coefficients[i]; }
+
+    Dense& operator+= (const Dense&);
+    Dense& operator-= (const Dense&);
+    Dense& operator*= (const T&);
+
+    template<typename U>
+    friend Dense<U> operator* (const Dense<U>&, const Dense<U>&);
+
+    // *this = quotient*divisor + remainder with deg remainder < deg divisor.
+    // Throws std::domain_error for a zero divisor, or for Integers if the
+    // leading coefficient of the divisor does not divide the quotient's
+    // coefficients exactly (it always does for a monic divisor)
+    void divide(const Dense& divisor, Dense& quotient, Dense& remainder) const;
+
+    // Horner's rule
+    T evaluate(const T& x) const;
+
+    // Horner's rule for all the points at once: the loop over the points is
+    // the inner one, so each step is independent work across points
+    std::vector<T> evaluate(const std::vector<T>& points) const;
+
+    // The remainders of the polynomial by the subproduct tree of the points
+    // (the products of x - p over ever larger groups of points).  With fast
+    // multiplication this beats Horner's rule once there are about as many
+    // points as the degree and both run into the hundreds.  Exact over the
+    // Integers; over Floats precision suffers at high degree
+    std::vector<T> evaluateByTree(const std::vector<T>& points) const;
+
+private:
+    void trim(void);
+
+    std::vector<T> coefficients;
+};
+
+// The product of a and b, added into out (which has room for
+// a.size()+b.size()-1 coefficients); Integer has a Kronecker overload
+template<typename T>
+void multiplyInto(const std::vector<T>& a, const std::vector<T>& b, std::vector<T>& out);
+void multiplyInto(const std::vector<Integer>& a, const std::vector<Integer>& b, std::vector<Integer>& out);
+
+namespace Detail {
+
+// Below this many coefficients, schoolbook multiplication is faster
+const size_t karatsubaThreshold = 24;
+
+template<typename T>
+bool isZero(const T& value) { return value == T(); }
+
+// The exact quotient n/d, or false; only Integers can fail
+template<typename T>
+bool divideExactly(const T& n, const T& d, T& q) { q = n; q /= d; return true; }
+inline bool divideExactly(const Integer& n, const Integer& d, Integer& q)
+{
+    Integer divisor = d;
+    divisor.makeAbs();
+    q = n;
+    q.makeAbs();
+    Integer remainder = q.divideBy(divisor);
+    if (n.isNegative() != d.isNegative())
+        q.negate();
+    return !bool(remainder);
+}
+
+// out[0 .. n+m-1) += a[0 .. n) * b[0 .. m)
+template<typename T>
+void schoolbook(const T* a, size_t n, const T* b, size_t m, T* out)
+{
+    T product;
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < m; j++)
+        {
+            product = a[i];
+            product *= b[j];
+            out[i+j] += product;
+        }
+}
+
+// out[0 .. 2n-1) += a[0 .. n) * b[0 .. n)
+template<typename T>
+void karatsuba(const T* a, const T* b, size_t n, T* out)
+{
+    if (n < karatsubaThreshold)
+    {
+        schoolbook(a, n, b, n, out);
+        return;
+    }
+    // a = a0 + x^h a1, b = b0 + x^h b1, and a*b = z0 + x^h z1 + x^2h z2
+    // with z1 = (a0+a1)(b0+b1) - z0 - z2
+    size_t h = n/2, k = n - h;
+    std::vector<T> z0(2*h-1), z2(2*k-1), z1(2*k-1), sa(a+h, a+n), sb(b+h, b+n);
+    karatsuba(a, b, h, z0.data());
+    karatsuba(a+h, b+h, k, z2.data());
+    for (size_t i = 0; i < h; i++)
+    {
+        sa[i] += a[i];
+        sb[i] += b[i];
+    }
+    karatsuba(sa.data(), sb.data(), k, z1.data());
+    for (size_t i = 0; i < z0.size(); i++)
+    {
+        z1[i] -= z0[i];
+        out[i] += z0[i];
+    }
+    for (size_t i = 0; i < z2.size(); i++)
+    {
+        z1[i] -= z2[i];
+        out[2*h+i] += z2[i];
+    }
+    for (size_t i = 0; i < z1.size(); i++)
+        out[h+i] += z1[i];
+}
+
+} // namespace Detail
+
+template<typename T>
+void multiplyInto(const std::vector<T>& a, const std::vector<T>& b, std::vector<T>& out)
+{
+    const std::vector<T>& shorter = (a.size() <= b.size()) ? a : b;
+    const std::vector<T>& longer  = (a.size() <= b.size()) ? b : a;
+    size_t m = shorter.size();
+    if (m < Detail::karatsubaThreshold)
+    {
+        Detail::schoolbook(longer.data(), longer.size(), shorter.data(), m, out.data());
+        return;
+    }
+    // Balanced blocks of the longer operand, the last padded with zeros
+    std::vector<T> block(m), partial(2*m-1);
+    for (size_t start = 0; start < longer.size(); start += m)
+    {
+        size_t length = std::min(m, longer.size() - start);
+        std::copy(longer.begin() + start, longer.begin() + start + length, block.begin());
+        std::fill(block.begin() + length, block.end(), T());
+        std::fill(partial.begin(), partial.end(), T());
+        Detail::karatsuba(block.data(), shorter.data(), m, partial.data());
+        for (size_t i = 0; i < partial.size() && start+i < out.size(); i++)
+            out[start+i] += partial[i];
+    }
+}
+
+template<typename T>
+void Dense<T>::trim(void)
+{
+    while (!coefficients.empty() && Detail::isZero(coefficients.back()))
+        coefficients.pop_back();
+}
+
+template<typename T>
+Dense<T> Dense<T>::linear(const T& root)
+{
+    std::vector<T> coefficients(2);
+    coefficients[0] = root;
+    coefficients[0] *= T(-1);
+    coefficients[1] = T(1);
+    return Dense(coefficients);
+}
+
+template<typename T>
+Dense<T>& Dense<T>::operator+= (const Dense& rhs)
+{
+    if (coefficients.size() < rhs.coefficients.size())
+        coefficients.resize(rhs.coefficients.size());
+    for (size_t i = 0; i < rhs.coefficients.size(); i++)
+        coefficients[i] += rhs.coefficients[i];
+    trim();
+    return *this;
+}
+
+template<typename T>
+Dense<T>& Dense<T>::operator-= (const Dense& rhs)
+{
+    if (coefficients.size() < rhs.coefficients.size())
+        coefficients.resize(rhs.coefficients.size());
+    for (size_t i = 0; i < rhs.coefficients.size(); i++)
+        coefficients[i] -= rhs.coefficients[i];
+    trim();
+    return *this;
+}
+
+template<typename T>
+Dense<T>& Dense<T>::operator*= (const T& factor)
+{
+    for (T& coefficient : coefficients)
+        coefficient *= factor;
+    trim();
+    return *this;
+}
+
+template<typename T>
+Dense<T> operator* (const Dense<T>& lhs, const Dense<T>& rhs)
+{
+    Dense<T> result;
+    if (lhs.isZero() || rhs.isZero())
+        return result;
+    result.coefficients.resize(lhs.coefficients.size() + rhs.coefficients.size() - 1);
+    multiplyInto(lhs.coefficients, rhs.coefficients, result.coefficients);
+    result.trim();
+    return result;
+}
+
+template<typename T>
+void Dense<T>::divide(const Dense& divisor, Dense& quotient, Dense& remainder) const
+{
+    if (divisor.isZero())
+        throw std::domain_error("division by zero in Polynomials::Dense::divide");
+    std::vector<T> r = coefficients;
+    int n = degree(), d = divisor.degree();
+    std::vector<T> q((n >= d) ? size_t(n-d+1) : 0);
+    const T& leading = divisor.coefficients.back();
+    T product;
+    for (int k = n - d; k >= 0; k--)
+    {
+        if (!Detail::divideExactly(r[size_t(k+d)], leading, q[size_t(k)]))
+            throw std::domain_error("inexact division in Polynomials::Dense::divide");
+        for (int j = 0; j <= d; j++)
+        {
+            product = q[size_t(k)];
+            product *= divisor.coefficients[size_t(j)];
+            r[size_t(k+j)] -= product;
+        }
+    }
+    if (d < int(r.size()))
+        r.resize(size_t(std::max(d, 0)));
+    quotient  = Dense(q);
+    remainder = Dense(r);
+}
+
+template<typename T>
+T Dense<T>::evaluate(const T& x) const
+{
+    T value = T();
+    for (size_t i = coefficients.size(); i-- > 0;)
+    {
+        value *= x;
+        value += coefficients[i];
+    }
+    return value;
+}
+
+template<typename T>
+std::vector<T> Dense<T>::evaluate(const std::vector<T>& points) const
+{
+    std::vector<T> values(points.size(), T());
+    for (size_t i = coefficients.size(); i-- > 0;)
+    {
+        const T& coefficient = coefficients[i];
+        for (size_t j = 0; j < points.size(); j++)
+        {
+            values[j] *= points[j];
+            values[j] += coefficient;
+        }
+    }
+    return values;
+}
+
+template<typename T>
+std::vector<T> Dense<T>::evaluateByTree(const std::vector<T>& points) const
+{
+    if (points.empty())
+        return std::vector<T>();
+
+    // levels[0] holds x - p for each point, each level above the products
+    // of pairs from the one below (an odd one out is carried up as it is)
+    std::vector<std::vector<Dense> > levels(1);
+    for (const T& point : points)
+        levels[0].push_back(linear(point));
+    while (levels.back().size() > 1)
+    {
+        const std::vector<Dense>& below = levels.back();
+        std::vector<Dense> above;
+        for (size_t i = 0; i + 1 < below.size(); i += 2)
+            above.push_back(below[i] * below[i+1]);
+        if (below.size() % 2 == 1)
+            above.push_back(below.back());
+        levels.push_back(above);
+    }
+
+    // Down the tree, each node's remainder by its children
+    Dense quotient;
+    std::vector<Dense> remainders(1);
+    divide(levels.back()[0], quotient, remainders[0]);
+    for (size_t level = levels.size() - 1; level-- > 0;)
+    {
+        const std::vector<Dense>& nodes = levels[level];
+        std::vector<Dense> next(nodes.size());
+        for (size_t i = 0; i < nodes.size(); i++)
+            remainders[i/2].divide(nodes[i], quotient, next[i]);
+        remainders.swap(next);
+    }
+
+    std::vector<T> values(points.size(), T());
+    for (size_t i = 0; i < points.size(); i++)
+        if (!remainders[i].isZero())
+            values[i] = remainders[i].coefficients[0];
+    return values;
+}
+
+} /* namespace Polynomials */
+} /* namespace CAS */
+} /* namespace DS */
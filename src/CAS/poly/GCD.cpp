@@ -0,0 +1,532 @@
+#include <algorithm>
+#include <stdexcept>
+#include "GCD.hpp"
+
+namespace DS            {
+namespace CAS           {
+namespace Polynomials   {
+
+namespace {
+
+typedef Sparse::Monomial Monomial;
+typedef std::uint64_t Residue;
+typedef Numbers::BaseArray::unit_t_long Wide;
+
+// Arithmetic modulo a prime below 2^62, so a sum of two residues cannot wrap
+struct Field
+{
+    Residue p;
+
+    Residue add(Residue a, Residue b) const { Residue s = a + b; return (s >= p) ? s - p : s; }
+    Residue subtract(Residue a, Residue b) const { return (a >= b) ? a - b : a + (p - b); }
+    Residue negate(Residue a) const { return (a == 0) ? 0 : p - a; }
+    Residue multiply(Residue a, Residue b) const { return Residue(Wide(a) * b % p); }
+    Residue power(Residue a, Residue n) const
+    {
+        Residue result = 1;
+        for (; n != 0; n >>= 1, a = multiply(a, a))
+            if (n & 1)
+                result = multiply(result, a);
+        return result;
+    }
+    Residue inverse(Residue a) const { return power(a, p - 2); }
+};
+
+// Miller-Rabin with the first twelve primes as bases is exact below 2^64
+bool isPrime(Residue n)
+{
+    static const Residue bases[] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37 };
+    for (Residue base : bases)
+        if (n % base == 0)
+            return n == base;
+    Residue odd = n - 1;
+    int twos = 0;
+    for (; (odd & 1) == 0; odd >>= 1)
+        twos++;
+    Field field{ n };
+    for (Residue base : bases)
+    {
+        Residue x = field.power(base, odd);
+        if (x == 1 || x == n - 1)
+            continue;
+        int i = 1;
+        for (; i < twos; i++)
+        {
+            x = field.multiply(x, x);
+            if (x == n - 1)
+                break;
+        }
+        if (i == twos)
+            return false;
+    }
+    return true;
+}
+
+// The primes below 2^62 in decreasing order, found as they are needed
+Residue prime(size_t which)
+{
+    static std::vector<Residue> primes;
+    Residue candidate = primes.empty() ? (Residue(1) << 62) - 1 : primes.back() - 2;
+    for (; primes.size() <= which; candidate -= 2)
+        if (isPrime(candidate))
+            primes.push_back(candidate);
+    return primes[which];
+}
+
+Residue reduce(Integer value, const Field& field)
+{
+    bool negative = value.isNegative();
+    value.makeAbs();
+    // A unit at a time, least significant first
+    Residue result = 0, scale = 1, base = Residue((Wide(1) << 64) % field.p);
+    while (bool(value))
+    {
+        Residue unit = Residue(value.getModByOneUnit()) % field.p;
+        result = field.add(result, field.multiply(unit, scale));
+        scale = field.multiply(scale, base);
+        value.shiftRightByUnits(1);
+    }
+    return negative ? field.negate(result) : result;
+}
+
+/*
+ * Polynomials in one variable modulo p: coefficients lowest degree first,
+ * with no trailing zeros
+ */
+typedef std::vector<Residue> Univariate;
+
+void trim(Univariate& a)
+{
+    while (!a.empty() && a.back() == 0)
+        a.pop_back();
+}
+
+Residue evaluate(const Univariate& a, Residue x, const Field& field)
+{
+    Residue value = 0;
+    for (size_t i = a.size(); i-- > 0;)
+        value = field.add(field.multiply(value, x), a[i]);
+    return value;
+}
+
+Univariate multiply(const Univariate& a, const Univariate& b, const Field& field)
+{
+    if (a.empty() || b.empty())
+        return Univariate();
+    Univariate product(a.size() + b.size() - 1);
+    for (size_t i = 0; i < a.size(); i++)
+        for (size_t j = 0; j < b.size(); j++)
+            product[i+j] = field.add(product[i+j], field.multiply(a[i], b[j]));
+    return product;
+}
+
+void scale(Univariate& a, Residue factor, const Field& field)
+{
+    for (Residue& coefficient : a)
+        coefficient = field.multiply(coefficient, factor);
+    trim(a);
+}
+
+// a = quotient*b + remainder; b is not zero
+void divide(const Univariate& a, const Univariate& b, Univariate& quotient,
+            Univariate& remainder, const Field& field)
+{
+    remainder = a;
+    quotient.assign((a.size() >= b.size()) ? a.size() - b.size() + 1 : 0, 0);
+    Residue inverse = field.inverse(b.back());
+    for (size_t k = quotient.size(); k-- > 0;)
+    {
+        Residue q = field.multiply(remainder[k + b.size() - 1], inverse);
+        quotient[k] = q;
+        for (size_t j = 0; j < b.size(); j++)
+            remainder[k+j] = field.subtract(remainder[k+j], field.multiply(q, b[j]));
+    }
+    trim(remainder);
+}
+
+// Monic, or zero if both are
+Univariate gcd(Univariate a, Univariate b, const Field& field)
+{
+    Univariate quotient, remainder;
+    while (!b.empty())
+    {
+        divide(a, b, quotient, remainder, field);
+        a.swap(b);
+        b.swap(remainder);
+    }
+    if (!a.empty())
+        scale(a, field.inverse(a.back()), field);
+    return a;
+}
+
+/*
+ * Polynomials modulo p in the layout of a Sparse.  Below the variable being
+ * worked on, every exponent is zero: the variables after it have already
+ * been evaluated away.
+ */
+struct Term
+{
+    Monomial monomial;
+    Residue coefficient;
+};
+typedef std::vector<Term> Polynomial;
+
+// The terms with the same exponents apart from one variable, as a
+// polynomial in that variable
+struct Group
+{
+    Monomial rest;
+    Univariate coefficient;
+};
+
+// With the variables after it gone, the terms of each group are adjacent
+std::vector<Group> split(const Polynomial& a, unsigned int variable, const Sparse& shape)
+{
+    std::vector<Group> groups;
+    for (const Term& term : a)
+    {
+        Monomial rest = shape.without(term.monomial, variable);
+        if (groups.empty() || groups.back().rest != rest)
+            groups.push_back(Group{ rest, Univariate() });
+        Univariate& coefficient = groups.back().coefficient;
+        unsigned int power = shape.exponent(term.monomial, variable);
+        if (coefficient.size() <= power)
+            coefficient.resize(power + 1);
+        coefficient[power] = term.coefficient;
+    }
+    return groups;
+}
+
+Polynomial join(const std::vector<Group>& groups, unsigned int variable, const Sparse& shape)
+{
+    Polynomial a;
+    for (const Group& group : groups)
+        for (size_t i = group.coefficient.size(); i-- > 0;)
+            if (group.coefficient[i] != 0)
+                a.push_back(Term{ group.rest | shape.power(variable, unsigned(i)), group.coefficient[i] });
+    return a;
+}
+
+// The gcd of the coefficients of the groups, and the groups divided by it
+Univariate removeContent(std::vector<Group>& groups, const Field& field)
+{
+    Univariate content;
+    for (const Group& group : groups)
+        content = gcd(content, group.coefficient, field);
+    Univariate remainder;
+    if (content.size() > 1)
+        for (Group& group : groups)
+            divide(Univariate(group.coefficient), content, group.coefficient, remainder, field);
+    return content;
+}
+
+size_t degree(const std::vector<Group>& groups)
+{
+    size_t result = 0;
+    for (const Group& group : groups)
+        result = std::max(result, group.coefficient.size() - 1);
+    return result;
+}
+
+Polynomial evaluate(const std::vector<Group>& groups, Residue x, const Field& field)
+{
+    Polynomial a;
+    for (const Group& group : groups)
+    {
+        Residue value = evaluate(group.coefficient, x, field);
+        if (value != 0)
+            a.push_back(Term{ group.rest, value });
+    }
+    return a;
+}
+
+// Whether b divides a
+bool divides(Polynomial a, const Polynomial& b, const Sparse& shape, const Field& field)
+{
+    Residue inverse = field.inverse(b[0].coefficient);
+    Polynomial difference;
+    while (!a.empty())
+    {
+        Monomial quotient;
+        if (!shape.divides(a[0].monomial, b[0].monomial, quotient))
+            return false;
+        Residue factor = field.multiply(a[0].coefficient, inverse);
+        // a -= factor * quotient * b, merging as in Sparse
+        difference.clear();
+        size_t i = 0, j = 0;
+        while (i < a.size() || j < b.size())
+        {
+            Monomial next = (j < b.size()) ? b[j].monomial + quotient : 0;
+            if (j == b.size() || (i < a.size() && a[i].monomial > next))
+                difference.push_back(a[i++]);
+            else
+            {
+                Residue product = field.multiply(factor, b[j++].coefficient);
+                if (i < a.size() && a[i].monomial == next)
+                    product = field.subtract(a[i++].coefficient, product);
+                else
+                    product = field.negate(product);
+                if (product != 0)
+                    difference.push_back(Term{ next, product });
+            }
+        }
+        a.swap(difference);
+    }
+    return true;
+}
+
+void makeMonic(Polynomial& a, const Field& field)
+{
+    Residue inverse = field.inverse(a[0].coefficient);
+    for (Term& term : a)
+        term.coefficient = field.multiply(term.coefficient, inverse);
+}
+
+/*
+ * The monic gcd of a and b, nonzero polynomials in variables 0 .. variable.
+ * Returns false if no run of evaluation points leads anywhere, which can
+ * only happen for a small prime
+ */
+bool gcd(const Polynomial& a, const Polynomial& b, unsigned int variable,
+         const Sparse& shape, const Field& field, Polynomial& result)
+{
+    std::vector<Group> aGroups = split(a, variable, shape), bGroups = split(b, variable, shape);
+    Univariate content = gcd(removeContent(aGroups, field), removeContent(bGroups, field), field);
+    if (variable == 0)
+    {
+        aGroups[0].coefficient = content;
+        result = join(aGroups, variable, shape);
+        return true;
+    }
+
+    // The leading coefficient of the gcd divides that of both inputs, so
+    // each image is scaled to have the gcd of those as its own
+    const Univariate& aLeading = aGroups[0].coefficient;
+    const Univariate& bLeading = bGroups[0].coefficient;
+    Univariate leading = gcd(aLeading, bLeading, field);
+    size_t limit = std::min(degree(aGroups), degree(bGroups)), bound = leading.size() - 1 + limit;
+    Polynomial aPrimitive = join(aGroups, variable, shape), bPrimitive = join(bGroups, variable, shape);
+
+    // The interpolant so far, as groups, with the product of x - point over
+    // the points used
+    std::vector<Group> interpolant;
+    Univariate points(1, 1);
+    Polynomial image;
+    for (Residue point = 1; point < 4*bound + 64 && point < field.p; point++)
+    {
+        if (evaluate(aLeading, point, field) == 0 || evaluate(bLeading, point, field) == 0)
+            continue;
+        if (!gcd(evaluate(aGroups, point, field), evaluate(bGroups, point, field),
+                 variable - 1, shape, field, image))
+            return false;
+        Residue factor = evaluate(leading, point, field);
+        for (Term& term : image)
+            term.coefficient = field.multiply(term.coefficient, factor);
+
+        // An image with a higher leading monomial than before is unlucky,
+        // and one with a lower one shows that all those before were
+        bool changed = true;
+        if (interpolant.empty() || image[0].monomial < interpolant[0].rest)
+        {
+            interpolant.clear();
+            for (const Term& term : image)
+                interpolant.push_back(Group{ term.monomial, Univariate(1, term.coefficient) });
+            points.assign(1, 1);
+        }
+        else if (image[0].monomial > interpolant[0].rest)
+            continue;
+        else
+        {
+            // Newton's form: add (value - interpolant(point)) / points(point)
+            // times points to each group, merging in any new monomials
+            Residue weight = field.inverse(evaluate(points, point, field));
+            std::vector<Group> next;
+            size_t i = 0, j = 0;
+            changed = false;
+            while (i < interpolant.size() || j < image.size())
+            {
+                Group group;
+                Residue value = 0;
+                if (j == image.size() || (i < interpolant.size() && interpolant[i].rest > image[j].monomial))
+                    group = interpolant[i++];
+                else if (i == interpolant.size() || image[j].monomial > interpolant[i].rest)
+                {
+                    group.rest = image[j].monomial;
+                    value = image[j++].coefficient;
+                }
+                else
+                {
+                    group = interpolant[i++];
+                    value = image[j++].coefficient;
+                }
+                Residue correction = field.multiply(field.subtract(value, evaluate(group.coefficient, point, field)), weight);
+                if (correction != 0)
+                {
+                    changed = true;
+                    Univariate term = points;
+                    scale(term, correction, field);
+                    if (group.coefficient.size() < term.size())
+                        group.coefficient.resize(term.size());
+                    for (size_t k = 0; k < term.size(); k++)
+                        group.coefficient[k] = field.add(group.coefficient[k], term[k]);
+                    trim(group.coefficient);
+                }
+                if (!group.coefficient.empty())
+                    next.push_back(std::move(group));
+            }
+            interpolant.swap(next);
+        }
+        Univariate root(2, 1);
+        root[0] = field.negate(point);
+        points = multiply(points, root, field);
+
+        if (changed || interpolant.empty())
+            continue;
+        std::vector<Group> candidate = interpolant;
+        removeContent(candidate, field);
+        if (degree(candidate) > limit)
+            continue;
+        Polynomial primitive = join(candidate, variable, shape);
+        if (divides(aPrimitive, primitive, shape, field) && divides(bPrimitive, primitive, shape, field))
+        {
+            for (Group& group : candidate)
+                group.coefficient = multiply(group.coefficient, content, field);
+            result = join(candidate, variable, shape);
+            makeMonic(result, field);
+            return true;
+        }
+    }
+    return false;
+}
+
+Polynomial reduce(const Sparse& a, const Field& field)
+{
+    Polynomial result;
+    for (const Sparse::Term& term : a.getTerms())
+    {
+        Residue coefficient = reduce(term.coefficient, field);
+        if (coefficient != 0)
+            result.push_back(Term{ term.monomial, coefficient });
+    }
+    return result;
+}
+
+/*
+ * Garner's step: the Integer coefficients, known modulo modulus, become
+ * known modulo modulus*p, in the symmetric range.  Returns whether any of
+ * them changed
+ */
+bool combine(std::vector<Sparse::Term>& coefficients, Integer& modulus,
+             const Polynomial& image, const Field& field)
+{
+    Residue inverse = field.inverse(reduce(modulus, field));
+    Integer product = modulus * Integer(Numbers::BaseArray::unit_t(field.p));
+    std::vector<Sparse::Term> next;
+    bool changed = false;
+    size_t i = 0, j = 0;
+    while (i < coefficients.size() || j < image.size())
+    {
+        Sparse::Term term;
+        Residue value = 0;
+        if (j == image.size() || (i < coefficients.size() && coefficients[i].monomial > image[j].monomial))
+            term = coefficients[i++];
+        else if (i == coefficients.size() || image[j].monomial > coefficients[i].monomial)
+        {
+            term.monomial = image[j].monomial;
+            value = image[j++].coefficient;
+        }
+        else
+        {
+            term = coefficients[i++];
+            value = image[j++].coefficient;
+        }
+        Residue correction = field.multiply(field.subtract(value, reduce(term.coefficient, field)), inverse);
+        if (correction != 0)
+        {
+            changed = true;
+            term.coefficient += modulus * Integer(Numbers::BaseArray::unit_t(correction));
+            if (product.isLessThan(term.coefficient + term.coefficient))
+                term.coefficient -= product;
+        }
+        if (bool(term.coefficient))
+            next.push_back(std::move(term));
+    }
+    coefficients.swap(next);
+    modulus = product;
+    return changed;
+}
+
+Sparse positive(Sparse a)
+{
+    if (!a.isZero() && a.getTerms()[0].coefficient.isNegative())
+        a.negate();
+    return a;
+}
+
+} // namespace
+
+Sparse gcd(const Sparse& a, const Sparse& b)
+{
+    unsigned int variables = a.numberOfVariables();
+    if (b.numberOfVariables() != variables)
+        throw std::invalid_argument("different variables in Polynomials::gcd");
+    if (a.isZero() || b.isZero())
+        return positive(a.isZero() ? b : a);
+
+    Integer aContent = a.content(), bContent = b.content();
+    Integer content = gcd(aContent, bContent);
+    Sparse constant = Sparse::constant(variables, content);
+    if (a.getTerms()[0].monomial == 0 || b.getTerms()[0].monomial == 0)
+        return constant;
+    Sparse aPrimitive = a, bPrimitive = b;
+    aPrimitive /= aContent;
+    bPrimitive /= bContent;
+
+    const Integer& aLeading = aPrimitive.getTerms()[0].coefficient;
+    const Integer& bLeading = bPrimitive.getTerms()[0].coefficient;
+    Integer leading = gcd(aLeading, bLeading);
+
+    std::vector<Sparse::Term> coefficients;
+    Integer modulus;
+    for (size_t which = 0; ; which++)
+    {
+        Field field{ prime(which) };
+        if (reduce(aLeading, field) == 0 || reduce(bLeading, field) == 0)
+            continue;
+        Polynomial image;
+        if (!gcd(reduce(aPrimitive, field), reduce(bPrimitive, field), variables - 1, aPrimitive, field, image))
+            continue;
+        // Lucky primes give the true degree, so a constant is final
+        if (image[0].monomial == 0)
+            return constant;
+        Residue factor = reduce(leading, field);
+        for (Term& term : image)
+            term.coefficient = field.multiply(term.coefficient, factor);
+
+        // Coefficients mostly fit in one prime, so the first image is tried
+        // as it is, and after that each one that changes nothing
+        bool first = coefficients.empty() || image[0].monomial < coefficients[0].monomial;
+        if (first)
+        {
+            coefficients.clear();
+            modulus = Integer(1);
+        }
+        else if (image[0].monomial > coefficients[0].monomial)
+            continue;
+        if (combine(coefficients, modulus, image, field) && !first)
+            continue;
+
+        Sparse candidate(variables, coefficients), quotient;
+        candidate /= candidate.content();
+        candidate = positive(candidate);
+        if (aPrimitive.divide(candidate, quotient) && bPrimitive.divide(candidate, quotient))
+        {
+            candidate *= content;
+            return candidate;
+        }
+    }
+}
+
+} /* namespace Polynomials */
+} /* namespace CAS */
+} /* namespace DS */
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Sparse.hpp"
+
+namespace DS            {
+namespace CAS           {
+namespace Polynomials   {
+
+/****************************************************************************
+ * The greatest common divisor of two polynomials, with positive leading
+ * coefficient (0 if both are zero).
+ *
+ * Brown's modular algorithm: the gcd is computed modulo primes just below
+ * 2^62, where coefficients fit in a word and never grow, and the images are
+ * combined by Chinese remaindering until they stop changing and the result
+ * divides both inputs.  Modulo each prime the variables are eliminated one
+ * at a time by evaluating the last one at successive points and
+ * interpolating the gcds of the images, down to Euclid's algorithm in one
+ * variable.  Primes and points that give a gcd of too high a degree are
+ * unlucky and are skipped.
+ ****************************************************************************/
+Sparse gcd(const Sparse& a, const Sparse& b);
+
+} /* namespace Polynomials */
+} /* namespace CAS */
+} /* namespace DS */
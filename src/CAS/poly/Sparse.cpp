@@ -0,0 +1,271 @@
+#include <algorithm>
+#include <stdexcept>
+#include "Sparse.hpp"
+
+namespace DS            {
+namespace CAS           {
+namespace Polynomials   {
+
+Integer gcd(Integer a, Integer b)
+{
+    a.makeAbs();
+    b.makeAbs();
+    while (bool(b))
+    {
+        Integer remainder = a % b;
+        a = b;
+        b = remainder;
+    }
+    return a;
+}
+
+Sparse::Sparse(unsigned int _variables)
+    : variables(_variables), bits(0), fieldMask(0), guards(0)
+{
+    if (variables > maxVariables)
+        throw std::overflow_error("too many variables in Polynomials::Sparse::Sparse");
+    if (variables == 0)
+        return;
+    bits = 64/variables;
+    fieldMask = (bits == 64) ? ~Monomial(0) : (Monomial(1) << bits) - 1;
+    for (unsigned int i = 0; i < variables; i++)
+        guards |= Monomial(1) << (i*bits + bits - 1);
+}
+
+Sparse::Sparse(unsigned int _variables, const std::vector<Term>& _terms)
+    : Sparse(_variables)
+{
+    terms = _terms;
+}
+
+Sparse Sparse::constant(unsigned int variables, const Integer& value)
+{
+    Sparse result(variables);
+    if (bool(value))
+        result.terms.push_back(Term{ 0, value });
+    return result;
+}
+
+Sparse Sparse::variable(unsigned int variables, unsigned int which)
+{
+    Sparse result(variables);
+    if (which >= variables)
+        throw std::out_of_range("no such variable in Polynomials::Sparse::variable");
+    result.terms.push_back(Term{ Monomial(1) << ((variables-1-which)*result.bits), Integer(1) });
+    return result;
+}
+
+unsigned int Sparse::exponent(Monomial monomial, unsigned int variable) const
+{
+    return unsigned((monomial >> ((variables-1-variable)*bits)) & fieldMask);
+}
+
+Sparse::Monomial Sparse::power(unsigned int variable, unsigned int power) const
+{
+    if (power > maxExponent())
+        throw std::overflow_error("exponent too large in Polynomials::Sparse");
+    return Monomial(power) << ((variables-1-variable)*bits);
+}
+
+Sparse::Monomial Sparse::without(Monomial monomial, unsigned int variable) const
+{
+    return monomial & ~(fieldMask << ((variables-1-variable)*bits));
+}
+
+// No field of b may exceed its field of a: with the guard bits of a set,
+// a field borrows, clearing its guard, exactly when it does
+bool Sparse::divides(Monomial a, Monomial b, Monomial& quotient) const
+{
+    Monomial difference = (a | guards) - b;
+    if ((difference & guards) != guards)
+        return false;
+    quotient = difference & ~guards;
+    return true;
+}
+
+Sparse::Monomial Sparse::add(Monomial a, Monomial b) const
+{
+    Monomial sum = a + b;
+    if (sum & guards)
+        throw std::overflow_error("exponent too large in Polynomials::Sparse");
+    return sum;
+}
+
+// Merges the two sorted term lists
+Sparse Sparse::combine(const Sparse& rhs, bool subtract) const
+{
+    if (variables != rhs.variables)
+        throw std::invalid_argument("different variables in Polynomials::Sparse");
+    Sparse result(variables);
+    result.terms.reserve(terms.size() + rhs.terms.size());
+    size_t i = 0, j = 0;
+    while (i < terms.size() || j < rhs.terms.size())
+    {
+        if (j == rhs.terms.size() || (i < terms.size() && terms[i].monomial > rhs.terms[j].monomial))
+        {
+            result.terms.push_back(terms[i++]);
+            continue;
+        }
+        Term term = rhs.terms[j++];
+        if (subtract)
+            term.coefficient.negate();
+        if (i < terms.size() && terms[i].monomial == term.monomial)
+        {
+            term.coefficient += terms[i++].coefficient;
+            if (!bool(term.coefficient))
+                continue;
+        }
+        result.terms.push_back(term);
+    }
+    return result;
+}
+
+Sparse& Sparse::operator+= (const Sparse& rhs)
+{
+    *this = combine(rhs, false);
+    return *this;
+}
+
+Sparse& Sparse::operator-= (const Sparse& rhs)
+{
+    *this = combine(rhs, true);
+    return *this;
+}
+
+Sparse& Sparse::operator*= (const Integer& factor)
+{
+    if (!bool(factor))
+    {
+        terms.clear();
+        return *this;
+    }
+    for (Term& term : terms)
+        term.coefficient *= factor;
+    return *this;
+}
+
+Sparse& Sparse::operator/= (const Integer& divisor)
+{
+    Integer magnitude = divisor;
+    magnitude.makeAbs();
+    for (Term& term : terms)
+    {
+        bool negative = term.coefficient.isNegative();
+        term.coefficient.makeAbs();
+        term.coefficient /= magnitude;
+        if (negative != divisor.isNegative())
+            term.coefficient.negate();
+    }
+    return *this;
+}
+
+void Sparse::negate(void)
+{
+    for (Term& term : terms)
+        term.coefficient.negate();
+}
+
+// Dividing the leading term of the remainder each time, as in the
+// univariate case; the quotient comes out in order
+bool Sparse::divide(const Sparse& divisor, Sparse& quotient) const
+{
+    if (divisor.isZero())
+        throw std::domain_error("division by zero in Polynomials::Sparse::divide");
+    quotient = Sparse(variables);
+    Sparse remainder = *this;
+    const Term& leading = divisor.terms[0];
+    Integer magnitude = leading.coefficient;
+    magnitude.makeAbs();
+    while (!remainder.isZero())
+    {
+        Term term;
+        if (!divides(remainder.terms[0].monomial, leading.monomial, term.monomial))
+            return false;
+        // On magnitudes, as divideBy's remainder is not meant for signs
+        term.coefficient = remainder.terms[0].coefficient;
+        bool negative = term.coefficient.isNegative() != leading.coefficient.isNegative();
+        term.coefficient.makeAbs();
+        if (bool(term.coefficient.divideBy(magnitude)))
+            return false;
+        if (negative)
+            term.coefficient.negate();
+        Sparse multiple(variables, std::vector<Term>(1, term));
+        remainder -= multiple * divisor;
+        quotient.terms.push_back(term);
+    }
+    return true;
+}
+
+Sparse operator* (const Sparse& lhs, const Sparse& rhs)
+{
+    if (lhs.variables != rhs.variables)
+        throw std::invalid_argument("different variables in Polynomials::Sparse");
+    Sparse result(lhs.variables);
+    if (lhs.isZero() || rhs.isZero())
+        return result;
+    const Sparse& a = (lhs.size() <= rhs.size()) ? lhs : rhs;
+    const Sparse& b = (lhs.size() <= rhs.size()) ? rhs : lhs;
+
+    // One entry per term of a: the product of a[i] with b[j], the next
+    // term of b it has yet to meet
+    struct Entry
+    {
+        Sparse::Monomial monomial;
+        unsigned int i, j;
+        bool operator< (const Entry& rhs) const { return monomial < rhs.monomial; }
+    };
+    std::vector<Entry> heap;
+    heap.reserve(a.size());
+    for (unsigned int i = 0; i < a.size(); i++)
+        heap.push_back(Entry{ a.add(a.terms[i].monomial, b.terms[0].monomial), i, 0 });
+    std::make_heap(heap.begin(), heap.end());
+
+    Integer product;
+    while (!heap.empty())
+    {
+        Sparse::Monomial monomial = heap.front().monomial;
+        Integer sum;
+        while (!heap.empty() && heap.front().monomial == monomial)
+        {
+            std::pop_heap(heap.begin(), heap.end());
+            Entry& entry = heap.back();
+            product = a.terms[entry.i].coefficient;
+            product *= b.terms[entry.j].coefficient;
+            sum += product;
+            if (++entry.j < b.size())
+            {
+                entry.monomial = a.add(a.terms[entry.i].monomial, b.terms[entry.j].monomial);
+                std::push_heap(heap.begin(), heap.end());
+            }
+            else
+                heap.pop_back();
+        }
+        if (bool(sum))
+            result.terms.push_back(Sparse::Term{ monomial, std::move(sum) });
+    }
+    return result;
+}
+
+Sparse Sparse::pow(unsigned int n) const
+{
+    Sparse result = constant(variables, Integer(1));
+    for (unsigned int k = 0; k < n; k++)
+        result = result * (*this);
+    return result;
+}
+
+Integer Sparse::content(void) const
+{
+    Integer result;
+    for (const Term& term : terms)
+    {
+        result = gcd(result, term.coefficient);
+        if (result == Integer(1))
+            break;
+    }
+    return result;
+}
+
+} /* namespace Polynomials */
+} /* namespace CAS */
+} /* namespace DS */
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Integer.hpp"
+
+namespace DS            {
+namespace CAS           {
+namespace Polynomials   {
+
+typedef DS::Numbers::Integer Integer;
+
+// Greatest common divisor of the absolute values; gcd(0, 0) is 0
+Integer gcd(Integer a, Integer b);
+
+/****************************************************************************
+ * A sparse distributed polynomial in a fixed number of variables with
+ * Integer coefficients: a list of terms sorted by decreasing monomial, with
+ * no zero coefficients.
+ *
+ * A monomial is its exponent vector packed into one 64 bit word, variable 0
+ * in the most significant field, so comparing words compares monomials
+ * lexicographically and multiplying monomials is adding words.  Each field
+ * keeps its top bit clear as a guard; an exponent that would reach it makes
+ * the operation throw std::overflow_error.  With n variables the fields are
+ * 64/n bits wide, so n is at most 16 (exponents below 8) and, for instance,
+ * four variables may go up to 32767.
+ ****************************************************************************/
+class Sparse
+{
+public:
+    typedef std::uint64_t Monomial;
+
+    struct Term
+    {
+        Monomial monomial;
+        Integer coefficient;
+    };
+
+    static const unsigned int maxVariables = 16;
+
+    explicit Sparse(unsigned int variables = 0);
+    // The terms must be sorted by decreasing monomial, with no zero
+    // coefficients
+    Sparse(unsigned int variables, const std::vector<Term>& terms);
+
+    static Sparse constant(unsigned int variables, const Integer& value);
+    static Sparse variable(unsigned int variables, unsigned int which);
+
+    unsigned int numberOfVariables(void) const { return variables; }
+    const std::vector<Term>& getTerms(void) const { return terms; }
+    size_t size(void) const { return terms.size(); }
+    bool isZero(void) const { return terms.empty(); }
+
+    unsigned int exponent(Monomial, unsigned int variable) const;
+    Monomial maxExponent(void) const { return fieldMask >> 1; }
+
+    // The monomial variable^power, and a monomial with the exponent of a
+    // variable cleared
+    Monomial power(unsigned int variable, unsigned int power) const;
+    Monomial without(Monomial, unsigned int variable) const;
+    // Whether b divides a, and if so a/b in quotient
+    bool divides(Monomial a, Monomial b, Monomial& quotient) const;
+
+    Sparse& operator+= (const Sparse&);
+    Sparse& operator-= (const Sparse&);
+    Sparse& operator*= (const Integer&);
+    // Every coefficient must be a multiple of the divisor
+    Sparse& operator/= (const Integer&);
+    void negate(void);
+
+    // Whether divisor divides *this exactly, and if so the quotient
+    bool divide(const Sparse& divisor, Sparse& quotient) const;
+
+    // Johnson's algorithm: the products of each term of the shorter operand
+    // with the other operand are merged through a heap, so terms come out in
+    // order and are summed as they meet, without an intermediate list
+    friend Sparse operator* (const Sparse&, const Sparse&);
+
+    // By repeated multiplication, which for sparse operands does less work
+    // than squaring
+    Sparse pow(unsigned int) const;
+
+    // The gcd of the coefficients (0 for the zero polynomial)
+    Integer content(void) const;
+
+private:
+    Monomial add(Monomial, Monomial) const;
+    Sparse combine(const Sparse&, bool subtract) const;
+
+    unsigned int variables;
+    unsigned int bits;
+    Monomial fieldMask, guards;
+    std::vector<Term> terms;
+};
+
+inline Sparse operator+ (Sparse lhs, const Sparse& rhs) { lhs += rhs; return lhs; }
+inline Sparse operator- (Sparse lhs, const Sparse& rhs) { lhs -= rhs; return lhs; }
+
+} /* namespace Polynomials */
+} /* namespace CAS */
+} /* namespace DS */
@@ -0,0 +1,171 @@
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "GCD.hpp"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::function;
+using std::vector;
+
+using DS::CAS::Polynomials::Integer;
+using DS::CAS::Polynomials::Sparse;
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+// Euclid's algorithm, for comparison
+////////////////////////////////////////////////////////////////////////////////
+
+// The textbook multivariate gcd: the primitive remainder sequence in the
+// first variable, with the contents (the gcds of the coefficients, which
+// are polynomials in the remaining variables) found the same way
+
+unsigned int degree(const Sparse& a, unsigned int v)
+{
+    unsigned int result = 0;
+    for (const Sparse::Term& term : a.getTerms())
+        result = std::max(result, a.exponent(term.monomial, v));
+    return result;
+}
+
+// The coefficient of v^power, with the exponent of v cleared
+Sparse coefficient(const Sparse& a, unsigned int v, unsigned int power)
+{
+    vector<Sparse::Term> terms;
+    for (const Sparse::Term& term : a.getTerms())
+        if (a.exponent(term.monomial, v) == power)
+            terms.push_back(Sparse::Term{ a.without(term.monomial, v), term.coefficient });
+    return Sparse(a.numberOfVariables(), terms);
+}
+
+Sparse monomial(const Sparse& shape, unsigned int v, unsigned int power)
+{
+    return Sparse(shape.numberOfVariables(), vector<Sparse::Term>(1, Sparse::Term{ shape.power(v, power), Integer(1) }));
+}
+
+Sparse positive(Sparse a)
+{
+    if (!a.isZero() && a.getTerms()[0].coefficient.isNegative())
+        a.negate();
+    return a;
+}
+
+Sparse euclid(Sparse a, Sparse b, unsigned int v);
+
+Sparse content(const Sparse& a, unsigned int v)
+{
+    Sparse result(a.numberOfVariables());
+    for (unsigned int power = 0; power <= degree(a, v); power++)
+        result = euclid(result, coefficient(a, v, power), v + 1);
+    return result;
+}
+
+Sparse primitive(const Sparse& a, unsigned int v)
+{
+    Sparse result;
+    a.divide(content(a, v), result);
+    return positive(result);
+}
+
+Sparse euclid(Sparse a, Sparse b, unsigned int v)
+{
+    if (a.isZero() || b.isZero())
+        return positive(a.isZero() ? b : a);
+    unsigned int variables = a.numberOfVariables();
+    if (v == variables)
+        return Sparse::constant(variables, DS::CAS::Polynomials::gcd(a.content(), b.content()));
+    if (degree(a, v) == 0 && degree(b, v) == 0)
+        return euclid(a, b, v + 1);
+
+    Sparse common = euclid(content(a, v), content(b, v), v + 1);
+    a = primitive(a, v);
+    b = primitive(b, v);
+    if (degree(a, v) < degree(b, v))
+        std::swap(a, b);
+    while (!b.isZero())
+    {
+        // The pseudo-remainder of a by b
+        unsigned int d = degree(b, v);
+        Sparse leading = coefficient(b, v, d), r = a;
+        while (!r.isZero() && degree(r, v) >= d)
+        {
+            unsigned int k = degree(r, v);
+            r = leading * r - coefficient(r, v, k) * monomial(r, v, k - d) * b;
+        }
+        a = b;
+        b = r.isZero() ? r : primitive(r, v);
+    }
+    return common * primitive(a, v);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Inputs
+////////////////////////////////////////////////////////////////////////////////
+
+std::mt19937 generator(1);
+
+Sparse random(unsigned int variables, int terms, unsigned int maxDegree, int maxCoefficient)
+{
+    Sparse result(variables);
+    for (int t = 0; t < terms; t++)
+    {
+        int c = int(generator() % unsigned(2*maxCoefficient + 1)) - maxCoefficient;
+        Sparse term = Sparse::constant(variables, Integer(c));
+        for (unsigned int v = 0; v < variables; v++)
+            term = term * monomial(term, v, generator() % (maxDegree + 1));
+        result += term;
+    }
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Setup
+////////////////////////////////////////////////////////////////////////////////
+
+double time_fn(function<void ()> f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// count pairs g*a, g*b in the given number of variables, each factor with
+// a few terms of degree up to maxDegree in each variable
+void compare(unsigned int variables, unsigned int maxDegree, int count)
+{
+    vector<Sparse> as, bs, modular(count), textbook(count);
+    for (int i = 0; i < count; i++)
+    {
+        Sparse g = random(variables, 3, maxDegree, 50);
+        as.push_back(g * random(variables, 4, maxDegree, 1000));
+        bs.push_back(g * random(variables, 4, maxDegree, 1000));
+    }
+    double fast = time_fn([&]() { for (int i = 0; i < count; i++) modular[i]  = DS::CAS::Polynomials::gcd(as[i], bs[i]); });
+    double slow = time_fn([&]() { for (int i = 0; i < count; i++) textbook[i] = euclid(as[i], bs[i], 0); });
+    for (int i = 0; i < count; i++)
+    {
+        Sparse difference = modular[i] - textbook[i];
+        if (!difference.isZero())
+            cerr << "    **** gcds differ for input " << i << " ****" << endl;
+    }
+    cout << "  " << variables << " variables, degree " << maxDegree << ": modular "
+         << fast << "s, Euclid " << slow << "s (" << slow/fast << "x)" << endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    int count = (argc > 1) ? std::atoi(argv[1]) : 20;
+    compare(1, 12, count);
+    compare(2, 3, count);
+    compare(3, 2, count);
+    compare(4, 1, count);
+    return 0;
+}
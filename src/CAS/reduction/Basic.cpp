@@ -2,6 +2,14 @@
 #include "NumberProxy.hpp"
 #include "Basic.hpp"
 #include "Templates.hpp"
+#include "Rules.hpp"
+#include "Structure.hpp"
+#include "Conversion.hpp"
+#include "GCD.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
 
 using namespace DS::CAS::Numbers;
 
@@ -14,9 +22,10 @@ namespace Reduction     {
 
 // == Support Functions =========================================================================================
 
+// callers check eID(exp) == literal first
 const Number& getLiteralNumber(EP exp)
 {
-    return (dynamic_cast<const Literal&>(*exp)).getNumber();
+    return (static_cast<const Literal&>(*exp)).getNumber();
 }
 
 Expressions::ID eID(EP exp)
@@ -24,45 +33,6 @@ Expressions::ID eID(EP exp)
     return exp->id();
 }
 
-void GCDReduce(Proxy::NumberP& litNum, Proxy::NumberP& litDen)
-{
-    if (litDen.isZero())
-    {
-        if (!litNum.isZero())
-            litNum = litNum.create(1.0);
-        return;
-    }
-    if (!litNum.isRealPartInteger() || !litNum.isImaginaryPartInteger() ||
-        !litDen.isRealPartInteger() || !litDen.isImaginaryPartInteger())
-        throw std::logic_error("parameters not integer in CAS::Expressions::Visitors::Restructurers::Reduction::GCDReduce()");
-    Proxy::NumberP gcd = litDen;
-    if (gcd.isComplex())
-        throw std::logic_error("gcd is complex in CAS::Expressions::Visitors::Restructurers::Reduction::GCDReduce()");
-    if (gcd.isImaginary())
-        gcd.exchangeRealAndImaginary();
-    if (gcd.isNegativeReal())
-        gcd.negate();
-    Proxy::NumberP litNumReal = litNum;
-    Proxy::NumberP litNumImg  = litNum;
-    litNumReal.makeRealPart();
-    litNumImg.imaginaryPart();
-    if (litNumReal.isNegativeReal())
-        litNumReal.negate();
-    if (litNumImg.isNegativeReal())
-        litNumImg.negate();
-
-    if (!litNumReal.isZero())
-        gcd.GCD(litNumReal);
-    if (!litNumImg.isZero())
-        gcd.GCD(litNumImg);
-
-    litNum.divideBy(gcd);
-    litDen.divideBy(gcd);
-
-    litNum.roundUsingMode(CAS::Numbers::Number::RoundClosest);
-    litDen.roundUsingMode(CAS::Numbers::Number::RoundClosest);
-}
-
 Sign flipSign(Sign sign)
 {
     if (sign == Sign::p)
@@ -85,11 +55,22 @@ bool isRealPartEvenInteger(const Numbers::Number& number)
     return (temp.isRealPartInteger());
 }
 
+// a literal or a fraction of two literals
+bool isNumber(EP exp)
+{
+    if (eID(exp) == Expressions::ID::literal)
+        return true;
+    return eID(exp) == Expressions::ID::divide &&
+           eID(exp->getChild(0)) == Expressions::ID::literal &&
+           eID(exp->getChild(1)) == Expressions::ID::literal;
+}
+
 // == Basic Symbols =============================================================================================
 
 EP BasicSymbols::symbol(const Symbol& exp, const std::vector<EP>& children)
 {
-    if (exp.getName() == "i" && children.size() == 0)
+    static const Atom i("i");
+    if (exp.getAtom() == i && children.size() == 0)
         return eB.literal(nF.i());
     return Restructurer::symbol(exp, children);
 }
@@ -123,13 +104,24 @@ EP Rationalizer::literal(const Literal& exp, const std::vector<EP>& children)
         imaginary = true;
         number.exchangeRealAndImaginary();
     }
-    Proxy::NumberP ten           = nF.ten();
     Proxy::NumberP denominator = nF.one();
     Proxy::NumberP numerator   = number;
-    while (!numerator.isRealPartInteger())
+    if (unsigned int places = exp.getDecimalPlaces())
+    {
+        // Read from a decimal: the digits are the numerator, up to the
+        // rounding of the division by the power of ten
+        denominator = nF.powerOfTen(places);
+        numerator.multiply(denominator);
+        numerator.roundUsingMode(Number::RoundClosest);
+    }
+    else
     {
-        numerator.multiply(ten);
-        denominator.multiply(ten);
+        const Number& ten = nF.ten();
+        while (!numerator.isRealPartInteger())
+        {
+            numerator.multiply(ten);
+            denominator.multiply(ten);
+        }
     }
     if (imaginary)
         numerator.exchangeRealAndImaginary();
@@ -151,7 +143,10 @@ EP ComplexNormalizer::divide(const Divide& exp, const std::vector<EP>& children)
             Proxy::NumberP conjugate = number, modSquared = number;
             conjugate.conjugate();
             modSquared.modulusSquared();
-            return eB.divide(eB.multiply(children[0], eB.literal(conjugate)), eB.literal(modSquared));
+            EP product = eB.multiply(children[0], eB.literal(conjugate));
+            if (modSquared.isOne())
+                return product;
+            return eB.divide(product, eB.literal(modSquared));
         }
     }
     return Restructurer::divide(exp,children);
@@ -190,8 +185,10 @@ EP GCDLiteral::divide(const Divide& exp, const std::vector<EP>& children)
         !litDen.isRealPartInteger() || !litDen.isImaginaryPartInteger())
         return Restructurer::divide(exp,children);
 
-    GCDReduce(litNum, litDen);
+    nF.reduceFraction(litNum, litDen);
 
+    if (litNum == getLiteralNumber(children[0]) && litDen == getLiteralNumber(children[1]))
+        return Restructurer::divide(exp,children);
     return eB.divide(eB.literal(litNum), eB.literal(litDen));
 }
 
@@ -212,15 +209,32 @@ EP SizeOneArray::multiply(const Multiply& exp, const std::vector<EP>& children)
 
 // == Self Nesting ==============================================================================================
 
+// (a^b)^c is only merged for a positive real a, and then either for a real b or
+// for a real integer c (either of which may be negated)
+const RuleSet& nestingRules()
+{
+    static const RuleSet rules("SelfNesting",
+        "(a/b)/(c/d) -> (a*d)/(b*c)                                 \n"
+        "(a/b)/c     -> a/(b*c)                                     \n"
+        "a/(b/c)     -> (a*c)/b                                     \n"
+        "-(-a)       -> a                                           \n"
+        "(a^b)^c     -> a^(b*c)   when positive(a) and real(b)      \n"
+        "(a^b)^c     -> a^(b*c)   when positive(a) and integer(c)   \n");
+    return rules;
+}
+
+
 EP SelfNesting::add(const Add& exp, const std::vector<EP>& children)
 {
     std::vector<EP> newExps;
     std::vector<Sign> newSigns;
+    bool nested = false;
     for (unsigned int i = 0; i < exp.numberOfChildren(); i++)
     {
         if (eID(children[i]) == Expressions::ID::add)
         {
-            const Add& childRef = dynamic_cast<const Add&>(*children[i]);
+            nested = true;
+            const Add& childRef = static_cast<const Add&>(*children[i]);
             bool flipSign = (exp.getSignForChild(i) == Sign::n) ? true : false;
             for (unsigned int j = 0; j < childRef.numberOfChildren(); j++)
             {
@@ -232,84 +246,45 @@ EP SelfNesting::add(const Add& exp, const std::vector<EP>& children)
         newExps.push_back(children[i]);
         newSigns.push_back(exp.getSignForChild(i));
     }
+    if (!nested)
+        return Restructurer::add(exp,children);
     return eB.add(newExps, newSigns);
 }
 EP SelfNesting::divide(const Divide& exp, const std::vector<EP>& children)
 {
-    Expressions::ID idN = children[0]->id();
-    Expressions::ID idD = children[1]->id();
-    EP newN, newD;
-    if (idN == Expressions::ID::divide && idD == Expressions::ID::divide)
-    {
-        newN = eB.multiply(children[0]->getChild(0), children[1]->getChild(1));
-        newD = eB.multiply(children[0]->getChild(1), children[1]->getChild(0));
-        return eB.divide(newN, newD);
-    }
-    else if (idN == Expressions::ID::divide)
-    {
-        newN = children[0]->getChild(0);
-        newD = eB.multiply(children[0]->getChild(1), children[1]);
-        return eB.divide(newN, newD);
-    }
-    else if (idD == Expressions::ID::divide)
-    {
-        newD = children[1]->getChild(0);
-        newN = eB.multiply(children[0], children[1]->getChild(1));
-        return eB.divide(newN, newD);
-    }
-    else
-        return Restructurer::divide(exp,children);
+    if (EP result = nestingRules().rewrite(exp, children, nF, eB))
+        return result;
+    return Restructurer::divide(exp,children);
 }
 EP SelfNesting::multiply(const Multiply& exp, const std::vector<EP>& children)
 {
     std::vector<EP> newExps;
+    bool nested = false;
     for (unsigned int i = 0; i < exp.numberOfChildren(); i++)
     {
         if (eID(children[i]) == Expressions::ID::multiply)
+        {
+            nested = true;
             for (unsigned int j = 0; j < children[i]->numberOfChildren(); j++)
                 newExps.push_back(children[i]->getChild(j));
+        }
         else
             newExps.push_back(children[i]);
     }
+    if (!nested)
+        return Restructurer::multiply(exp,children);
     return eB.multiply(newExps);
 }
 EP SelfNesting::negate(const Negate& exp, const std::vector<EP>& children)
 {
-    if (eID(children[0]) == Expressions::ID::negate)
-        return children[0]->getChild(0);
+    if (EP result = nestingRules().rewrite(exp, children, nF, eB))
+        return result;
     return Restructurer::negate(exp,children);
 }
 EP SelfNesting::power(const Power& exp, const std::vector<EP>& children)
 {
-    // tests for (a^b)^c and will turn it into a^(b*c) if a is positive real and
-    //   either (b is real) || (c is a real integer)
-    if (eID(children[0]) != Expressions::ID::power)
-        return Restructurer::power(exp,children);
-
-    if (eID(children[0]->getChild(0)) != Expressions::ID::literal)
-        return Restructurer::power(exp,children);
-
-    const Proxy::NumberP& base = getLiteralNumber(children[0]->getChild(0));
-
-    if (!base.isPositiveReal())
-        return Restructurer::power(exp,children);
-
-    EP firstExp  = children[0]->getChild(1);
-    EP secondExp = children[1];
-
-    if (eID(firstExp) == Expressions::ID::negate)
-        firstExp = firstExp->getChild(0);
-    if (eID(secondExp) == Expressions::ID::negate)
-        secondExp = secondExp->getChild(0);
-
-    if (eID(firstExp) == Expressions::ID::literal)
-        if (getLiteralNumber(firstExp).isReal())
-            return eB.power(children[0]->getChild(0), eB.multiply(children[0]->getChild(1), children[1]));
-
-    if (eID(secondExp) == Expressions::ID::literal)
-        if (getLiteralNumber(secondExp).isReal() && getLiteralNumber(secondExp).isIntegral())
-            return eB.power(children[0]->getChild(0), eB.multiply(children[0]->getChild(1), children[1]));
-
+    if (EP result = nestingRules().rewrite(exp, children, nF, eB))
+        return result;
     return Restructurer::power(exp,children);
 }
 
@@ -320,10 +295,12 @@ EP Negatives::add(const Add& exp, const std::vector<EP>& children)
     std::vector<EP> newTerms;
     std::vector<Sign> newSigns;
     int firstPositiveIndex = -1;
+    bool foundNegate = false;
     for (unsigned int i = 0; i < children.size(); i++)
     {
         bool isNegate = (eID(children[i]) == Expressions::ID::negate);
         Sign sign     = exp.getSignForChild(i);
+        foundNegate  |= isNegate;
 
         newTerms.push_back(isNegate ? children[i]->getChild(0) : children[i]);
         newSigns.push_back(isNegate ? flipSign(sign)           : sign);
@@ -332,7 +309,7 @@ EP Negatives::add(const Add& exp, const std::vector<EP>& children)
             firstPositiveIndex = int(i);
     }
     if (newSigns[0] == Sign::p)
-        return eB.add(newTerms, newSigns);
+        return foundNegate ? eB.add(newTerms, newSigns) : Restructurer::add(exp,children);
 
     if (firstPositiveIndex >= 0)
     {
@@ -342,7 +319,7 @@ EP Negatives::add(const Add& exp, const std::vector<EP>& children)
     }
     return eB.negate(eB.add(newTerms, std::vector<Sign>(newSigns.size(), Sign::p)));
 }
-EP Negatives::divide(const Divide&, const std::vector<EP>& children)
+EP Negatives::divide(const Divide& exp, const std::vector<EP>& children)
 {
     bool negate = false;
     EP newNum = children[0];
@@ -357,20 +334,23 @@ EP Negatives::divide(const Divide&, const std::vector<EP>& children)
         negate ^= true;
         newDen = children[1]->getChild(0);
     }
+    if (newNum == children[0] && newDen == children[1])
+        return Restructurer::divide(exp,children);
     EP result = eB.divide(newNum, newDen);
     if (negate)
         result = eB.negate(result);
     return result;
 }
-EP Negatives::multiply(const Multiply&, const std::vector<EP>& children)
+EP Negatives::multiply(const Multiply& exp, const std::vector<EP>& children)
 {
-    bool negativeSign = false;
+    bool negativeSign = false, foundNegate = false;
     std::vector<EP> newChildren;
     for (std::vector<EP>::const_iterator it = children.begin(); it != children.end(); ++it)
     {
         if (eID(*it) == Expressions::ID::negate)
         {
             negativeSign ^= true;
+            foundNegate   = true;
             newChildren.push_back((*it)->getChild(0));
             continue;
         }
@@ -378,9 +358,11 @@ EP Negatives::multiply(const Multiply&, const std::vector<EP>& children)
     }
     if (negativeSign)
         return eB.negate(eB.multiply(newChildren));
+    if (!foundNegate)
+        return Restructurer::multiply(exp,children);
     return eB.multiply(newChildren);
 }
-EP Negatives::power(const Power&, const std::vector<EP>& children)
+EP Negatives::power(const Power& exp, const std::vector<EP>& children)
 {
     // if the base has a negate in front of it and the exponent is a real integer then
     // the negative will be factored out
@@ -398,6 +380,8 @@ EP Negatives::power(const Power&, const std::vector<EP>& children)
                 return eB.negate(eB.power(newBase, children[1]));
         }
     }
+    if (newBase == children[0])
+        return Restructurer::power(exp,children);
     return eB.power(newBase, children[1]);
 }
 EP Negatives::literal(const Literal& exp, const std::vector<EP>& children)
@@ -410,10 +394,20 @@ EP Negatives::literal(const Literal& exp, const std::vector<EP>& children)
 
 // == First Order Basic =========================================================================================
 
+const RuleSet& firstOrderRules()
+{
+    static const RuleSet rules("FirstOrderBasic",
+        "a/(b^c)     -> a*b^(-c)                                    \n"
+        "(a/b)^c     -> a^c/b^c   when literal(a)                   \n"
+        "(a/b)^c     -> a^c/b^c   when literal(b)                   \n");
+    return rules;
+}
+
+
 EP FirstOrderBasic::divide(const Divide& exp, const std::vector<EP>& children)
 {
-    if (eID(children[1]) == Expressions::ID::power)
-        return eB.multiply(children[0], eB.power(children[1]->getChild(0), eB.negate(children[1]->getChild(1))));
+    if (EP result = firstOrderRules().rewrite(exp, children, nF, eB))
+        return result;
     return Restructurer::divide(exp,children);
 }
 EP FirstOrderBasic::multiply(const Multiply& exp, const std::vector<EP>& children)
@@ -438,21 +432,18 @@ EP FirstOrderBasic::negate(const Negate& exp, const std::vector<EP>& children)
     // Distributes a negative into an Add if there are minus signs in it
     if (eID(children[0]) == Expressions::ID::add)
     {
-        const Add& add = dynamic_cast<const Add&>(*(children[0]));
+        const Add& add = static_cast<const Add&>(*(children[0]));
         for (unsigned int i = 0; i < add.numberOfChildren(); i++)
             if (add.getSignForChild(i) == Sign::n)
-                return eB.add(add.getChildVector(), flipSigns(add.getSignVector()));
+                return eB.add(std::vector<EP>(add.getChildren().begin(), add.getChildren().end()),
+                              flipSigns(add.getSigns()));
     }
     return Restructurer::negate(exp,children);
 }
 EP FirstOrderBasic::power(const Power& exp, const std::vector<EP>& children)
 {
-    if (eID(children[0]) == Expressions::ID::divide)
-    {
-        EP div = children[0];
-        if (eID(div->getChild(0)) == Expressions::ID::literal || eID(div->getChild(1)) == Expressions::ID::literal)
-            return eB.divide(eB.power(children[0]->getChild(0), children[1]), eB.power(children[0]->getChild(1), children[1]));
-    }
+    if (EP result = firstOrderRules().rewrite(exp, children, nF, eB))
+        return result;
     return Restructurer::power(exp,children);
 }
 
@@ -460,41 +451,52 @@ EP FirstOrderBasic::power(const Power& exp, const std::vector<EP>& children)
 
 EP NumberReducerBasic::add(const Add& exp, const std::vector<EP>& children)
 {
-    std::vector<EP> newTerms, fractions;
-    std::vector<Sign> newSigns, fractionSigns;
-    Proxy::NumberP sum = nF.zero(), one = nF.one();
+    // Nothing to do without numbers, or when the only one is a
+    // sum already combined by this rule (nonzero, positive, last,
+    // and not over one)
+    unsigned int numbers = 0, last = unsigned(children.size())-1;
+    for (unsigned int i = 0; i < children.size(); i++)
+        if (isNumber(children[i]))
+            numbers++;
+    if (numbers == 0 && !children.empty())
+        return Restructurer::add(exp,children);
+    if (numbers == 1 && isNumber(children[last]) && exp.getSignForChild(last) == Sign::p)
+    {
+        if (eID(children[last]) == Expressions::ID::literal)
+        {
+            if (!getLiteralNumber(children[last]).isZero())
+                return Restructurer::add(exp,children);
+        }
+        else if (!getLiteralNumber(children[last]->getChild(0)).isZero() &&
+                 !getLiteralNumber(children[last]->getChild(1)).isOne())
+            return Restructurer::add(exp,children);
+    }
+
+    std::vector<EP> newTerms;
+    std::vector<Sign> newSigns;
+    Proxy::NumberP num = nF.zero(), den = nF.one();
 
     for (unsigned int i = 0; i < children.size(); i++)
     {
+        Proxy::NumberP num2 = nF.zero(), den2 = nF.one();
         if (eID(children[i]) == Expressions::ID::literal)
+            num2 = getLiteralNumber(children[i]);
+        else if (eID(children[i]) == Expressions::ID::divide &&
+                 eID(children[i]->getChild(0)) == Expressions::ID::literal &&
+                 eID(children[i]->getChild(1)) == Expressions::ID::literal)
         {
-            fractions.push_back(eB.divide(children[i], eB.literal(one)));
-            fractionSigns.push_back(exp.getSignForChild(i));
-            continue;
+            num2 = getLiteralNumber(children[i]->getChild(0));
+            den2 = getLiteralNumber(children[i]->getChild(1));
         }
-        else if (eID(children[i]) == Expressions::ID::divide)
+        else
         {
-            if (eID(children[i]->getChild(0)) == Expressions::ID::literal &&
-                eID(children[i]->getChild(1)) == Expressions::ID::literal)
-            {
-                fractions.push_back(children[i]);
-                fractionSigns.push_back(exp.getSignForChild(i));
-                continue;
-            }
+            newTerms.push_back(children[i]);
+            newSigns.push_back(exp.getSignForChild(i));
+            continue;
         }
-        newTerms.push_back(children[i]);
-        newSigns.push_back(exp.getSignForChild(i));
-    }
-
-    Proxy::NumberP num = sum, den = nF.one();
-    for (unsigned int i = 0; i < fractions.size(); i++)
-    {
-        Proxy::NumberP num2 = getLiteralNumber(fractions[i]->getChild(0));
-        Proxy::NumberP den2 = getLiteralNumber(fractions[i]->getChild(1));
-        if (fractionSigns[i] == Sign::n)
+        if (exp.getSignForChild(i) == Sign::n)
             num2.negate();
-        num = num*den2 + num2*den;
-        den *= den2;
+        nF.addFraction(num, den, num2, den2);
     }
     if (!num.isZero())
     {
@@ -520,8 +522,23 @@ EP NumberReducerBasic::divide(const Divide& exp, const std::vector<EP>& children
 
     return Restructurer::divide(exp,children);
 }
-EP NumberReducerBasic::multiply(const Multiply&, const std::vector<EP>& children)
+EP NumberReducerBasic::multiply(const Multiply& exp, const std::vector<EP>& children)
 {
+    // Nothing to do without literals, or when the only one is a
+    // product already folded by this rule (last, and not zero)
+    unsigned int literals = 0, last = unsigned(children.size())-1;
+    for (unsigned int i = 0; i < children.size(); i++)
+        if (eID(children[i]) == Expressions::ID::literal)
+            literals++;
+    if (literals == 0 && !children.empty())
+        return Restructurer::multiply(exp,children);
+    if (literals == 1 && eID(children[last]) == Expressions::ID::literal)
+    {
+        const Number& factor = getLiteralNumber(children[last]);
+        if (!factor.isZero() && (children.size() == 1 || !factor.isOne()))
+            return Restructurer::multiply(exp,children);
+    }
+
     std::vector<EP> newFactors;
     Proxy::NumberP product = nF.one();
     for (unsigned int i = 0; i < children.size(); i++)
@@ -594,6 +611,354 @@ EP NumberReducerBasic::power(const Power& exp, const std::vector<EP>& children)
     return Restructurer::power(exp,children);
 }
 
+// == Canonical =================================================================================================
+
+// Sums and products are put in one order (that of structuralCompare, numbers last), and like terms and like
+// bases are collected on the way: terms are grouped by what their numeric coefficient multiplies, factors by
+// their base when raised to a numeric power, in a hash map on the structural hash.  Coefficients and exponents
+// are added as exact fractions.
+
+namespace {
+
+// num/den * rest, or rest^(num/den)
+struct Collected
+{
+    EP original;
+    Sign sign;
+    EP rest;
+    Proxy::NumberP num, den;
+    unsigned int count;
+};
+
+// A literal, a fraction of literals, or either of them negated, as num/den
+bool asFraction(EP exp, Proxy::NumberP& num, Proxy::NumberP& den)
+{
+    bool negated = (eID(exp) == Expressions::ID::negate);
+    if (negated)
+        exp = exp->getChild(0);
+    if (!isNumber(exp))
+        return false;
+    if (eID(exp) == Expressions::ID::literal)
+        num = getLiteralNumber(exp);
+    else
+    {
+        num = getLiteralNumber(exp->getChild(0));
+        den = getLiteralNumber(exp->getChild(1));
+        if (den.isZero())
+            return false;
+    }
+    if (negated)
+        num.negate();
+    return true;
+}
+
+// In lowest terms where the numbers allow, with a positive real denominator; returns true if
+// the fraction is negative
+bool normalize(Proxy::NumberP& num, Proxy::NumberP& den, const NumberFactory& nF)
+{
+    if (num.isRealPartInteger() && num.isImaginaryPartInteger() && !den.isZero() &&
+        den.isReal() && den.isRealPartInteger())
+        nF.reduceFraction(num, den);
+    bool negative = false;
+    if (den.isNegativeReal())
+    {
+        den.negate();
+        num.negate();
+    }
+    if (num.isNegativeReal())
+    {
+        num.negate();
+        negative = true;
+    }
+    return negative;
+}
+
+EP fraction(const Proxy::NumberP& num, const Proxy::NumberP& den, const Builder& eB)
+{
+    if (den.isOne())
+        return eB.literal(num);
+    return eB.divide(eB.literal(num), eB.literal(den));
+}
+
+// Adds item to its group, or starts one; returns true if it joined one
+bool collect(std::vector<Collected>& items, std::unordered_map<size_t, std::vector<unsigned int> >& groups,
+             const Collected& item, const NumberFactory& nF)
+{
+    std::vector<unsigned int>& group = groups[structuralHash(*item.rest)];
+    for (unsigned int i : group)
+    {
+        if (structurallyEqual(items[i].rest, item.rest))
+        {
+            nF.addFraction(items[i].num, items[i].den, item.num, item.den);
+            items[i].count++;
+            return true;
+        }
+    }
+    group.push_back(unsigned(items.size()));
+    items.push_back(item);
+    return false;
+}
+
+bool before(const Collected& lhs, const Collected& rhs)
+{
+    return structuralCompare(*lhs.rest, *rhs.rest) < 0;
+}
+
+} // namespace
+
+EP Canonical::add(const Add& exp, const std::vector<EP>& children)
+{
+    std::vector<Collected> terms, numbers;
+    std::unordered_map<size_t, std::vector<unsigned int> > groups;
+    bool combined = false;
+    for (unsigned int i = 0; i < children.size(); i++)
+    {
+        Collected term = { children[i], exp.getSignForChild(i), children[i], nF.one(), nF.one(), 1 };
+        if (isNumber(children[i]))
+        {
+            numbers.push_back(term);
+            continue;
+        }
+        // num/den * rest, with the literal factors of a product in num
+        if (eID(term.rest) == Expressions::ID::negate)
+        {
+            term.num.negate();
+            term.rest = term.rest->getChild(0);
+        }
+        if (eID(term.rest) == Expressions::ID::divide && eID(term.rest->getChild(1)) == Expressions::ID::literal &&
+            !getLiteralNumber(term.rest->getChild(1)).isZero() && !isNumber(term.rest))
+        {
+            term.den  = getLiteralNumber(term.rest->getChild(1));
+            term.rest = term.rest->getChild(0);
+        }
+        if (eID(term.rest) == Expressions::ID::multiply)
+        {
+            std::vector<EP> factors;
+            for (unsigned int j = 0; j < term.rest->numberOfChildren(); j++)
+            {
+                if (eID(term.rest->getChild(j)) == Expressions::ID::literal)
+                    term.num.multiply(getLiteralNumber(term.rest->getChild(j)));
+                else
+                    factors.push_back(term.rest->getChild(j));
+            }
+            if (factors.size() != term.rest->numberOfChildren() && !factors.empty())
+                term.rest = (factors.size() == 1) ? factors[0] : eB.multiply(factors);
+            else if (factors.empty())
+            {
+                numbers.push_back(term);
+                continue;
+            }
+        }
+        if (term.sign == Sign::n)
+            term.num.negate();
+        combined |= collect(terms, groups, term, nF);
+    }
+
+    std::vector<EP> newTerms;
+    std::vector<Sign> newSigns;
+    std::sort(terms.begin(), terms.end(), before);
+    for (Collected& term : terms)
+    {
+        if (term.count == 1)
+        {
+            newTerms.push_back(term.original);
+            newSigns.push_back(term.sign);
+            continue;
+        }
+        if (term.num.isZero())
+            continue;
+        bool negative = normalize(term.num, term.den, nF);
+        std::vector<EP> factors(1, term.rest);
+        if (eID(term.rest) == Expressions::ID::multiply)
+            factors.assign(term.rest->getChildren().begin(), term.rest->getChildren().end());
+        if (!term.num.isOne())
+            factors.push_back(eB.literal(term.num));
+        EP result = (factors.size() == 1) ? factors[0] : eB.multiply(factors);
+        if (!term.den.isOne())
+            result = eB.divide(result, eB.literal(term.den));
+        newTerms.push_back(result);
+        newSigns.push_back(negative ? Sign::n : Sign::p);
+    }
+    for (const Collected& number : numbers)
+    {
+        newTerms.push_back(number.original);
+        newSigns.push_back(number.sign);
+    }
+    if (newTerms.empty())
+        return eB.literal(nF.zero());
+
+    // The same first term as Negatives would choose
+    if (newSigns[0] == Sign::n)
+    {
+        std::vector<Sign>::iterator positive = std::find(newSigns.begin(), newSigns.end(), Sign::p);
+        if (positive != newSigns.end())
+        {
+            std::swap(newTerms[0], newTerms[positive-newSigns.begin()]);
+            std::swap(newSigns[0], *positive);
+        }
+    }
+    if (!combined && std::equal(newTerms.begin(), newTerms.end(), children.begin()) &&
+        newSigns == exp.getSigns())
+        return Restructurer::add(exp,children);
+    return eB.add(newTerms, newSigns);
+}
+EP Canonical::multiply(const Multiply& exp, const std::vector<EP>& children)
+{
+    std::vector<Collected> factors;
+    std::vector<EP> literals;
+    std::unordered_map<size_t, std::vector<unsigned int> > groups;
+    bool combined = false;
+    for (unsigned int i = 0; i < children.size(); i++)
+    {
+        if (eID(children[i]) == Expressions::ID::literal)
+        {
+            literals.push_back(children[i]);
+            continue;
+        }
+        // rest^(num/den)
+        Collected factor = { children[i], Sign::p, children[i], nF.one(), nF.one(), 1 };
+        if (eID(children[i]) == Expressions::ID::power &&
+            asFraction(children[i]->getChild(1), factor.num, factor.den))
+            factor.rest = children[i]->getChild(0);
+        combined |= collect(factors, groups, factor, nF);
+    }
+
+    std::vector<EP> newFactors;
+    std::sort(factors.begin(), factors.end(), before);
+    for (Collected& factor : factors)
+    {
+        if (factor.count == 1)
+        {
+            newFactors.push_back(factor.original);
+            continue;
+        }
+        if (factor.num.isZero())
+            continue;
+        bool negative = normalize(factor.num, factor.den, nF);
+        if (factor.num.isOne() && factor.den.isOne() && !negative)
+        {
+            newFactors.push_back(factor.rest);
+            continue;
+        }
+        EP exponent = fraction(factor.num, factor.den, eB);
+        newFactors.push_back(eB.power(factor.rest, negative ? eB.negate(exponent) : exponent));
+    }
+    newFactors.insert(newFactors.end(), literals.begin(), literals.end());
+    if (newFactors.empty())
+        return eB.literal(nF.one());
+    if (!combined && std::equal(newFactors.begin(), newFactors.end(), children.begin()))
+        return Restructurer::multiply(exp,children);
+    return eB.multiply(newFactors);
+}
+
+// == Expand ====================================================================================================
+
+namespace {
+
+EP expandPolynomial(EP exp, const NumberFactory& nF, const Builder& eB)
+{
+    Polynomials::Atoms atoms;
+    atoms.collect(exp);
+    return Polynomials::write(Polynomials::read(exp, atoms), atoms, nF, eB);
+}
+
+} // namespace
+
+// expand(p) multiplies p out as a polynomial in its atoms; a quotient has
+// its numerator and denominator expanded separately.  Left as it is if
+// there are too many atoms or too high a power.
+EP Expand::symbol(const Symbol& exp, const std::vector<EP>& children)
+{
+    static const Atom expand("expand");
+    if (exp.getAtom() != expand || children.size() != 1)
+        return Restructurer::symbol(exp, children);
+    EP argument = children[0];
+    try
+    {
+        if (eID(argument) == Expressions::ID::divide && !Polynomials::isPolynomialNode(*argument))
+            return eB.divide(expandPolynomial(argument->getChild(0), nF, eB),
+                             expandPolynomial(argument->getChild(1), nF, eB));
+        return expandPolynomial(argument, nF, eB);
+    }
+    catch (const std::overflow_error&)
+    {
+        return Restructurer::symbol(exp, children);
+    }
+}
+
+// == Cancel ====================================================================================================
+
+namespace {
+
+// Powers past this are not read, since reading expands them
+const double maxCancelPower = 64;
+
+bool smallPowers(EP exp)
+{
+    std::vector<const Expr*> work(1, exp.get());
+    while (!work.empty())
+    {
+        const Expr* top = work.back();
+        work.pop_back();
+        if (!Polynomials::isPolynomialNode(*top))
+            continue;
+        if (top->id() == Expressions::ID::power &&
+            getLiteralNumber(top->getChild(1)) > maxCancelPower)
+            return false;
+        for (size_t i = 0; i < top->numberOfChildren(); i++)
+            work.push_back(top->getChild(i).get());
+    }
+    return true;
+}
+
+} // namespace
+
+// A quotient of polynomials is divided through by the gcd of its numerator
+// and denominator, when that is more than a number (numbers are for
+// GCDLiteral).  What is left is written out expanded.
+EP Cancel::divide(const Divide& exp, const std::vector<EP>& children)
+{
+    EP numerator = children[0], denominator = children[1];
+    Polynomials::Atoms atoms;
+    atoms.collect(numerator);
+    atoms.collect(denominator);
+    if (atoms.size() == 0 || atoms.size() > Polynomials::Sparse::maxVariables ||
+        !smallPowers(numerator) || !smallPowers(denominator))
+        return Restructurer::divide(exp, children);
+    try
+    {
+        Polynomials::Rational n = Polynomials::read(numerator, atoms);
+        Polynomials::Rational d = Polynomials::read(denominator, atoms);
+        if (n.numerator.isZero() || d.numerator.isZero())
+            return Restructurer::divide(exp, children);
+        Polynomials::Sparse common = Polynomials::gcd(n.numerator, d.numerator);
+        if (common.getTerms()[0].monomial == 0)
+            return Restructurer::divide(exp, children);
+
+        // (a/m) / (b/k) = (a*k) / (b*m)
+        Polynomials::Sparse top, bottom;
+        n.numerator.divide(common, top);
+        d.numerator.divide(common, bottom);
+        top *= d.denominator;
+        bottom *= n.denominator;
+        if (bottom.getTerms()[0].monomial != 0)
+            return eB.divide(Polynomials::write(Polynomials::Rational(top), atoms, nF, eB),
+                             Polynomials::write(Polynomials::Rational(bottom), atoms, nF, eB));
+        Polynomials::Rational result(top, bottom.getTerms()[0].coefficient);
+        if (result.denominator.isNegative())
+        {
+            result.numerator.negate();
+            result.denominator.negate();
+        }
+        result.normalize();
+        return Polynomials::write(result, atoms, nF, eB);
+    }
+    catch (const std::overflow_error&)
+    {
+        return Restructurer::divide(exp, children);
+    }
+}
+
 // == Templates =================================================================================================
 
 /*
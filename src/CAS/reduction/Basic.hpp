@@ -2,6 +2,8 @@
 
 #include "Restructurer.hpp"
 #include "Overhead.hpp"
+#include "Pipeline.hpp"
+#include "EGraph.hpp"
 
 namespace  DS            {
 namespace  CAS           {
@@ -21,5 +23,16 @@ ALGORITHM  (SelfNesting,        ADD DIVIDE MULTIPLY NEGATE POWER)
 ALGORITHM  (Negatives,          ADD DIVIDE MULTIPLY POWER LITERAL)
 ALGORITHM  (FirstOrderBasic,    DIVIDE MULTIPLY POWER NEGATE)
 ALGORITHM  (NumberReducerBasic, ADD DIVIDE MULTIPLY NEGATE POWER)
+ALGORITHM  (Canonical,          ADD MULTIPLY)
+ALGORITHM  (Expand,             SYMBOL)
+ALGORITHM  (Cancel,             DIVIDE)
+
+// The main simplification round, fused into one walk of the tree
+typedef Pipeline<ComplexNormalizer, GCDLiteral, SizeOneArray, SelfNesting,
+                 Negatives, FirstOrderBasic, NumberReducerBasic, Canonical> Simplifier;
+
+// The same rules, applied by equality saturation
+typedef Saturation<ComplexNormalizer, GCDLiteral, SizeOneArray, SelfNesting,
+                   Negatives, FirstOrderBasic, NumberReducerBasic, Canonical> SaturatingSimplifier;
 
 }}}}}}
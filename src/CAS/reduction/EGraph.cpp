@@ -0,0 +1,421 @@
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include "EGraph.hpp"
+#include "Builder.hpp"
+#include "NumberFactory.hpp"
+#include "exprs.hpp"
+
+namespace DS            {
+namespace CAS           {
+namespace Expressions   {
+namespace Visitors      {
+namespace Restructurers {
+
+namespace {
+
+const unsigned long infinite = std::numeric_limits<unsigned long>::max();
+
+void combine(size_t& seed, size_t value)
+{
+    seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+}
+
+} // namespace
+
+size_t EGraph::Hash::operator()(const ENode& node) const
+{
+    size_t seed = static_cast<size_t>(node.op);
+    combine(seed, node.payload);
+    for (ClassId c : node.children)
+        combine(seed, c);
+    for (Sign s : node.signs)
+        combine(seed, static_cast<size_t>(s));
+    return seed;
+}
+
+// Orders by real part, then imaginary part.  Only the exact comparisons are
+// used: equality of numbers allows for rounding, so it is not transitive and
+// would not make a strict weak ordering
+bool EGraph::NumberLess::operator()(const Numbers::Proxy::NumberP& a, const Numbers::Proxy::NumberP& b) const
+{
+    if (a.isLessReals(b))
+        return true;
+    if (b.isLessReals(a))
+        return false;
+    return a.isLessImaginaries(b);
+}
+
+EGraph::EGraph(std::shared_ptr<Numbers::NumberFactory> _nFactory,
+               std::shared_ptr<Expressions::Builder> _eBuilder)
+    : nFactory(_nFactory), eBuilder(_eBuilder), live(0)
+{
+    if (!nFactory || !eBuilder)
+        throw std::invalid_argument("null factory or builder in Restructurers::EGraph::EGraph");
+}
+
+EGraph::ClassId EGraph::find(ClassId c) const
+{
+    ClassId root = c;
+    while (parent[root] != root)
+        root = parent[root];
+    while (parent[c] != root)
+    {
+        ClassId next = parent[c];
+        parent[c] = root;
+        c = next;
+    }
+    return root;
+}
+
+unsigned int EGraph::internNumber(const Numbers::Number& number)
+{
+    Numbers::Proxy::NumberP value(number);
+    // NaNs are not ordered, so each one stays on its own
+    if (value.isNotANumber())
+    {
+        numbers.push_back(value);
+        return static_cast<unsigned int>(numbers.size()-1);
+    }
+    auto it = numberIndex.find(value);
+    if (it != numberIndex.end())
+        return it->second;
+    numbers.push_back(value);
+    unsigned int index = static_cast<unsigned int>(numbers.size()-1);
+    numberIndex.insert(std::make_pair(value, index));
+    return index;
+}
+
+unsigned int EGraph::internName(Atom name)
+{
+    auto it = nameIndex.find(name);
+    if (it != nameIndex.end())
+        return it->second;
+    names.push_back(name);
+    unsigned int index = static_cast<unsigned int>(names.size()-1);
+    nameIndex.insert(std::make_pair(name, index));
+    return index;
+}
+
+void EGraph::canonicalize(ENode& node) const
+{
+    for (ClassId& c : node.children)
+        c = find(c);
+}
+
+EGraph::ClassId EGraph::addNode(ENode node)
+{
+    canonicalize(node);
+    auto it = memo.find(node);
+    if (it != memo.end())
+        return find(it->second);
+
+    ClassId c = static_cast<ClassId>(eclasses.size());
+    unsigned int index = static_cast<unsigned int>(nodes.size());
+    parent.push_back(c);
+    eclasses.push_back(EClass());
+    eclasses[c].nodes.push_back(index);
+    for (ClassId child : node.children)
+        eclasses[child].parents.push_back(std::make_pair(index, c));
+    nodes.push_back(node);
+    nodeClass.push_back(c);
+    memo.insert(std::make_pair(node, c));
+    live++;
+    return c;
+}
+
+// Post-order, with an explicit stack, as for the visitors
+EGraph::ClassId EGraph::add(const ExprConstSP& exp)
+{
+    struct Frame { const Expr* node; unsigned int next; };
+    std::vector<Frame> work(1, Frame{ exp.get(), 0 });
+    std::vector<ClassId> added;
+    while (!work.empty())
+    {
+        Frame& top = work.back();
+        if (top.next < top.node->numberOfChildren())
+        {
+            const Expr* child = top.node->getChild(top.next++).get();
+            work.push_back(Frame{ child, 0 });
+            continue;
+        }
+        const Expr& e = *top.node;
+        work.pop_back();
+
+        ENode node;
+        node.op      = e.id();
+        node.payload = 0;
+        node.children.assign(added.end()-e.numberOfChildren(), added.end());
+        added.resize(added.size()-e.numberOfChildren());
+        if (e.id() == ID::literal)
+            node.payload = internNumber(static_cast<const Literal&>(e).getNumber());
+        else if (e.id() == ID::symbol)
+            node.payload = internName(static_cast<const Symbol&>(e).getAtom());
+        else if (e.id() == ID::add)
+            node.signs = static_cast<const Add&>(e).getSigns();
+        added.push_back(addNode(node));
+    }
+    return added.back();
+}
+
+bool EGraph::merge(ClassId a, ClassId b)
+{
+    a = find(a);
+    b = find(b);
+    if (a == b)
+        return false;
+    if (eclasses[a].nodes.size() + eclasses[a].parents.size() <
+        eclasses[b].nodes.size() + eclasses[b].parents.size())
+        std::swap(a, b);
+    parent[b] = a;
+    EClass& from = eclasses[b];
+    EClass& into = eclasses[a];
+    into.nodes.insert(into.nodes.end(), from.nodes.begin(), from.nodes.end());
+    into.parents.insert(into.parents.end(), from.parents.begin(), from.parents.end());
+    from.nodes.clear();
+    from.parents.clear();
+    from.nodes.shrink_to_fit();
+    from.parents.shrink_to_fit();
+    live--;
+    dirty.push_back(a);
+    return true;
+}
+
+// Re-canonicalizes the nodes that use class c; any two that now coincide
+// mean their classes are equal as well
+void EGraph::repair(ClassId c)
+{
+    std::vector<std::pair<unsigned int, ClassId> > users;
+    users.swap(eclasses[c].parents);
+    for (auto const& user : users)
+    {
+        memo.erase(nodes[user.first]);
+        canonicalize(nodes[user.first]);
+    }
+    std::unordered_map<ENode, ClassId, Hash> seen;
+    std::vector<std::pair<unsigned int, ClassId> > kept;
+    for (auto const& user : users)
+    {
+        const ENode& node = nodes[user.first];
+        auto it = seen.find(node);
+        if (it != seen.end())
+        {
+            merge(it->second, user.second);
+            continue;
+        }
+        auto known = memo.find(node);
+        if (known != memo.end() && find(known->second) != find(user.second))
+            merge(known->second, user.second);
+        memo[node] = find(user.second);
+        seen.insert(std::make_pair(node, find(user.second)));
+        kept.push_back(std::make_pair(user.first, find(user.second)));
+    }
+    EClass& into = eclasses[find(c)];
+    into.parents.insert(into.parents.end(), kept.begin(), kept.end());
+}
+
+void EGraph::rebuild(void)
+{
+    while (!dirty.empty())
+    {
+        std::vector<ClassId> todo;
+        todo.swap(dirty);
+        for (ClassId& c : todo)
+            c = find(c);
+        std::sort(todo.begin(), todo.end());
+        todo.erase(std::unique(todo.begin(), todo.end()), todo.end());
+        for (ClassId c : todo)
+            repair(find(c));
+    }
+}
+
+std::vector<EGraph::ClassId> EGraph::classes(void) const
+{
+    std::vector<ClassId> result;
+    for (ClassId c = 0; c < eclasses.size(); c++)
+        if (find(c) == c)
+            result.push_back(c);
+    return result;
+}
+
+void EGraph::computeCosts(void)
+{
+    cost.assign(eclasses.size(), infinite);
+    best.assign(eclasses.size(), 0);
+    terms.assign(eclasses.size(), ExprConstSP());
+    shallows.assign(nodes.size(), ExprConstSP());
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (unsigned int n = 0; n < nodes.size(); n++)
+        {
+            const ENode& node = nodes[n];
+            unsigned long total = 1;
+            for (ClassId child : node.children)
+            {
+                unsigned long c = cost[find(child)];
+                if (c == infinite)
+                {
+                    total = infinite;
+                    break;
+                }
+                total += c;
+            }
+            if (total == infinite)
+                continue;
+            ClassId owner = find(nodeClass[n]);
+            if (total < cost[owner])
+            {
+                cost[owner] = total;
+                best[owner] = n;
+                changed = true;
+            }
+        }
+    }
+}
+
+ExprConstSP EGraph::shallow(unsigned int n)
+{
+    if (n < shallows.size() && shallows[n])
+        return shallows[n];
+    const ENode& node = nodes[n];
+    std::vector<ExprConstSP> children;
+    children.reserve(node.children.size());
+    for (ClassId child : node.children)
+        children.push_back(extract(child));
+    ExprConstSP result = build(node, children);
+    if (n < shallows.size())
+        shallows[n] = result;
+    return result;
+}
+
+ExprConstSP EGraph::build(const ENode& node, const std::vector<ExprConstSP>& children) const
+{
+    const Builder& eB = *eBuilder;
+    switch (node.op)
+    {
+        case ID::add:       return eB.add(children, node.signs);
+        case ID::divide:    return eB.divide(children[0], children[1]);
+        case ID::factorial: return eB.factorial(children[0]);
+        case ID::literal:   return eB.literal(numbers[node.payload]);
+        case ID::modulus:   return eB.modulus(children[0], children[1]);
+        case ID::multiply:  return eB.multiply(children);
+        case ID::negate:    return eB.negate(children[0]);
+        case ID::power:     return eB.power(children[0], children[1]);
+        case ID::symbol:    return eB.symbol(names[node.payload], children);
+    }
+    throw std::logic_error("unknown expression id in Restructurers::EGraph::build");
+}
+
+// Counts through the choices for the children like an odometer, the first
+// child turning fastest; choice 0 is always the cheapest term
+void EGraph::variants(unsigned int n, size_t limit, std::vector<ExprConstSP>& out)
+{
+    const ENode& node = nodes[n];
+    out.push_back(shallow(n));
+
+    std::vector<std::vector<ExprConstSP> > choices(node.children.size());
+    bool alternatives = false;
+    for (size_t i = 0; i < node.children.size(); i++)
+    {
+        ClassId child = find(node.children[i]);
+        choices[i].push_back(extract(child));
+        // Members that became the same node when their classes merged
+        // give the same term, so only the first of them is used.  Members
+        // using their own class (y*0 among the forms of 0) are left out:
+        // standing in for a child they only wrap another member, and rules
+        // rewriting the wrapped forms would grow them without end
+        std::vector<ENode> seen(1, nodes[best[child]]);
+        canonicalize(seen.back());
+        for (unsigned int m : eclasses[child].nodes)
+        {
+            if (choices[i].size() >= limit)
+                break;
+            ENode member = nodes[m];
+            canonicalize(member);
+            if (std::find(member.children.begin(), member.children.end(), child) != member.children.end() ||
+                std::find(seen.begin(), seen.end(), member) != seen.end())
+                continue;
+            seen.push_back(member);
+            choices[i].push_back(shallow(m));
+        }
+        if (choices[i].size() > 1)
+            alternatives = true;
+    }
+    if (!alternatives)
+        return;
+
+    std::vector<size_t> choice(node.children.size(), 0);
+    std::vector<ExprConstSP> children(node.children.size());
+    while (out.size() < limit)
+    {
+        size_t i = 0;
+        for (; i < choice.size(); i++)
+        {
+            if (++choice[i] < choices[i].size())
+                break;
+            choice[i] = 0;
+        }
+        if (i == choice.size())
+            break;
+        for (size_t j = 0; j < choice.size(); j++)
+            children[j] = choices[j][choice[j]];
+        out.push_back(build(node, children));
+    }
+}
+
+unsigned long EGraph::size(const Expr& exp)
+{
+    unsigned long total = 0;
+    std::vector<const Expr*> work(1, &exp);
+    while (!work.empty())
+    {
+        const Expr* top = work.back();
+        work.pop_back();
+        total++;
+        for (size_t i = 0; i < top->numberOfChildren(); i++)
+            work.push_back(top->getChild(i).get());
+    }
+    return total;
+}
+
+// Builds bottom up, with an explicit stack; the cheapest node of a class
+// never (indirectly) refers back to that class, so this terminates
+ExprConstSP EGraph::extract(ClassId c)
+{
+    c = find(c);
+    if (cost.size() != eclasses.size() || cost[c] == infinite)
+        throw std::logic_error("class without a term in Restructurers::EGraph::extract");
+    std::vector<ClassId> work(1, c);
+    while (!work.empty())
+    {
+        ClassId top = find(work.back());
+        if (terms[top])
+        {
+            work.pop_back();
+            continue;
+        }
+        bool ready = true;
+        for (ClassId child : nodes[best[top]].children)
+        {
+            if (!terms[find(child)])
+            {
+                work.push_back(find(child));
+                ready = false;
+            }
+        }
+        if (!ready)
+            continue;
+        work.pop_back();
+        terms[top] = shallow(best[top]);
+    }
+    return terms[c];
+}
+
+} /* namespace Restructurers */
+} /* namespace Visitors */
+} /* namespace Expressions */
+} /* namespace CAS */
+} /* namespace DS */
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Expression.hpp"
+#include "Atom.hpp"
+#include "NumberProxy.hpp"
+#include "Pipeline.hpp"
+
+namespace DS { namespace CAS { namespace Numbers {
+    class NumberFactory;
+} } }
+
+namespace DS            {
+namespace CAS           {
+namespace Expressions   {
+namespace Visitors      {
+namespace Restructurers {
+
+/****************************************************************************
+ * An e-graph over the expression node types: a set of equivalence classes
+ * of nodes whose children are classes rather than expressions, so that any
+ * number of equivalent forms of an expression can be held at once and
+ * share their common parts.  Nodes are hash-consed and classes are kept in
+ * a union-find; after a batch of merges rebuild() restores congruence (two
+ * nodes with the same operator and equivalent children are equivalent),
+ * revisiting only the classes that were touched.
+ *
+ * extract() picks, for each class, the node of least cost under the cost
+ * model (one per node, i.e. the size of the term) and builds that term.
+ ****************************************************************************/
+class EGraph
+{
+public:
+    typedef unsigned int ClassId;
+
+    EGraph(std::shared_ptr<Numbers::NumberFactory>, std::shared_ptr<Expressions::Builder>);
+
+    EGraph(EGraph const&)             = delete;
+    EGraph const& operator=(EGraph const&) = delete;
+
+    // Adds exp and all its subexpressions, returning the class of exp
+    ClassId add(const ExprConstSP& exp);
+
+    ClassId find(ClassId) const;
+
+    // Records that two classes are equal; call rebuild() before the next
+    // lookup.  Returns false if they already were
+    bool merge(ClassId, ClassId);
+    void rebuild(void);
+
+    size_t numberOfNodes(void)   const { return nodes.size(); }
+    size_t numberOfClasses(void) const { return live; }
+
+    // The canonical classes, and the nodes in one of them
+    std::vector<ClassId> classes(void) const;
+    const std::vector<unsigned int>& nodesOf(ClassId c) const { return eclasses[find(c)].nodes; }
+
+    // Works out the cheapest term for every class; until the graph changes,
+    // extract() and shallow() use these
+    void computeCosts(void);
+
+    // The cheapest term in class c
+    ExprConstSP extract(ClassId c);
+
+    // The given node, with the cheapest term of each child class as its
+    // children
+    ExprConstSP shallow(unsigned int node);
+
+    // Terms for the given node with its children drawn from the members of
+    // their classes, each member with the cheapest terms as its own
+    // children: shallow(node) first, then the others, at most limit in all
+    // and at most limit members from any one child class
+    void variants(unsigned int node, size_t limit, std::vector<ExprConstSP>& out);
+
+    // The cost of a term: its number of nodes
+    static unsigned long size(const Expr&);
+
+private:
+    struct ENode
+    {
+        ID op;
+        unsigned int payload;           // literal or symbol name, by index
+        std::vector<ClassId> children;
+        std::vector<Sign> signs;        // for an Add
+        bool operator==(const ENode& rhs) const
+        {
+            return op == rhs.op && payload == rhs.payload &&
+                   children == rhs.children && signs == rhs.signs;
+        }
+    };
+    struct Hash
+    {
+        size_t operator()(const ENode&) const;
+    };
+    struct EClass
+    {
+        std::vector<unsigned int> nodes;
+        std::vector<std::pair<unsigned int, ClassId> > parents; // (node, its class) using this one
+    };
+    struct NumberLess
+    {
+        bool operator()(const Numbers::Proxy::NumberP&, const Numbers::Proxy::NumberP&) const;
+    };
+
+    ClassId addNode(ENode node);
+    void canonicalize(ENode&) const;
+    ExprConstSP build(const ENode&, const std::vector<ExprConstSP>& children) const;
+    void repair(ClassId);
+    unsigned int internNumber(const Numbers::Number&);
+    unsigned int internName(Atom);
+
+    std::shared_ptr<Numbers::NumberFactory> nFactory;
+    std::shared_ptr<Expressions::Builder>   eBuilder;
+
+    mutable std::vector<ClassId> parent;    // union-find
+    std::vector<EClass> eclasses;
+    std::vector<ENode> nodes;
+    std::vector<ClassId> nodeClass;         // as of when it was added
+    std::unordered_map<ENode, ClassId, Hash> memo;
+    std::vector<ClassId> dirty;             // merged since the last rebuild
+    size_t live;
+
+    std::vector<Numbers::Proxy::NumberP> numbers;
+    std::map<Numbers::Proxy::NumberP, unsigned int, NumberLess> numberIndex;
+    std::vector<Atom> names;
+    std::unordered_map<Atom, unsigned int, Atom::Hash> nameIndex;
+
+    // Per class: cost of and node giving its cheapest term, and the term;
+    // per node: its shallow() term
+    std::vector<unsigned long> cost;
+    std::vector<unsigned int> best;
+    std::vector<ExprConstSP> terms;
+    std::vector<ExprConstSP> shallows;
+};
+
+/****************************************************************************
+ * Simplifies by equality saturation instead of by running the rules as
+ * passes: every rule is tried on every node of the e-graph, and whatever
+ * it produces is added as an equivalent of that node.  This goes on until
+ * nothing new turns up or one of the limits is hit, and the cheapest term
+ * for the whole expression is returned.
+ *
+ * Rules are ALGORITHMs, as for Pipeline, so they look at terms rather than
+ * at classes.  A node is shown to them as each of its variants: with every
+ * member of a child class in turn standing for that child, not only the
+ * cheapest, so that a rule matches a form of the child that lost on cost
+ * (i/1 next to i, say).  Below the children the cheapest terms are used,
+ * and the number of variants per node is bounded by the limits.  What a
+ * rule makes of a variant other than the cheapest is only kept if it is
+ * smaller than the cheapest: the classes of 0 and of 1/2 hold 1/2 - 1/2
+ * and 1/2 + 0, and rewriting those into each other would otherwise build
+ * ever longer sums.
+ ****************************************************************************/
+struct SaturationLimits
+{
+    size_t nodes;
+    unsigned int iterations;
+    std::chrono::milliseconds time;
+    size_t variants;    // terms tried per node
+    SaturationLimits() : nodes(20000), iterations(30), time(250), variants(16) {}
+};
+
+struct SaturationReport
+{
+    unsigned int iterations;
+    size_t nodes, classes;
+    bool saturated;
+    double milliseconds;
+    SaturationReport() : iterations(0), nodes(0), classes(0), saturated(false), milliseconds(0) {}
+};
+
+template<typename... Rules>
+class Saturation : private PipelineStage<Rules>...
+{
+public:
+    Saturation(std::shared_ptr<Numbers::NumberFactory> _nFactory,
+               std::shared_ptr<Expressions::Builder> _eBuilder,
+               SaturationLimits _limits = SaturationLimits())
+        : PipelineStage<Rules>(_nFactory, _eBuilder)...
+        , nFactory(_nFactory), eBuilder(_eBuilder), limits(_limits) {}
+
+    ExprConstSP run(const ExprConstSP& exp)
+    {
+        typedef std::chrono::steady_clock Clock;
+        Clock::time_point start = Clock::now();
+
+        EGraph graph(nFactory, eBuilder);
+        EGraph::ClassId root = graph.add(exp);
+        report = SaturationReport();
+
+        std::vector<std::pair<EGraph::ClassId, ExprConstSP> > found;
+        std::vector<ExprConstSP> terms;
+        while (report.iterations < limits.iterations)
+        {
+            report.iterations++;
+            graph.computeCosts();
+            found.clear();
+            for (EGraph::ClassId c : graph.classes())
+            {
+                for (unsigned int n : graph.nodesOf(c))
+                {
+                    terms.clear();
+                    graph.variants(n, limits.variants, terms);
+                    ((rewrite<Rules>(c, terms[0], found)), ...);
+                    unsigned long bound = EGraph::size(*terms[0]);
+                    for (size_t k = 1; k < terms.size(); k++)
+                        ((rewrite<Rules>(c, terms[k], found, bound)), ...);
+                }
+            }
+            bool changed = false;
+            for (auto const& f : found)
+                changed |= graph.merge(f.first, graph.add(f.second));
+            graph.rebuild();
+            if (!changed)
+            {
+                report.saturated = true;
+                break;
+            }
+            if (graph.numberOfNodes() > limits.nodes || Clock::now()-start > limits.time)
+                break;
+        }
+
+        graph.computeCosts();
+        ExprConstSP result = graph.extract(root);
+        report.nodes   = graph.numberOfNodes();
+        report.classes = graph.numberOfClasses();
+        report.milliseconds = std::chrono::duration<double, std::milli>(Clock::now()-start).count();
+        return result;
+    }
+
+    const SaturationReport& lastReport(void) const { return report; }
+
+private:
+    // Keeps what the rule makes of term if it is new and, given a bound,
+    // smaller than that
+    template<typename Rule>
+    void rewrite(EGraph::ClassId c, const ExprConstSP& term,
+                 std::vector<std::pair<EGraph::ClassId, ExprConstSP> >& found,
+                 unsigned long bound = 0)
+    {
+        ExprConstSP result = PipelineStage<Rule>::apply(term, scratch);
+        if (result != term && (bound == 0 || EGraph::size(*result) < bound))
+            found.push_back(std::make_pair(c, result));
+    }
+
+    std::shared_ptr<Numbers::NumberFactory> nFactory;
+    std::shared_ptr<Expressions::Builder>   eBuilder;
+    SaturationLimits limits;
+    SaturationReport report;
+    std::vector<ExprConstSP> scratch;
+};
+
+} /* namespace Restructurers */
+} /* namespace Visitors */
+} /* namespace Expressions */
+} /* namespace CAS */
+} /* namespace DS */
@@ -5,13 +5,17 @@ namespace  CAS           {
 namespace  Expressions   {
 namespace  Visitors      {
 namespace  Restructurers {
+
+template<typename> class PipelineStage;
+
 namespace  Reduction     {
 
 typedef    ExprConstSP EP;
 
 #define    CSTR(a)              public: a(std::shared_ptr<Numbers::NumberFactory> _nFactory, \
                                 std::shared_ptr<Expressions::Builder> _eBuilder) \
-                                : Restructurer(_nFactory, _eBuilder) { } private:
+                                : Restructurer(_nFactory, _eBuilder) { } private: \
+                                template<typename> friend class Restructurers::PipelineStage;
 #define    ALGORITHM(a, b)      class a : public Visitors::Restructurer { CSTR(a) b };
 #define    MEMBER(b,c)          virtual EP b(const c& exp, const std::vector<EP>& children);
 
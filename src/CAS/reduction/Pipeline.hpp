@@ -0,0 +1,136 @@
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "Restructurer.hpp"
+#include "exprs.hpp"
+
+namespace DS { namespace CAS { namespace Numbers {
+    class NumberFactory;
+} } }
+
+namespace DS            {
+namespace CAS           {
+namespace Expressions   {
+namespace Visitors      {
+namespace Restructurers {
+
+// Owns one rule of a Pipeline and calls its hooks directly
+// (qualified, so that they are not dispatched virtually)
+template<typename Rule>
+class PipelineStage
+{
+public:
+    PipelineStage(std::shared_ptr<Numbers::NumberFactory> _nFactory,
+                  std::shared_ptr<Expressions::Builder> _eBuilder)
+        : rule(_nFactory, _eBuilder) {}
+
+    ExprConstSP apply(ExprConstSP const& node, std::vector<ExprConstSP>& children)
+    {
+        children.assign(node->getChildren().begin(), node->getChildren().end());
+        const Expr& exp = *node;
+        switch (exp.id())
+        {
+            case ID::add:       return rule.Rule::add(static_cast<const Add&>(exp), children);
+            case ID::divide:    return rule.Rule::divide(static_cast<const Divide&>(exp), children);
+            case ID::factorial: return rule.Rule::factorial(static_cast<const Factorial&>(exp), children);
+            case ID::literal:   return rule.Rule::literal(static_cast<const Literal&>(exp), children);
+            case ID::modulus:   return rule.Rule::modulus(static_cast<const Modulus&>(exp), children);
+            case ID::multiply:  return rule.Rule::multiply(static_cast<const Multiply&>(exp), children);
+            case ID::negate:    return rule.Rule::negate(static_cast<const Negate&>(exp), children);
+            case ID::power:     return rule.Rule::power(static_cast<const Power&>(exp), children);
+            case ID::symbol:    return rule.Rule::symbol(static_cast<const Symbol&>(exp), children);
+        }
+        throw std::logic_error("unknown expression id in Restructurers::PipelineStage::apply");
+    }
+
+private:
+    Rule rule;
+};
+
+/****************************************************************************
+ * Applies a fixed, ordered list of rules (ALGORITHMs) in one bottom-up walk
+ * of the tree.  Once a node's children are done, the rules are tried on the
+ * node in order, and tried again for as long as any of them rewrites it (up
+ * to maxRounds times), before moving on to the parent.  The rules are fixed
+ * at compile time and called directly, so no virtual dispatch is involved in
+ * applying them; each rule type may appear only once.
+ *
+ * Nodes that a rule builds below the one it rewrites are not revisited, so
+ * a pipeline is not in general a fixed point of its rules on its own; run it
+ * until it stops changing the expression.
+ ****************************************************************************/
+template<typename... Rules>
+class Pipeline : public Restructurer, private PipelineStage<Rules>...
+{
+public:
+    Pipeline(std::shared_ptr<Numbers::NumberFactory> _nFactory,
+             std::shared_ptr<Expressions::Builder> _eBuilder)
+        : Restructurer(_nFactory, _eBuilder)
+        , PipelineStage<Rules>(_nFactory, _eBuilder)...
+    { }
+
+    static const unsigned int maxRounds = 20;
+
+protected:
+    virtual ExprConstSP add(const Add& exp, const std::vector<ExprConstSP>& children)
+    {
+        return settle(Restructurer::add(exp, children));
+    }
+    virtual ExprConstSP divide(const Divide& exp, const std::vector<ExprConstSP>& children)
+    {
+        return settle(Restructurer::divide(exp, children));
+    }
+    virtual ExprConstSP factorial(const Factorial& exp, const std::vector<ExprConstSP>& children)
+    {
+        return settle(Restructurer::factorial(exp, children));
+    }
+    virtual ExprConstSP literal(const Literal& exp, const std::vector<ExprConstSP>& children)
+    {
+        return settle(Restructurer::literal(exp, children));
+    }
+    virtual ExprConstSP modulus(const Modulus& exp, const std::vector<ExprConstSP>& children)
+    {
+        return settle(Restructurer::modulus(exp, children));
+    }
+    virtual ExprConstSP multiply(const Multiply& exp, const std::vector<ExprConstSP>& children)
+    {
+        return settle(Restructurer::multiply(exp, children));
+    }
+    virtual ExprConstSP negate(const Negate& exp, const std::vector<ExprConstSP>& children)
+    {
+        return settle(Restructurer::negate(exp, children));
+    }
+    virtual ExprConstSP power(const Power& exp, const std::vector<ExprConstSP>& children)
+    {
+        return settle(Restructurer::power(exp, children));
+    }
+    virtual ExprConstSP symbol(const Symbol& exp, const std::vector<ExprConstSP>& children)
+    {
+        return settle(Restructurer::symbol(exp, children));
+    }
+
+private:
+    // Runs the rules over node until none of them changes it
+    ExprConstSP settle(ExprConstSP node)
+    {
+        for (unsigned int round = 0; round < maxRounds; round++)
+        {
+            ExprConstSP start = node;
+            ((node = PipelineStage<Rules>::apply(node, scratch)), ...);
+            if (node == start)
+                break;
+        }
+        return node;
+    }
+
+    // Scratch space for the children of the node being rewritten
+    std::vector<ExprConstSP> scratch;
+};
+
+} /* namespace Restructurers */
+} /* namespace Visitors */
+} /* namespace Expressions */
+} /* namespace CAS */
+} /* namespace DS */
@@ -28,6 +28,22 @@ protected:
         return children;
     }
 
+    // True if children are exactly the children of exp, in
+    // which case exp can be returned as is (see same())
+    static bool unchanged(const Expr& exp, const std::vector<ExprConstSP>& children)
+    {
+        if (children.size() != exp.numberOfChildren())
+            return false;
+        for (unsigned int i = 0; i < children.size(); i++)
+            if (children[i] != exp.getChild(i))
+                return false;
+        return true;
+    }
+    static ExprConstSP same(const Expr& exp)
+    {
+        return ExprConstSP(&exp);
+    }
+
 public:
     Restructurer(std::shared_ptr<Numbers::NumberFactory> _nFactory,
                  std::shared_ptr<Expressions::Builder> _eBuilder)
@@ -93,41 +109,61 @@ public:
     }
 
 protected:
+    // The defaults rebuild exp from its (new) children, or hand
+    // back exp itself when none of them changed, so that a pass
+    // that rewrites nothing allocates nothing and its result
+    // compares equal to its input
     virtual ExprConstSP add(const Add& exp, const std::vector<ExprConstSP>& children)
     {
-        return eBuilder->add(children, exp.getSignVector());
+        if (unchanged(exp, children))
+            return same(exp);
+        return eBuilder->add(children, exp.getSigns());
     }
-    virtual ExprConstSP divide(const Divide&, const std::vector<ExprConstSP>& children)
+    virtual ExprConstSP divide(const Divide& exp, const std::vector<ExprConstSP>& children)
     {
-        return eBuilder->operator()("/",children);
+        if (unchanged(exp, children))
+            return same(exp);
+        return eBuilder->divide(children[0], children[1]);
     }
-    virtual ExprConstSP factorial(const Factorial&, const std::vector<ExprConstSP>& children)
+    virtual ExprConstSP factorial(const Factorial& exp, const std::vector<ExprConstSP>& children)
     {
-        return eBuilder->operator()("!",children);
+        if (unchanged(exp, children))
+            return same(exp);
+        return eBuilder->factorial(children[0]);
     }
     virtual ExprConstSP literal(const Literal& exp, const std::vector<ExprConstSP>&)
     {
-        return eBuilder->literal(exp.getNumber());
+        return same(exp);
     }
-    virtual ExprConstSP modulus(const Modulus&, const std::vector<ExprConstSP>& children)
+    virtual ExprConstSP modulus(const Modulus& exp, const std::vector<ExprConstSP>& children)
     {
-        return eBuilder->operator()("%",children);
+        if (unchanged(exp, children))
+            return same(exp);
+        return eBuilder->modulus(children[0], children[1]);
     }
-    virtual ExprConstSP multiply(const Multiply&, const std::vector<ExprConstSP>& children)
+    virtual ExprConstSP multiply(const Multiply& exp, const std::vector<ExprConstSP>& children)
     {
-        return eBuilder->operator()("*",children);
+        if (unchanged(exp, children))
+            return same(exp);
+        return eBuilder->multiply(children);
     }
-    virtual ExprConstSP negate(const Negate&, const std::vector<ExprConstSP>& children)
+    virtual ExprConstSP negate(const Negate& exp, const std::vector<ExprConstSP>& children)
     {
-        return eBuilder->operator()("ng",children);
+        if (unchanged(exp, children))
+            return same(exp);
+        return eBuilder->negate(children[0]);
     }
-    virtual ExprConstSP power(const Power&, const std::vector<ExprConstSP>& children)
+    virtual ExprConstSP power(const Power& exp, const std::vector<ExprConstSP>& children)
     {
-        return eBuilder->operator()("^",children);
+        if (unchanged(exp, children))
+            return same(exp);
+        return eBuilder->power(children[0], children[1]);
     }
     virtual ExprConstSP symbol(const Symbol& exp, const std::vector<ExprConstSP>& children)
     {
-        return eBuilder->operator()(exp.getName(),children);
+        if (unchanged(exp, children))
+            return same(exp);
+        return eBuilder->symbol(exp.getAtom(),children);
     }
 
 private:
@@ -137,7 +173,7 @@ protected:
     Numbers::NumberFactory& nF;
     Expressions::Builder& eB;
 
-    std::stack<ExprConstSP> childResults;
+    ResultStack<ExprConstSP> childResults;
 };
 
 } /* namespace Visitors */
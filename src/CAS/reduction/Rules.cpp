@@ -0,0 +1,492 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <stdexcept>
+#include "Rules.hpp"
+#include "Builder.hpp"
+#include "NumberFactory.hpp"
+#include "exprs.hpp"
+
+namespace DS            {
+namespace CAS           {
+namespace Expressions   {
+namespace Visitors      {
+namespace Restructurers {
+
+// == Predicates ================================================================================================
+
+namespace {
+
+// callers check id() == literal first
+const Numbers::Number& number(const ExprConstSP& exp)
+{
+    return static_cast<const Literal&>(*exp).getNumber();
+}
+
+// a literal, possibly negated
+const Expr* signedLiteral(const ExprConstSP& exp)
+{
+    const Expr* e = exp.get();
+    if (e->id() == ID::negate)
+        e = e->getChild(0).get();
+    return (e->id() == ID::literal) ? e : NULL;
+}
+
+bool isLiteral(const ExprConstSP& exp)
+{
+    return exp->id() == ID::literal;
+}
+bool isPositive(const ExprConstSP& exp)
+{
+    return isLiteral(exp) && number(exp).isPositiveReal();
+}
+bool isReal(const ExprConstSP& exp)
+{
+    const Expr* e = signedLiteral(exp);
+    return e && static_cast<const Literal*>(e)->getNumber().isReal();
+}
+bool isInteger(const ExprConstSP& exp)
+{
+    const Expr* e = signedLiteral(exp);
+    return e && static_cast<const Literal*>(e)->getNumber().isReal()
+             && static_cast<const Literal*>(e)->getNumber().isIntegral();
+}
+
+struct NamedPredicate
+{
+    const char* name;
+    bool (*test)(const ExprConstSP&);
+};
+
+// What may follow 'when'
+const NamedPredicate predicates[] = {
+    { "literal",  isLiteral  },  // a literal
+    { "positive", isPositive },  // a positive real literal
+    { "real",     isReal     },  // a real literal, or its negation
+    { "integer",  isInteger  },  // a real integral literal, or its negation
+};
+
+} // namespace
+
+// == Reader ====================================================================================================
+
+// Turns the text of one rule into patterns
+class RuleSet::Reader
+{
+public:
+    Reader(const std::string& _text, Rule& _rule) : text(_text), pos(0), rule(_rule) {}
+
+    void read(void)
+    {
+        rule.lhs = expression();
+        unsigned int bound = static_cast<unsigned int>(variables.size());
+        expect("->");
+        rule.rhs = expression();
+        checkBound(rule.rhs, bound);
+        if (accept("when"))
+        {
+            do
+                rule.conditions.push_back(condition());
+            while (accept("and"));
+        }
+        skipSpace();
+        if (pos != text.size())
+            fail("unexpected text");
+        rule.variables = static_cast<unsigned int>(variables.size());
+    }
+
+private:
+    // Rejects variables on the right that never appear on the left
+    void checkBound(const Pattern& p, unsigned int bound) const
+    {
+        if (p.variable >= static_cast<int>(bound))
+            fail("variable only on the right hand side");
+        for (const Pattern& child : p.children)
+            checkBound(child, bound);
+    }
+
+    Pattern expression(void)
+    {
+        Pattern result = node(ID::add);
+        result.children.push_back(term());
+        result.signs.push_back(Sign::p);
+        for (;;)
+        {
+            if (accept("+"))
+                result.signs.push_back(Sign::p);
+            else if (peek("-") && !peek("->"))
+            {
+                accept("-");
+                result.signs.push_back(Sign::n);
+            }
+            else
+                break;
+            result.children.push_back(term());
+        }
+        if (result.children.size() == 1)
+            return result.children[0];
+        return result;
+    }
+    Pattern term(void)
+    {
+        Pattern result = unary();
+        for (;;)
+        {
+            if (accept("*"))
+            {
+                if (result.variable >= 0 || result.id != ID::multiply || grouped)
+                {
+                    Pattern product = node(ID::multiply);
+                    product.children.push_back(result);
+                    result = product;
+                }
+                result.children.push_back(unary());
+                grouped = false;
+            }
+            else if (accept("/"))
+            {
+                Pattern quotient = node(ID::divide);
+                quotient.children.push_back(result);
+                quotient.children.push_back(unary());
+                result = quotient;
+            }
+            else
+                return result;
+        }
+    }
+    Pattern unary(void)
+    {
+        if (accept("-"))
+        {
+            Pattern result = node(ID::negate);
+            result.children.push_back(unary());
+            grouped = false;
+            return result;
+        }
+        return power();
+    }
+    Pattern power(void)
+    {
+        Pattern base = primary();
+        if (!accept("^"))
+            return base;
+        Pattern result = node(ID::power);
+        result.children.push_back(base);
+        result.children.push_back(unary());
+        grouped = false;
+        return result;
+    }
+    Pattern primary(void)
+    {
+        skipSpace();
+        grouped = false;
+        if (accept("("))
+        {
+            Pattern result = expression();
+            expect(")");
+            grouped = true; // (a*b)*c keeps its inner product
+            return result;
+        }
+        if (pos < text.size() && (std::isdigit(text[pos]) || text[pos] == '.'))
+        {
+            size_t start = pos;
+            while (pos < text.size() && (std::isdigit(text[pos]) || text[pos] == '.'))
+                pos++;
+            Pattern result = node(ID::literal);
+            result.value = std::atof(text.substr(start, pos-start).c_str());
+            return result;
+        }
+        std::string name = identifier();
+        if (name.empty())
+            fail("expected an operand");
+        Pattern result = node(ID::symbol);
+        result.variable = variable(name);
+        return result;
+    }
+    std::pair<Predicate, unsigned int> condition(void)
+    {
+        std::string name = identifier();
+        Predicate test = NULL;
+        for (const NamedPredicate& p : predicates)
+            if (name == p.name)
+                test = p.test;
+        if (!test)
+            fail("unknown predicate '" + name + "'");
+        expect("(");
+        std::string var = identifier();
+        expect(")");
+        for (unsigned int i = 0; i < variables.size(); i++)
+            if (variables[i] == var)
+                return std::make_pair(test, i);
+        fail("unknown variable '" + var + "' in condition");
+        return std::make_pair(test, 0u);
+    }
+
+    static Pattern node(ID id)
+    {
+        Pattern result;
+        result.variable = -1;
+        result.id       = id;
+        result.value    = 0;
+        return result;
+    }
+    unsigned int variable(const std::string& name)
+    {
+        for (unsigned int i = 0; i < variables.size(); i++)
+            if (variables[i] == name)
+                return i;
+        variables.push_back(name);
+        return static_cast<unsigned int>(variables.size()-1);
+    }
+    std::string identifier(void)
+    {
+        skipSpace();
+        size_t start = pos;
+        while (pos < text.size() && (std::isalnum(text[pos]) || text[pos] == '_'))
+            pos++;
+        return text.substr(start, pos-start);
+    }
+    void skipSpace(void)
+    {
+        while (pos < text.size() && std::isspace(text[pos]))
+            pos++;
+    }
+    bool peek(const std::string& token)
+    {
+        skipSpace();
+        return text.compare(pos, token.size(), token) == 0;
+    }
+    bool accept(const std::string& token)
+    {
+        if (!peek(token))
+            return false;
+        pos += token.size();
+        return true;
+    }
+    void expect(const std::string& token)
+    {
+        if (!accept(token))
+            fail("expected '" + token + "'");
+    }
+    void fail(const std::string& what) const
+    {
+        throw std::invalid_argument(what + " in rule '" + text + "' in Restructurers::RuleSet::compile");
+    }
+
+    const std::string& text;
+    size_t pos;
+    Rule& rule;
+    std::vector<std::string> variables;
+    bool grouped = false;
+};
+
+// == RuleSet ===================================================================================================
+
+RuleSet::RuleSet(const std::string& _name, const std::string& text) : name(_name)
+{
+    tree.push_back(Node());
+    compile(text);
+    registry().push_back(this);
+}
+
+RuleSet::~RuleSet()
+{
+    std::vector<const RuleSet*>& all = registry();
+    all.erase(std::remove(all.begin(), all.end(), this), all.end());
+}
+
+std::vector<const RuleSet*>& RuleSet::registry()
+{
+    static std::vector<const RuleSet*> all;
+    return all;
+}
+
+void RuleSet::compile(const std::string& text)
+{
+    size_t start = 0;
+    while (start < text.size())
+    {
+        size_t end = text.find_first_of(";\n", start);
+        if (end == std::string::npos)
+            end = text.size();
+        std::string line = text.substr(start, end-start);
+        start = end+1;
+        size_t first = line.find_first_not_of(" \t");
+        if (first == std::string::npos)
+            continue;
+
+        Rule rule;
+        rule.text = line.substr(first, line.find_last_not_of(" \t")-first+1);
+        rule.tries = rule.hits = 0;
+        Reader reader(rule.text, rule);
+        reader.read();
+        if (rule.lhs.variable >= 0 || rule.lhs.id == ID::literal)
+            throw std::invalid_argument("left hand side matches no operator in rule '" + rule.text +
+                                        "' in Restructurers::RuleSet::compile");
+        rules.push_back(rule);
+        insert(static_cast<unsigned int>(rules.size()-1));
+    }
+}
+
+// Adds the preorder of the rule's left hand side to the tree; a variable
+// is a wildcard that stands for a whole subtree
+void RuleSet::insert(unsigned int rule)
+{
+    unsigned int at = 0;
+    std::vector<const Pattern*> pending(1, &rules[rule].lhs);
+    while (!pending.empty())
+    {
+        const Pattern* p = pending.back();
+        pending.pop_back();
+        if (p->variable >= 0)
+        {
+            if (tree[at].wildcard < 0)
+            {
+                tree[at].wildcard = static_cast<int>(tree.size());
+                tree.push_back(Node());
+            }
+            at = static_cast<unsigned int>(tree[at].wildcard);
+            continue;
+        }
+        std::pair<ID, unsigned int> key(p->id, static_cast<unsigned int>(p->children.size()));
+        auto it = tree[at].next.find(key);
+        if (it == tree[at].next.end())
+        {
+            unsigned int fresh = static_cast<unsigned int>(tree.size());
+            tree[at].next[key] = fresh;
+            tree.push_back(Node());
+            at = fresh;
+        }
+        else
+            at = it->second;
+        for (size_t i = p->children.size(); i > 0; i--)
+            pending.push_back(&p->children[i-1]);
+    }
+    tree[at].rules.push_back(rule);
+}
+
+// Collects the rules whose shape fits the subtrees still to be matched
+void RuleSet::candidates(unsigned int node, std::vector<const Expr*>& pending,
+                         std::vector<unsigned int>& found) const
+{
+    if (pending.empty())
+    {
+        found.insert(found.end(), tree[node].rules.begin(), tree[node].rules.end());
+        return;
+    }
+    const Expr* subject = pending.back();
+    pending.pop_back();
+    if (tree[node].wildcard >= 0)
+        candidates(static_cast<unsigned int>(tree[node].wildcard), pending, found);
+    auto it = tree[node].next.find(std::make_pair(subject->id(),
+                                                  static_cast<unsigned int>(subject->numberOfChildren())));
+    if (it != tree[node].next.end())
+    {
+        size_t depth = pending.size();
+        for (size_t i = subject->numberOfChildren(); i > 0; i--)
+            pending.push_back(subject->getChild(i-1).get());
+        candidates(it->second, pending, found);
+        pending.resize(depth);
+    }
+    pending.push_back(subject);
+}
+
+bool RuleSet::match(const Pattern& p, const ExprConstSP& exp, std::vector<ExprConstSP>& bindings)
+{
+    if (p.variable >= 0)
+    {
+        ExprConstSP& bound = bindings[static_cast<size_t>(p.variable)];
+        if (bound)
+            return bound == exp;
+        bound = exp;
+        return true;
+    }
+    if (exp->id() != p.id || exp->numberOfChildren() != p.children.size())
+        return false;
+    if (p.id == ID::literal)
+        return number(exp) == p.value;
+    if (p.id == ID::add)
+        for (size_t i = 0; i < p.signs.size(); i++)
+            if (static_cast<const Add&>(*exp).getSignForChild(i) != p.signs[i])
+                return false;
+    for (size_t i = 0; i < p.children.size(); i++)
+        if (!match(p.children[i], exp->getChild(i), bindings))
+            return false;
+    return true;
+}
+
+ExprConstSP RuleSet::build(const Pattern& p, const std::vector<ExprConstSP>& bindings,
+                           const Numbers::NumberFactory& nF, const Builder& eB)
+{
+    if (p.variable >= 0)
+        return bindings[static_cast<size_t>(p.variable)];
+    std::vector<ExprConstSP> children;
+    for (const Pattern& child : p.children)
+        children.push_back(build(child, bindings, nF, eB));
+    switch (p.id)
+    {
+        case ID::add:      return eB.add(children, p.signs);
+        case ID::divide:   return eB.divide(children[0], children[1]);
+        case ID::literal:  return eB.literal(nF.number(p.value));
+        case ID::multiply: return eB.multiply(children);
+        case ID::negate:   return eB.negate(children[0]);
+        case ID::power:    return eB.power(children[0], children[1]);
+        default:           break;
+    }
+    throw std::logic_error("unexpected pattern in Restructurers::RuleSet::build");
+}
+
+ExprConstSP RuleSet::rewrite(const Expr& exp, const std::vector<ExprConstSP>& children,
+                             const Numbers::NumberFactory& nF, const Builder& eB) const
+{
+    auto root = tree[0].next.find(std::make_pair(exp.id(), static_cast<unsigned int>(children.size())));
+    if (root == tree[0].next.end())
+        return ExprConstSP();
+
+    std::vector<const Expr*> pending;
+    for (size_t i = children.size(); i > 0; i--)
+        pending.push_back(children[i-1].get());
+    std::vector<unsigned int> found;
+    candidates(root->second, pending, found);
+    std::sort(found.begin(), found.end());
+
+    std::vector<ExprConstSP> bindings;
+    for (unsigned int index : found)
+    {
+        const Rule& rule = rules[index];
+        rule.tries++;
+        bindings.assign(rule.variables, ExprConstSP());
+        bool matched = true;
+        if (exp.id() == ID::add)
+            for (size_t i = 0; i < rule.lhs.signs.size() && matched; i++)
+                matched = static_cast<const Add&>(exp).getSignForChild(i) == rule.lhs.signs[i];
+        for (size_t i = 0; i < children.size() && matched; i++)
+            matched = match(rule.lhs.children[i], children[i], bindings);
+        for (size_t i = 0; i < rule.conditions.size() && matched; i++)
+            matched = rule.conditions[i].first(bindings[rule.conditions[i].second]);
+        if (!matched)
+            continue;
+        rule.hits++;
+        return build(rule.rhs, bindings, nF, eB);
+    }
+    return ExprConstSP();
+}
+
+void RuleSet::report(std::ostream& out) const
+{
+    for (const Rule& rule : rules)
+        out << "  " << name << ": " << rule.text << "  (tried " << rule.tries
+            << ", applied " << rule.hits << ")" << std::endl;
+}
+
+void RuleSet::reportAll(std::ostream& out)
+{
+    for (const RuleSet* set : registry())
+        set->report(out);
+}
+
+} /* namespace Restructurers */
+} /* namespace Visitors */
+} /* namespace Expressions */
+} /* namespace CAS */
+} /* namespace DS */
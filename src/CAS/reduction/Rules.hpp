@@ -0,0 +1,115 @@
+#pragma once
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Expression.hpp"
+
+namespace DS { namespace CAS { namespace Numbers {
+    class NumberFactory;
+} } }
+
+namespace DS { namespace CAS { namespace Expressions {
+    class Builder;
+} } }
+
+namespace DS            {
+namespace CAS           {
+namespace Expressions   {
+namespace Visitors      {
+namespace Restructurers {
+
+/****************************************************************************
+ * A set of rewrite rules, written one per line (or separated by ';') as
+ *
+ *     (a^b)^c -> a^(b*c) when positive(a) and real(b)
+ *
+ * Identifiers are variables that match any subexpression (the same one each
+ * time they appear), numbers match literals with that value, and + - * / ^
+ * and unary minus match Add, Divide, Multiply, Negate and Power nodes with
+ * exactly that shape; a chain like a*b*c is a single node of three factors.
+ * The optional conditions test what a variable was bound to; see the table
+ * of predicates in Rules.cpp.
+ *
+ * The left hand sides are compiled into a discrimination tree keyed on node
+ * kind and number of children, so for a given node only the rules whose
+ * shape fits are actually tried, in the order they were written; the first
+ * one whose conditions hold is applied.
+ ****************************************************************************/
+class RuleSet
+{
+public:
+    RuleSet(const std::string& name, const std::string& text);
+    ~RuleSet();
+
+    RuleSet(RuleSet const&)             = delete;
+    RuleSet const& operator=(RuleSet const&) = delete;
+
+    // Rewrites the node exp would be with the given children, or returns
+    // null if no rule applies
+    ExprConstSP rewrite(const Expr& exp, const std::vector<ExprConstSP>& children,
+                        const Numbers::NumberFactory&, const Builder&) const;
+
+    const std::string& getName(void) const { return name; }
+    size_t size(void) const { return rules.size(); }
+
+    // How often each rule was tried (its shape fit) and applied
+    void report(std::ostream&) const;
+    static void reportAll(std::ostream&);
+
+private:
+    typedef bool (*Predicate)(const ExprConstSP&);
+
+    struct Pattern
+    {
+        int variable;                  // >= 0 for a variable
+        ID id;
+        double value;                  // for a literal
+        std::vector<Sign> signs;       // for an Add
+        std::vector<Pattern> children;
+    };
+
+    struct Rule
+    {
+        std::string text;
+        Pattern lhs, rhs;
+        std::vector<std::pair<Predicate, unsigned int> > conditions;
+        unsigned int variables;
+        mutable unsigned long tries, hits;
+    };
+
+    // A node of the discrimination tree; rules end at the node reached by
+    // their left hand side in preorder
+    struct Node
+    {
+        std::map<std::pair<ID, unsigned int>, unsigned int> next;
+        int wildcard;
+        std::vector<unsigned int> rules;
+        Node() : wildcard(-1) {}
+    };
+
+    class Reader;
+
+    void compile(const std::string& text);
+    void insert(unsigned int rule);
+    void candidates(unsigned int node, std::vector<const Expr*>& pending,
+                    std::vector<unsigned int>& found) const;
+
+    static bool match(const Pattern&, const ExprConstSP&, std::vector<ExprConstSP>& bindings);
+    static ExprConstSP build(const Pattern&, const std::vector<ExprConstSP>& bindings,
+                             const Numbers::NumberFactory&, const Builder&);
+
+    std::string name;
+    std::vector<Rule> rules;
+    std::vector<Node> tree;
+
+    static std::vector<const RuleSet*>& registry();
+};
+
+} /* namespace Restructurers */
+} /* namespace Visitors */
+} /* namespace Expressions */
+} /* namespace CAS */
+} /* namespace DS */
@@ -1,6 +1,8 @@
 #include "Substitution.hpp"
 #include "exprs.hpp"
 
+#include <algorithm>
+
 namespace DS            {
 namespace CAS           {
 namespace Expressions   {
@@ -12,7 +14,7 @@ ExprConstSP Substitution::symbol(const Symbol& exp, const std::vector<ExprConstS
     if (exp.numberOfChildren())
         return Visitors::Restructurer::symbol(exp, children);
 
-    std::map<std::string, ExprConstSP>::const_iterator it = dictionary.find(exp.getName());
+    Dictionary::const_iterator it = dictionary.find(exp.getAtom());
 
     if (it == dictionary.end())
         return Visitors::Restructurer::symbol(exp, children);
@@ -20,6 +22,133 @@ ExprConstSP Substitution::symbol(const Symbol& exp, const std::vector<ExprConstS
     return it->second;
 }
 
+BulkSubstitution::BulkSubstitution(std::shared_ptr<Expressions::Builder> _eBuilder, ExprConstSP _base)
+    : eBuilder(_eBuilder), base(_base), rebuilt(0)
+{
+    // Post-order walk with an explicit stack, each shared node visited
+    // once; seen holds the node's entry, or -1 if it has no symbol below it
+    std::unordered_map<const Expr*, int> seen;
+    struct Frame { const Expr* node; unsigned int next; };
+    std::vector<Frame> work{ Frame{ base.get(), 0 } };
+    while (!work.empty())
+    {
+        Frame& top = work.back();
+        if (top.next < top.node->numberOfChildren())
+        {
+            const Expr* child = top.node->getChild(top.next++).get();
+            if (seen.find(child) == seen.end())
+                work.push_back(Frame{ child, 0 });
+            continue;
+        }
+        const Expr* node = top.node;
+        work.pop_back();
+
+        Entry entry;
+        entry.node = node;
+        for (unsigned int i = 0; i < node->numberOfChildren(); i++)
+        {
+            int child = seen[node->getChild(i).get()];
+            if (child >= 0)
+                entry.children.push_back(std::make_pair(i, unsigned(child)));
+        }
+        bool leaf = (node->id() == ID::symbol && node->numberOfChildren() == 0);
+        if (!leaf && entry.children.empty())
+        {
+            seen[node] = -1;
+            continue;
+        }
+
+        unsigned int index = entries.size();
+        for (const std::pair<unsigned int, unsigned int>& child : entry.children)
+        {
+            std::vector<unsigned int>& parents = entries[child.second].parents;
+            if (parents.empty() || parents.back() != index)
+                parents.push_back(index);
+        }
+        if (leaf)
+        {
+            Atom atom = static_cast<const Symbol*>(node)->getAtom();
+            std::vector<unsigned int>& places = occurrences[atom];
+            if (places.empty())
+                symbols.push_back(atom);
+            places.push_back(index);
+        }
+        entries.push_back(std::move(entry));
+        seen[node] = index;
+    }
+    dirty.assign(entries.size(), false);
+    values.resize(entries.size());
+}
+
+ExprConstSP BulkSubstitution::apply(const Bindings& bindings)
+{
+    // Mark the bound symbols and everything above them
+    touched.clear();
+    std::vector<unsigned int> work;
+    for (const Bindings::value_type& binding : bindings)
+    {
+        auto it = occurrences.find(binding.first);
+        if (it == occurrences.end())
+            continue;
+        for (unsigned int leaf : it->second)
+        {
+            values[leaf] = binding.second;
+            work.push_back(leaf);
+            while (!work.empty())
+            {
+                unsigned int index = work.back();
+                work.pop_back();
+                if (dirty[index])
+                    continue;
+                dirty[index] = true;
+                touched.push_back(index);
+                for (unsigned int parent : entries[index].parents)
+                    work.push_back(parent);
+            }
+        }
+    }
+    rebuilt = 0;
+    if (touched.empty())
+        return base;
+
+    // Rebuild the marked nodes, children first
+    std::sort(touched.begin(), touched.end());
+    std::vector<ExprConstSP> children;
+    for (unsigned int index : touched)
+    {
+        const Entry& entry = entries[index];
+        if (entry.children.empty())
+            continue; // a bound symbol, whose value is already in place
+        Expr::Children original = entry.node->getChildren();
+        children.assign(original.begin(), original.end());
+        for (const std::pair<unsigned int, unsigned int>& child : entry.children)
+            if (dirty[child.second])
+                children[child.first] = values[child.second];
+        values[index] = eBuilder->rebuild(*entry.node, children);
+        rebuilt++;
+    }
+
+    ExprConstSP result = values[touched.back()];
+    for (unsigned int index : touched)
+    {
+        dirty[index] = false;
+        values[index].reset();
+    }
+    return result;
+}
+
+std::vector<ExprConstSP> BulkSubstitution::apply(const std::vector<Bindings>& sets, const Simplifier& simplify)
+{
+    std::vector<ExprConstSP> results;
+    results.reserve(sets.size());
+    for (const Bindings& bindings : sets)
+    {
+        ExprConstSP result = apply(bindings);
+        results.push_back(simplify ? simplify(result) : result);
+    }
+    return results;
+}
+
 } /* namespace Restructurers */
 } /* namespace Visitors */
 } /* namespace Expressions */
@@ -1,8 +1,10 @@
 #pragma once
 
-#include <string>
-#include <map>
+#include <functional>
+#include <unordered_map>
+#include <vector>
 #include "Restructurer.hpp"
+#include "Atom.hpp"
 
 namespace DS { namespace CAS { namespace Numbers {
     class NumberFactory;
@@ -17,15 +19,67 @@ namespace Restructurers {
 class Substitution: public DS::CAS::Expressions::Visitors::Restructurer
 {
 public:
+    typedef std::unordered_map<Atom, ExprConstSP, Atom::Hash> Dictionary;
+
     Substitution(std::shared_ptr<Numbers::NumberFactory> _nFactory, std::shared_ptr<Expressions::Builder> _eBuilder,
-                 const std::map<std::string,ExprConstSP>& _dictionary) : Restructurer(_nFactory, _eBuilder), dictionary(_dictionary) {}
+                 const Dictionary& _dictionary) : Restructurer(_nFactory, _eBuilder), dictionary(_dictionary) {}
     virtual ~Substitution() {}
 
-    std::map<std::string, ExprConstSP>& getDictionary(void) { return dictionary; }
+    Dictionary& getDictionary(void) { return dictionary; }
 
 protected:
     virtual ExprConstSP symbol(const Symbol& exp, const std::vector<ExprConstSP>& children);
-    std::map<std::string, ExprConstSP> dictionary;
+    Dictionary dictionary;
+};
+
+/****************************************************************************
+ * Substitutes many sets of bindings into one base expression.  The places
+ * where each symbol occurs are found once, up front; applying a set of
+ * bindings then rebuilds only the nodes on the paths from the bound
+ * symbols up to the root, and every other subtree of the result is the
+ * base's own.  A node shared in the base is rebuilt once and stays shared.
+ ****************************************************************************/
+class BulkSubstitution
+{
+public:
+    typedef Substitution::Dictionary Bindings;
+    typedef std::function<ExprConstSP (ExprConstSP)> Simplifier;
+
+    BulkSubstitution(std::shared_ptr<Expressions::Builder> _eBuilder, ExprConstSP _base);
+
+    ExprConstSP apply(const Bindings& bindings);
+    // One result for each set of bindings, passed through simplify if
+    // one is given
+    std::vector<ExprConstSP> apply(const std::vector<Bindings>& sets, const Simplifier& simplify = Simplifier());
+
+    ExprConstSP getBase(void) const { return base; }
+    // The symbols (without children) of the base, in the order found
+    const std::vector<Atom>& getSymbols(void) const { return symbols; }
+    // Nodes built by the last apply(const Bindings&)
+    unsigned int getRebuilt(void) const { return rebuilt; }
+
+private:
+    // A node with a symbol below it, its children that are too (as
+    // child index, entry index) and the entries it is a child of
+    struct Entry
+    {
+        const Expr* node;
+        std::vector<std::pair<unsigned int, unsigned int> > children;
+        std::vector<unsigned int> parents;
+    };
+
+    std::shared_ptr<Expressions::Builder> eBuilder;
+    ExprConstSP base;
+    // In post-order, so that children come before their parents
+    std::vector<Entry> entries;
+    std::unordered_map<Atom, std::vector<unsigned int>, Atom::Hash> occurrences;
+    std::vector<Atom> symbols;
+
+    // Per application, kept to save reallocating them
+    std::vector<bool> dirty;
+    std::vector<ExprConstSP> values;
+    std::vector<unsigned int> touched;
+    unsigned int rebuilt;
 };
 
 } /* namespace Restructurers */
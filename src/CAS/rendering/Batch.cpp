@@ -0,0 +1,486 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include "Batch.hpp"
+
+namespace DS          {
+namespace CAS         {
+namespace Expressions {
+namespace Bytecode    {
+
+typedef void (*UnaryKernel)(double*, const double*, size_t);
+typedef void (*BinaryKernel)(double*, const double*, const double*, size_t);
+typedef void (*PowerIntegerKernel)(double*, const double*, int, size_t);
+
+struct Batch::Table
+{
+    const char* name;
+    BinaryKernel add, subtract, multiply, divide, power;
+    UnaryKernel negate, exp, ln, sin, cos, tan;
+    PowerIntegerKernel powerInteger;
+};
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+// Kernels
+////////////////////////////////////////////////////////////////////////////////
+
+// The kernels are written once over GCC vector types of each width and
+// forced inline into functions built for each instruction set below.
+// Vectors are passed by reference, so that no function taking or
+// returning one is ever called across instruction sets.
+#define KERNEL inline __attribute__((always_inline))
+
+typedef double D2 __attribute__((vector_size(16)));
+typedef double D4 __attribute__((vector_size(32)));
+typedef double D8 __attribute__((vector_size(64)));
+
+// Adding and subtracting this rounds a double below 2^51 to an integer,
+// which is then in the low bits of the sum
+const double shifter = 0x1.8p52;
+
+const double ln2High = 6.93147180369123816490e-01;
+const double ln2Low  = 1.90821492927058770002e-10;
+
+struct Add      { template<typename V> static KERNEL void apply(V& y, const V& a, const V& b) { y = a + b; } };
+struct Subtract { template<typename V> static KERNEL void apply(V& y, const V& a, const V& b) { y = a - b; } };
+struct Multiply { template<typename V> static KERNEL void apply(V& y, const V& a, const V& b) { y = a * b; } };
+struct Divide   { template<typename V> static KERNEL void apply(V& y, const V& a, const V& b) { y = a / b; } };
+struct Negate   { template<typename V> static KERNEL void apply(V& y, const V& x) { y = -x; } };
+
+// e^x = 2^n e^r with |r| <= ln(2)/2, e^r by its Taylor series to r^12;
+// 2^n is built in the exponent field, in two steps where it would not
+// be a normal number
+struct Exp
+{
+    template<typename V>
+    static KERNEL void apply(V& y, const V& x)
+    {
+        typedef decltype(x < x) I;
+        const V zero = {};
+        const V high = zero + 709.8, low = zero - 746.0;
+        V xc = (x > high) ? high : x;
+        xc = (xc < low) ? low : xc;
+
+        V t = xc*1.4426950408889634 + shifter;
+        V n = t - shifter;
+        V r = (xc - n*ln2High) - n*ln2Low;
+        V p = zero + 1.0/479001600;
+        p = p*r + 1.0/39916800;
+        p = p*r + 1.0/3628800;
+        p = p*r + 1.0/362880;
+        p = p*r + 1.0/40320;
+        p = p*r + 1.0/5040;
+        p = p*r + 1.0/720;
+        p = p*r + 1.0/120;
+        p = p*r + 1.0/24;
+        p = p*r + 1.0/6;
+        p = p*r + 0.5;
+        p = p*r + 1.0;
+        p = p*r + 1.0;
+
+        I tiny = xc < -708.0, huge = xc > 709.0;
+        I bits = (I)t + (tiny & 64) - (huge & 1);
+        V scale = (V)((bits << 52) + (std::int64_t(1023) << 52));
+        const V one = zero + 1.0, down = zero + 0x1p-64, up = zero + 2.0;
+        y = p*scale*(tiny ? down : (huge ? up : one));
+        y = (x < -745.2) ? zero : y;
+    }
+};
+
+// ln x = e ln 2 + ln m with m in [sqrt(1/2), sqrt(2)); ln m as in fdlibm,
+// from the series in s = (m - 1)/(m + 1)
+struct Ln
+{
+    template<typename V>
+    static KERNEL void apply(V& y, const V& x)
+    {
+        typedef decltype(x < x) I;
+        typedef std::uint64_t U __attribute__((vector_size(sizeof(V))));
+        const V zero = {};
+        I subnormal = x < 0x1p-1022;
+        V xs = subnormal ? x*0x1p52 : x;
+        I bits = (I)xs;
+        // Shifted unsigned: there is no arithmetic shift of 64 bit lanes
+        // before AVX-512
+        I e = (I)((U)bits >> 52) - 1023 - (subnormal & 52);
+        V m = (V)((bits & 0x000fffffffffffffLL) | 0x3ff0000000000000LL);
+        I big = m > 1.4142135623730951;
+        m = big ? m*0.5 : m;
+        e = e - big;
+
+        V f = m - 1.0;
+        V s = f/(f + 2.0);
+        V s2 = s*s;
+        V R = zero + 2.0/21;
+        R = R*s2 + 2.0/19;
+        R = R*s2 + 2.0/17;
+        R = R*s2 + 2.0/15;
+        R = R*s2 + 2.0/13;
+        R = R*s2 + 2.0/11;
+        R = R*s2 + 2.0/9;
+        R = R*s2 + 2.0/7;
+        R = R*s2 + 2.0/5;
+        R = R*s2 + 2.0/3;
+        R = R*s2;
+        V halfSquare = 0.5*f*f;
+        V lnm = f - (halfSquare - s*(halfSquare + R));
+
+        V k = (V)(e + 0x4338000000000000LL) - shifter;
+        y = k*ln2High + (lnm + k*ln2Low);
+
+        const V inf = zero + std::numeric_limits<double>::infinity();
+        const V nan = zero + std::numeric_limits<double>::quiet_NaN();
+        y = (x == zero) ? -inf : y;
+        y = (x < zero) ? nan : y;
+        y = (x == inf) ? inf : y;
+        y = (x != x) ? x : y;
+    }
+};
+
+// x = n pi/2 + r with |r| <= pi/4, pi/2 in four parts so that n pi/2 is
+// exact for |x| up to 1e8; sin r and cos r by their Taylor series, and
+// the quadrant (n + quarter, for cos) picks between them.  Larger |x|
+// (and inf and NaN) go through the library one lane at a time.
+template<int quarter>
+struct SinCos
+{
+    template<typename V>
+    static KERNEL void apply(V& y, const V& x)
+    {
+        typedef decltype(x < x) I;
+        const V zero = {};
+        V q = x*0.63661977236758134308 + shifter;
+        I n = (I)q + quarter;
+        V k = q - shifter;
+        V r = x - k*1.5707963109016418457;
+        r = r - k*1.5893254712295856735e-08;
+        r = r - k*6.123233932053594251e-17;
+        r = r - k*6.368317163510949908e-25;
+        V r2 = r*r;
+
+        V s = zero + 1.0/355687428096000;
+        s = s*r2 - 1.0/1307674368000;
+        s = s*r2 + 1.0/6227020800;
+        s = s*r2 - 1.0/39916800;
+        s = s*r2 + 1.0/362880;
+        s = s*r2 - 1.0/5040;
+        s = s*r2 + 1.0/120;
+        s = s*r2 - 1.0/6;
+        s = r + r*r2*s;
+
+        V c = zero + 1.0/20922789888000;
+        c = c*r2 - 1.0/87178291200;
+        c = c*r2 + 1.0/479001600;
+        c = c*r2 - 1.0/3628800;
+        c = c*r2 + 1.0/40320;
+        c = c*r2 - 1.0/720;
+        c = c*r2 + 1.0/24;
+        c = c*r2 - 0.5;
+        c = c*r2 + 1.0;
+
+        y = ((n & 1) != 0) ? c : s;
+        y = ((n & 2) != 0) ? -y : y;
+
+        V magnitude = (x < zero) ? -x : x;
+        I far = !(magnitude <= 1e8);
+        std::int64_t any = 0;
+        for (unsigned int i = 0; i < sizeof(V)/sizeof(double); i++)
+            any |= far[i];
+        if (__builtin_expect(any != 0, 0))
+            for (unsigned int i = 0; i < sizeof(V)/sizeof(double); i++)
+                if (far[i])
+                    y[i] = quarter ? std::cos(x[i]) : std::sin(x[i]);
+    }
+};
+
+struct Tan
+{
+    template<typename V>
+    static KERNEL void apply(V& y, const V& x)
+    {
+        V s, c;
+        SinCos<0>::apply(s, x);
+        SinCos<1>::apply(c, x);
+        y = s/c;
+    }
+};
+
+// |a|^b as e^(b ln|a|), negated for a negative and b odd, and NaN for a
+// negative and b not an integer
+struct Power
+{
+    template<typename V>
+    static KERNEL void apply(V& y, const V& a, const V& b)
+    {
+        typedef decltype(a < a) I;
+        const V zero = {};
+        V magnitude = (a < zero) ? -a : a, l, t;
+        Ln::apply(l, magnitude);
+        t = b*l;
+        Exp::apply(y, t);
+
+        V bMagnitude = (b < zero) ? -b : b;
+        V rounded = b + shifter;
+        I small = bMagnitude < 0x1p51;
+        I integer = ((rounded - shifter) == b) | ~small;
+        I odd = (((I)rounded & 1) != 0) & small;
+        const V one = zero + 1.0, nan = zero + std::numeric_limits<double>::quiet_NaN();
+        V negated = odd ? -y : y;
+        y = (a < zero) ? (integer ? negated : nan) : y;
+        y = (b == zero) ? one : y;
+        y = (a == one) ? one : y;
+    }
+};
+
+template<typename V, typename F>
+KERNEL void unary(double* d, const double* a, size_t n, const F& f = F())
+{
+    const size_t lanes = sizeof(V)/sizeof(double);
+    V x, y;
+    size_t i = 0;
+    for (; i + lanes <= n; i += lanes)
+    {
+        std::memcpy(&x, a + i, sizeof(V));
+        f.apply(y, x);
+        std::memcpy(d + i, &y, sizeof(V));
+    }
+    if (i < n)
+    {
+        double in[lanes] = {}, out[lanes];
+        std::memcpy(in, a + i, (n - i)*sizeof(double));
+        std::memcpy(&x, in, sizeof(V));
+        f.apply(y, x);
+        std::memcpy(out, &y, sizeof(V));
+        std::memcpy(d + i, out, (n - i)*sizeof(double));
+    }
+}
+
+template<typename V, typename F>
+KERNEL void binary(double* d, const double* a, const double* b, size_t n)
+{
+    const size_t lanes = sizeof(V)/sizeof(double);
+    V x, z, y;
+    size_t i = 0;
+    for (; i + lanes <= n; i += lanes)
+    {
+        std::memcpy(&x, a + i, sizeof(V));
+        std::memcpy(&z, b + i, sizeof(V));
+        F::apply(y, x, z);
+        std::memcpy(d + i, &y, sizeof(V));
+    }
+    if (i < n)
+    {
+        double left[lanes] = {}, right[lanes] = {}, out[lanes];
+        std::memcpy(left,  a + i, (n - i)*sizeof(double));
+        std::memcpy(right, b + i, (n - i)*sizeof(double));
+        std::memcpy(&x, left,  sizeof(V));
+        std::memcpy(&z, right, sizeof(V));
+        F::apply(y, x, z);
+        std::memcpy(out, &y, sizeof(V));
+        std::memcpy(d + i, out, (n - i)*sizeof(double));
+    }
+}
+
+// By repeated squaring, as Machine does it
+struct PowerInteger
+{
+    explicit PowerInteger(int _exponent) : exponent(_exponent) {}
+
+    template<typename V>
+    KERNEL void apply(V& y, const V& x) const
+    {
+        const V zero = {};
+        unsigned int e = (exponent < 0) ? -static_cast<unsigned int>(exponent) : exponent;
+        V square = x;
+        y = zero + 1.0;
+        for (; e; e >>= 1)
+        {
+            if (e & 1)
+                y = y*square;
+            if (e > 1)
+                square = square*square;
+        }
+        if (exponent < 0)
+            y = 1.0/y;
+    }
+
+    int exponent;
+};
+
+#define BATCH_KERNELS(Name, Target, V)                                                                     \
+struct Name                                                                                                \
+{                                                                                                          \
+    Target static void add(double* d, const double* a, const double* b, size_t n)      { binary<V, Add>(d, a, b, n); }      \
+    Target static void subtract(double* d, const double* a, const double* b, size_t n) { binary<V, Subtract>(d, a, b, n); } \
+    Target static void multiply(double* d, const double* a, const double* b, size_t n) { binary<V, Multiply>(d, a, b, n); } \
+    Target static void divide(double* d, const double* a, const double* b, size_t n)   { binary<V, Divide>(d, a, b, n); }   \
+    Target static void power(double* d, const double* a, const double* b, size_t n)    { binary<V, Power>(d, a, b, n); }    \
+    Target static void negate(double* d, const double* a, size_t n) { unary<V, Negate>(d, a, n); }         \
+    Target static void exp(double* d, const double* a, size_t n)    { unary<V, Exp>(d, a, n); }            \
+    Target static void ln(double* d, const double* a, size_t n)     { unary<V, Ln>(d, a, n); }             \
+    Target static void sin(double* d, const double* a, size_t n)    { unary<V, SinCos<0> >(d, a, n); }     \
+    Target static void cos(double* d, const double* a, size_t n)    { unary<V, SinCos<1> >(d, a, n); }     \
+    Target static void tan(double* d, const double* a, size_t n)    { unary<V, Tan>(d, a, n); }            \
+    Target static void powerInteger(double* d, const double* a, int e, size_t n) { unary<V>(d, a, n, PowerInteger(e)); } \
+};
+
+BATCH_KERNELS(Sse2,   ,                                      D2)
+BATCH_KERNELS(Avx2,   __attribute__((target("avx2,fma"))),   D4)
+BATCH_KERNELS(Avx512, __attribute__((target("avx512f"))),    D8)
+
+#undef BATCH_KERNELS
+#undef KERNEL
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+// Batch
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename K>
+Batch::Table Batch::tableOf(const char* name)
+{
+    return Table{ name, &K::add, &K::subtract, &K::multiply, &K::divide, &K::power,
+                  &K::negate, &K::exp, &K::ln, &K::sin, &K::cos, &K::tan, &K::powerInteger };
+}
+
+bool Batch::supported(Kernels kernels)
+{
+    switch (kernels)
+    {
+        case Kernels::sse2:   return true;
+        case Kernels::avx2:   return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case Kernels::avx512: return __builtin_cpu_supports("avx512f");
+        case Kernels::best:   return true;
+    }
+    return false;
+}
+
+const Batch::Table* Batch::tableFor(Kernels kernels)
+{
+    static const Table sse2   = tableOf<Sse2>("sse2");
+    static const Table avx2   = tableOf<Avx2>("avx2");
+    static const Table avx512 = tableOf<Avx512>("avx512");
+    if (!supported(kernels))
+        throw std::invalid_argument("kernels not supported by this processor in Bytecode::Batch");
+    switch (kernels)
+    {
+        case Kernels::sse2:   return &sse2;
+        case Kernels::avx2:   return &avx2;
+        case Kernels::avx512: return &avx512;
+        case Kernels::best:   break;
+    }
+    if (supported(Kernels::avx512))
+        return &avx512;
+    if (supported(Kernels::avx2))
+        return &avx2;
+    return &sse2;
+}
+
+const size_t Batch::blockSize;
+
+Batch::Batch(const Program& program, Kernels kernels)
+    : instructions(program.getInstructions())
+    , variables(program.getVariables().size())
+    , constants(program.getConstants().size())
+    , resultRegister(program.getResult())
+    , table(tableFor(kernels))
+    , constantBlocks(constants*blockSize)
+    , temporaryBlocks((program.numberOfRegisters() - variables - constants)*blockSize)
+    , operands(program.numberOfRegisters())
+    , complexMachine(program)
+    , complexInputs(variables)
+    , complexCount(0)
+{
+    for (unsigned int i = 0; i < constants; i++)
+    {
+        double value = toValue(program.getConstants()[i], static_cast<double*>(NULL));
+        std::fill(constantBlocks.begin() + i*blockSize, constantBlocks.begin() + (i + 1)*blockSize, value);
+        operands[variables + i] = constantBlocks.data() + i*blockSize;
+    }
+    for (unsigned int i = variables + constants; i < operands.size(); i++)
+        operands[i] = temporaryBlocks.data() + (i - variables - constants)*blockSize;
+}
+
+const char* Batch::kernelName(void) const
+{
+    return table->name;
+}
+
+void Batch::run(const std::vector<const double*>& columns, size_t points, double* real, double* imaginary)
+{
+    if (columns.size() != variables)
+        throw std::invalid_argument("columns.size() != number of variables in Bytecode::Batch::run");
+
+    complexCount = 0;
+    const unsigned int firstTemporary = variables + constants;
+    for (size_t start = 0; start < points; start += blockSize)
+    {
+        size_t n = std::min(blockSize, points - start);
+        for (unsigned int v = 0; v < variables; v++)
+            operands[v] = columns[v] + start;
+
+        for (const Instruction& i : instructions)
+        {
+            double* d = temporaryBlocks.data() + (i.dest - firstTemporary)*blockSize;
+            const double* a = operands[i.left];
+            const double* b = (i.op <= Op::divide || i.op == Op::power) ? operands[static_cast<unsigned int>(i.right)] : NULL;
+            switch (i.op)
+            {
+                case Op::add:          table->add(d, a, b, n);      break;
+                case Op::subtract:     table->subtract(d, a, b, n); break;
+                case Op::multiply:     table->multiply(d, a, b, n); break;
+                case Op::divide:       table->divide(d, a, b, n);   break;
+                case Op::power:        table->power(d, a, b, n);    break;
+                case Op::powerInteger: table->powerInteger(d, a, i.right, n); break;
+                case Op::negate:       table->negate(d, a, n); break;
+                case Op::exp:          table->exp(d, a, n);    break;
+                case Op::ln:           table->ln(d, a, n);     break;
+                case Op::sin:          table->sin(d, a, n);    break;
+                case Op::cos:          table->cos(d, a, n);    break;
+                case Op::tan:          table->tan(d, a, n);    break;
+                case Op::sqrt:
+                    for (size_t k = 0; k < n; k++)
+                        d[k] = std::sqrt(a[k]);
+                    break;
+                case Op::atan:
+                    for (size_t k = 0; k < n; k++)
+                        d[k] = std::atan(a[k]);
+                    break;
+            }
+        }
+        std::copy(operands[resultRegister], operands[resultRegister] + n, real + start);
+        if (imaginary)
+            std::fill(imaginary + start, imaginary + start + n, 0.0);
+
+        // Redo the points that left the reals
+        for (size_t k = start; k < start + n; k++)
+        {
+            if (real[k] == real[k])
+                continue;
+            bool defined = true;
+            for (unsigned int v = 0; v < variables; v++)
+            {
+                complexInputs[v] = columns[v][k];
+                defined = defined && (columns[v][k] == columns[v][k]);
+            }
+            if (!defined)
+                continue;
+            std::complex<double> value = complexMachine.run(complexInputs.data());
+            real[k] = value.real();
+            if (imaginary)
+                imaginary[k] = value.imag();
+            complexCount++;
+        }
+    }
+}
+
+} /* namespace Bytecode */
+} /* namespace Expressions */
+} /* namespace CAS */
+} /* namespace DS */
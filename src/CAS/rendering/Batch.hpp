@@ -0,0 +1,76 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+#include "Bytecode.hpp"
+
+namespace DS          {
+namespace CAS         {
+namespace Expressions {
+namespace Bytecode    {
+
+// The instruction sets the batch kernels are built for; best is the
+// widest one the processor running the program has
+enum class Kernels { sse2, avx2, avx512, best };
+
+/****************************************************************************
+ * Runs a Program in double over columns of points, one column of values for
+ * each variable.  The points are taken a block at a time, and each
+ * instruction is applied to the whole block by a vector kernel, so that the
+ * cost of decoding an instruction is spread over the block.  The kernels for
+ * add, subtract, multiply, divide, power, exp, ln, sin and cos are in
+ * vector registers (sqrt and atan go a point at a time); exp, ln, sin and
+ * cos are accurate to a few units in the last place.
+ *
+ * A point at which the real evaluation leaves the reals (the log or the
+ * square root of a negative number, a negative number to a fractional
+ * power) comes out as NaN; such points are evaluated again one at a time
+ * in complex arithmetic, which gives the real and imaginary parts of the
+ * result there.
+ ****************************************************************************/
+class Batch
+{
+public:
+    explicit Batch(const Program& program, Kernels kernels = Kernels::best);
+
+    // columns[v] holds the values of the program's variable v at each of
+    // points points.  The results go to real, and their imaginary parts
+    // to imaginary if it is given (zero except at the complex points).
+    void run(const std::vector<const double*>& columns, size_t points,
+             double* real, double* imaginary = NULL);
+
+    // Points of the last run that were evaluated in complex arithmetic
+    size_t complexPoints(void) const { return complexCount; }
+
+    const char* kernelName(void) const;
+    static bool supported(Kernels);
+
+private:
+    static const size_t blockSize = 512;
+
+    struct Table;
+    static const Table* tableFor(Kernels);
+    template<typename K>
+    static Table tableOf(const char* name);
+
+    std::vector<Instruction> instructions;
+    unsigned int variables;
+    unsigned int constants;
+    unsigned int resultRegister;
+    const Table* table;
+
+    // Each constant is repeated through a block, the temporaries
+    // are a block each
+    std::vector<double> constantBlocks;
+    std::vector<double> temporaryBlocks;
+    std::vector<const double*> operands;
+
+    Machine<std::complex<double> > complexMachine;
+    std::vector<std::complex<double> > complexInputs;
+    size_t complexCount;
+};
+
+} /* namespace Bytecode */
+} /* namespace Expressions */
+} /* namespace CAS */
+} /* namespace DS */
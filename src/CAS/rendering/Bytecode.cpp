@@ -0,0 +1,253 @@
+#include <stdexcept>
+#include "Bytecode.hpp"
+#include "exprs.hpp"
+
+using namespace DS::CAS::Numbers;
+using namespace DS::CAS::Numbers::Proxy;
+
+namespace DS          {
+namespace CAS         {
+namespace Expressions {
+namespace Bytecode    {
+
+namespace {
+
+// The operations whose right is a register
+bool binary(Op op)
+{
+    return op == Op::add || op == Op::subtract || op == Op::multiply ||
+           op == Op::divide || op == Op::power;
+}
+
+} // namespace
+
+double toValue(const Number& number, double*)
+{
+    if (const NumberDouble<double>* n = number_static_cast<NumberDouble<double> >(number))
+        return n->getRealPart();
+    if (const NumberDouble<DS::Numbers::Float>* n = number_static_cast<NumberDouble<DS::Numbers::Float> >(number))
+        return n->getRealPart().toDouble();
+    throw std::invalid_argument("unknown number implementation in Bytecode::toValue()");
+}
+
+DS::Numbers::Float toValue(const Number& number, DS::Numbers::Float*)
+{
+    if (const NumberDouble<DS::Numbers::Float>* n = number_static_cast<NumberDouble<DS::Numbers::Float> >(number))
+        return n->getRealPart();
+    if (const NumberDouble<double>* n = number_static_cast<NumberDouble<double> >(number))
+        return DS::Numbers::Float(n->getRealPart());
+    throw std::invalid_argument("unknown number implementation in Bytecode::toValue()");
+}
+
+std::complex<double> toValue(const Number& number, std::complex<double>*)
+{
+    if (const NumberDouble<double>* n = number_static_cast<NumberDouble<double> >(number))
+        return std::complex<double>(n->getRealPart(), n->getImaginaryPart());
+    if (const NumberDouble<DS::Numbers::Float>* n = number_static_cast<NumberDouble<DS::Numbers::Float> >(number))
+        return std::complex<double>(n->getRealPart().toDouble(), n->getImaginaryPart().toDouble());
+    throw std::invalid_argument("unknown number implementation in Bytecode::toValue()");
+}
+
+Compiler::Compiler(const std::vector<Atom>& _variables)
+    : initialVariables(_variables), bindAll(false), temporaries(0)
+{
+    program.variables = initialVariables;
+}
+
+Compiler::Compiler()
+    : bindAll(true), temporaries(0)
+{
+}
+
+void Compiler::reset(void)
+{
+    program = Program();
+    program.variables = initialVariables;
+    operands.clear();
+    freeTemporaries.clear();
+    constantIndex.clear();
+    temporaries = 0;
+}
+
+unsigned int Compiler::temporary(void)
+{
+    if (freeTemporaries.empty())
+        return temporaryBase + temporaries++;
+    unsigned int operand = freeTemporaries.back();
+    freeTemporaries.pop_back();
+    return operand;
+}
+
+void Compiler::release(unsigned int operand)
+{
+    if (operand >= temporaryBase)
+        freeTemporaries.push_back(operand);
+}
+
+// The operands are released before the destination is taken, so an
+// instruction may overwrite one of its own operands
+unsigned int Compiler::emit(Op op, unsigned int left, int right)
+{
+    release(left);
+    if (binary(op))
+        release(static_cast<unsigned int>(right));
+    unsigned int dest = temporary();
+    program.instructions.push_back(Instruction{ op, dest, left, right });
+    return dest;
+}
+
+unsigned int Compiler::pop(void)
+{
+    unsigned int operand = operands.back();
+    operands.pop_back();
+    return operand;
+}
+
+bool Compiler::visitAdd(const Add& exp)
+{
+    unsigned int nc = exp.numberOfChildren();
+    std::vector<unsigned int>::iterator first = operands.end() - nc;
+    unsigned int sum = first[0];
+    if (exp.getSignForChild(0) == Sign::n)
+        sum = emit(Op::negate, sum, 0);
+    for (unsigned int i = 1; i < nc; i++)
+        sum = emit((exp.getSignForChild(i) == Sign::p) ? Op::add : Op::subtract, sum, first[i]);
+    operands.erase(first, operands.end());
+    operands.push_back(sum);
+    return true;
+}
+bool Compiler::visitDivide(const Divide&)
+{
+    unsigned int right = pop();
+    unsigned int left  = pop();
+    operands.push_back(emit(Op::divide, left, right));
+    return true;
+}
+bool Compiler::visitFactorial(const Factorial&)
+{
+    return false;
+}
+bool Compiler::visitLiteral(const Literal& exp)
+{
+    NumberP number = exp.getNumber();
+    if (!number.isReal())
+        return false;
+    size_t hash = number.hash();
+    auto range = constantIndex.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+        if (program.constants[it->second] == number)
+        {
+            operands.push_back(constantBase + it->second);
+            return true;
+        }
+    constantIndex.insert(std::make_pair(hash, program.constants.size()));
+    operands.push_back(constantBase + program.constants.size());
+    program.constants.push_back(number);
+    return true;
+}
+bool Compiler::visitModulus(const Modulus&)
+{
+    return false;
+}
+bool Compiler::visitMultiply(const Multiply& exp)
+{
+    unsigned int nc = exp.numberOfChildren();
+    std::vector<unsigned int>::iterator first = operands.end() - nc;
+    unsigned int product = first[0];
+    for (unsigned int i = 1; i < nc; i++)
+        product = emit(Op::multiply, product, first[i]);
+    operands.erase(first, operands.end());
+    operands.push_back(product);
+    return true;
+}
+bool Compiler::visitNegate(const Negate&)
+{
+    operands.push_back(emit(Op::negate, pop(), 0));
+    return true;
+}
+bool Compiler::visitPower(const Power& exp)
+{
+    unsigned int exponent = pop();
+    unsigned int base     = pop();
+    // Small integer exponents are multiplied out
+    const Expr& power = *exp.getChild(1);
+    if (power.id() == ID::literal)
+    {
+        NumberP number = static_cast<const Literal&>(power).getNumber();
+        if (number.isReal() && number.isRealPartInteger() && number >= -64.0 && number <= 64.0)
+        {
+            int n = static_cast<int>(toValue(number, static_cast<double*>(NULL)));
+            operands.push_back(emit(Op::powerInteger, base, n));
+            return true;
+        }
+    }
+    operands.push_back(emit(Op::power, base, exponent));
+    return true;
+}
+bool Compiler::visitSymbol(const Symbol& exp)
+{
+    if (exp.numberOfChildren() == 0)
+    {
+        for (unsigned int i = 0; i < program.variables.size(); i++)
+            if (program.variables[i] == exp.getAtom())
+            {
+                operands.push_back(i);
+                return true;
+            }
+        if (!bindAll)
+            return false;
+        operands.push_back(program.variables.size());
+        program.variables.push_back(exp.getAtom());
+        return true;
+    }
+
+    static const std::pair<Atom, Op> functions[] = {
+        { Atom("sin"), Op::sin }, { Atom("cos"),  Op::cos  }, { Atom("tan"),  Op::tan  },
+        { Atom("exp"), Op::exp }, { Atom("ln"),   Op::ln   }, { Atom("sqrt"), Op::sqrt },
+        { Atom("atan"), Op::atan }
+    };
+    if (exp.numberOfChildren() != 1)
+        return false;
+    for (const std::pair<Atom, Op>& function : functions)
+        if (function.first == exp.getAtom())
+        {
+            operands.push_back(emit(function.second, pop(), 0));
+            return true;
+        }
+    return false;
+}
+
+Program Compiler::result(void)
+{
+    if (operands.size() != 1)
+        throw std::logic_error("operands.size() != 1 in Expressions::Bytecode::Compiler::result");
+
+    // Lay out the register file and renumber the operands into it
+    unsigned int variables = program.variables.size();
+    unsigned int constants = program.constants.size();
+    auto place = [&](unsigned int operand) -> unsigned int {
+        if (operand >= temporaryBase)
+            return variables + constants + (operand - temporaryBase);
+        if (operand >= constantBase)
+            return variables + (operand - constantBase);
+        return operand;
+    };
+    for (Instruction& instruction : program.instructions)
+    {
+        instruction.dest = place(instruction.dest);
+        instruction.left = place(instruction.left);
+        if (binary(instruction.op))
+            instruction.right = place(static_cast<unsigned int>(instruction.right));
+    }
+    program.resultRegister = place(operands.back());
+    program.registers = variables + constants + temporaries;
+
+    Program compiled = program;
+    reset();
+    return compiled;
+}
+
+} /* namespace Bytecode */
+} /* namespace Expressions */
+} /* namespace CAS */
+} /* namespace DS */
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include "Float.hpp"
+#include "NumberProxy.hpp"
+#include "NumberDouble.hpp"
+#include "Visitor.hpp"
+#include "Atom.hpp"
+
+namespace DS          {
+namespace CAS         {
+namespace Expressions {
+namespace Bytecode    {
+
+/****************************************************************************
+ * Real valued expressions compiled to straight line code over a file of
+ * registers, for evaluating one expression at many points.  The registers
+ * hold the variables first, then the constants of the expression, then
+ * temporaries; a Machine loads the constants once, so that each run only
+ * stores the variables and executes the instructions.
+ ****************************************************************************/
+
+enum class Op : std::uint8_t {
+    add,    subtract, multiply, divide,
+    negate, power,    powerInteger,
+    sin,    cos,      tan,      exp,    ln,   sqrt,   atan
+};
+
+// dest = left op right; unary operations ignore right, and powerInteger
+// takes its (signed) exponent in right
+struct Instruction
+{
+    Op           op;
+    unsigned int dest;
+    unsigned int left;
+    int          right;
+};
+
+class Program
+{
+public:
+    const std::vector<Atom>& getVariables(void) const { return variables; }
+    const std::vector<Numbers::Proxy::NumberP>& getConstants(void) const { return constants; }
+    const std::vector<Instruction>& getInstructions(void) const { return instructions; }
+
+    unsigned int numberOfRegisters(void) const { return registers; }
+    // The register holding the value of the expression after a run
+    unsigned int getResult(void) const { return resultRegister; }
+
+private:
+    friend class Compiler;
+
+    std::vector<Atom> variables;
+    std::vector<Numbers::Proxy::NumberP> constants;
+    std::vector<Instruction> instructions;
+    unsigned int registers = 0;
+    unsigned int resultRegister = 0;
+};
+
+/****************************************************************************
+ * Compiles an expression built of real literals, the variables, + - * / ^
+ * and the functions sin, cos, tan, exp, ln, sqrt and atan.  Anything else
+ * (an imaginary literal, a symbol that is not a variable, a factorial or a
+ * modulus) fails the visit.  Equal constants share a register, and the
+ * temporaries are reused as soon as their values have been consumed.
+ ****************************************************************************/
+class Compiler: public DS::CAS::Expressions::Visitor
+{
+public:
+    // Variables in the given order, and no other symbols
+    explicit Compiler(const std::vector<Atom>& _variables);
+    // Each symbol without children a variable, in the order found
+    Compiler();
+    virtual ~Compiler() {}
+
+    virtual void reset(void);
+
+    virtual bool visitAdd(const Add&);
+    virtual bool visitDivide(const Divide&);
+    virtual bool visitFactorial(const Factorial&);
+    virtual bool visitLiteral(const Literal&);
+    virtual bool visitModulus(const Modulus&);
+    virtual bool visitMultiply(const Multiply&);
+    virtual bool visitNegate(const Negate&);
+    virtual bool visitPower(const Power&);
+    virtual bool visitSymbol(const Symbol&);
+
+    Program result(void);
+
+private:
+    // Operands are numbered by kind while compiling and laid out in
+    // the register file by result(): variables from 0, constants from
+    // constantBase and temporaries from temporaryBase
+    static const unsigned int constantBase  = 1u << 29;
+    static const unsigned int temporaryBase = 1u << 30;
+
+    unsigned int temporary(void);
+    void release(unsigned int operand);
+    // Appends an instruction and returns its destination
+    unsigned int emit(Op op, unsigned int left, int right);
+    unsigned int emit(Op op, unsigned int left, unsigned int right) { return emit(op, left, static_cast<int>(right)); }
+    unsigned int pop(void);
+
+    std::vector<Atom> initialVariables;
+    bool bindAll;
+
+    Program program;
+    std::vector<unsigned int> operands;
+    std::vector<unsigned int> freeTemporaries;
+    // Constants by hash, to find an equal one
+    std::unordered_multimap<size_t, unsigned int> constantIndex;
+    unsigned int temporaries;
+};
+
+// Conversions of the literals loaded by a Machine; each takes either
+// implementation of NumberDouble, and throws for any other
+double toValue(const Numbers::Number&, double*);
+DS::Numbers::Float toValue(const Numbers::Number&, DS::Numbers::Float*);
+std::complex<double> toValue(const Numbers::Number&, std::complex<double>*);
+
+inline double ln(double x) { return std::log(x); }
+inline std::complex<double> ln(const std::complex<double>& z) { return std::log(z); }
+
+// Runs a Program over values of type T (double, DS::Numbers::Float or
+// std::complex<double>, with which the points where a real evaluation
+// leaves the reals can be redone)
+template<typename T>
+class Machine
+{
+public:
+    explicit Machine(const Program& _program)
+        : instructions(_program.getInstructions())
+        , variables(_program.getVariables().size())
+        , result(_program.getResult())
+        , registers(_program.numberOfRegisters())
+    {
+        const std::vector<Numbers::Proxy::NumberP>& constants = _program.getConstants();
+        for (unsigned int i = 0; i < constants.size(); i++)
+            registers[variables + i] = toValue(constants[i], static_cast<T*>(NULL));
+    }
+
+    unsigned int numberOfVariables(void) const { return variables; }
+
+    // values holds one value for each variable of the program
+    const T& run(const T* values)
+    {
+        for (unsigned int i = 0; i < variables; i++)
+            registers[i] = values[i];
+        execute();
+        return registers[result];
+    }
+
+    // inputs holds numberOfVariables() values for each point, one point
+    // after another; the results, one for each point, go to outputs
+    void run(const std::vector<T>& inputs, std::vector<T>& outputs)
+    {
+        size_t points = variables ? inputs.size()/variables : 1;
+        outputs.resize(points);
+        for (size_t p = 0; p < points; p++)
+            outputs[p] = run(inputs.data() + p*variables);
+    }
+
+private:
+    void execute(void)
+    {
+        using std::sin; using std::cos; using std::exp; using std::sqrt;
+        using std::atan; using std::pow;
+
+        T* r = registers.data();
+        for (const Instruction& i : instructions)
+        {
+            switch (i.op)
+            {
+                case Op::add:          r[i.dest] = r[i.left] + r[i.right]; break;
+                case Op::subtract:     r[i.dest] = r[i.left] - r[i.right]; break;
+                case Op::multiply:     r[i.dest] = r[i.left] * r[i.right]; break;
+                case Op::divide:       r[i.dest] = r[i.left] / r[i.right]; break;
+                case Op::negate:       r[i.dest] = -r[i.left];             break;
+                case Op::power:        r[i.dest] = pow(r[i.left], r[i.right]); break;
+                case Op::powerInteger: r[i.dest] = powerInteger(r[i.left], i.right); break;
+                case Op::sin:          r[i.dest] = sin(r[i.left]);  break;
+                case Op::cos:          r[i.dest] = cos(r[i.left]);  break;
+                case Op::tan:          r[i.dest] = sin(r[i.left])/cos(r[i.left]); break;
+                case Op::exp:          r[i.dest] = exp(r[i.left]);  break;
+                case Op::ln:           r[i.dest] = ln(r[i.left]);   break;
+                case Op::sqrt:         r[i.dest] = sqrt(r[i.left]); break;
+                case Op::atan:         r[i.dest] = atan(r[i.left]); break;
+            }
+        }
+    }
+
+    // By repeated squaring, so that x^2 and the like are exact
+    static T powerInteger(const T& base, int exponent)
+    {
+        unsigned int n = (exponent < 0) ? -static_cast<unsigned int>(exponent) : exponent;
+        T result(1), square(base);
+        for (; n; n >>= 1)
+        {
+            if (n & 1)
+                result = result*square;
+            if (n > 1)
+                square = square*square;
+        }
+        if (exponent < 0)
+            result = T(1)/result;
+        return result;
+    }
+
+    std::vector<Instruction> instructions;
+    unsigned int variables;
+    unsigned int result;
+    std::vector<T> registers;
+};
+
+} /* namespace Bytecode */
+} /* namespace Expressions */
+} /* namespace CAS */
+} /* namespace DS */
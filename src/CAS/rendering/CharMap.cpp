@@ -83,6 +83,35 @@ CenteredCharMatrix CharMap::renderBinaryOp(const string& op, const CenteredCharM
     result += rightArg;
     return result;
 }
+// Sized and centred once, as += would give, rather than copying the
+// growing result for each operand
+CenteredCharMatrix CharMap::renderChain(const vector<CenteredCharMatrix>& operands, const vector<string>& ops, bool spaces)
+{
+    vector<CenteredCharMatrix> pieces;
+    pieces.reserve(2*operands.size());
+    for (unsigned int i = 0; i < operands.size(); i++)
+    {
+        if (i > 0)
+            pieces.push_back(CenteredCharMatrix(spaces ? " " + ops[i-1] + " " : ops[i-1]));
+        pieces.push_back(operands[i]);
+    }
+    unsigned int width = 0, yCenter = 0, below = 0;
+    for (const CenteredCharMatrix& piece : pieces)
+    {
+        width += piece.xSize();
+        yCenter = max(yCenter, piece.yCenter());
+        below = max(below, piece.ySize()-piece.yCenter());
+    }
+    CenteredCharMatrix result(width, yCenter + below);
+    result.setYCenter(yCenter);
+    unsigned int x = 0;
+    for (const CenteredCharMatrix& piece : pieces)
+    {
+        result.insertMatrix(piece, x, yCenter-piece.yCenter());
+        x += piece.xSize();
+    }
+    return result;
+}
 CenteredCharMatrix CharMap::renderUnaryOp(const string& op, const CenteredCharMatrix& arg, bool leftRight)
 {
     if (leftRight)
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <stdexcept>
 #include <memory>
 #include "Matrix.hpp"
@@ -46,9 +47,10 @@ public:
 
     void insertMatrix(const CenteredCharMatrix& _matrix, unsigned int x, unsigned int y)
     {
+        if (x + _matrix.xSize() > xSize() || y + _matrix.ySize() > ySize())
+            throw invalid_argument("coords out of bounds in CenteredCharMatrix::insertMatrix()");
         for (unsigned int _y = 0; _y < _matrix.ySize(); _y++)
-            for (unsigned int _x = 0; _x < _matrix.xSize(); _x++)
-                set(_matrix[_y][_x], _x + x, _y + y);
+            std::copy(_matrix[_y].begin(), _matrix[_y].begin() + _matrix.xSize(), matrix[_y + y].begin() + x);
     }
 
     vector<char>& operator[] (unsigned int i) { return matrix[i]; }
@@ -94,6 +96,7 @@ protected:
     virtual CenteredCharMatrix renderAdjacent(const CenteredCharMatrix& leftArg, const CenteredCharMatrix& rightArg);
     virtual CenteredCharMatrix renderString(const string& arg);
     virtual CenteredCharMatrix renderBinaryOp(const string& op, const CenteredCharMatrix& leftArg, const CenteredCharMatrix& rightArg, bool spaces);
+    virtual CenteredCharMatrix renderChain(const vector<CenteredCharMatrix>& operands, const vector<string>& ops, bool spaces);
     virtual CenteredCharMatrix renderUnaryOp(const string& op, const CenteredCharMatrix& arg, bool leftRight);
     virtual CenteredCharMatrix renderSuperscript(const CenteredCharMatrix& base, const CenteredCharMatrix& super);
     virtual CenteredCharMatrix renderFraction(const CenteredCharMatrix& top, const CenteredCharMatrix& bottom);
@@ -36,36 +36,44 @@ protected:
     virtual T renderAdjacent(const T& leftArg, const T& rightArg) = 0;
     virtual T renderString(const string& arg) = 0;
     virtual T renderBinaryOp(const string& op, const T& leftArg, const T& rightArg, bool spaces) = 0;
+    // The operands of a sum or product with ops[i] between operands[i] and
+    // operands[i+1].  The default folds renderBinaryOp from the right, which
+    // copies the growing result once per operand; renderers for which that
+    // is costly lay the whole chain out at once.
+    virtual T renderChain(const vector<T>& operands, const vector<string>& ops, bool spaces);
     virtual T renderUnaryOp(const string& op, const T& arg, bool leftRight) = 0;
     virtual T renderSuperscript(const T& base, const T& super) = 0;
     virtual T renderFraction(const T& top, const T& bottom) = 0;
 };
 
+template<typename T>
+T Infix<T>::renderChain(const vector<T>& operands, const vector<string>& ops, bool spaces)
+{
+    T result = operands.back();
+    for (size_t i = operands.size()-1; i > 0; i--)
+        result = renderBinaryOp(ops[i-1], operands[i-1], result, spaces);
+    return result;
+}
 template<typename T>
 bool Infix<T>::visitAdd(const Add& exp)
 {
     unsigned int nc = exp.numberOfChildren();
-    T resultLeft, resultRight;
+    vector<T> terms(nc);
+    vector<string> ops(nc-1);
     for (unsigned int currentChild = nc-1; (currentChild+1) >= 1; currentChild--)
     {
-        resultLeft = getPop(this->childResults);
+        terms[currentChild] = getPop(this->childResults);
         if (exp.getSignForChild(currentChild) == Expressions::Sign::n &&
             exp.getChild(currentChild)->id()  == ID::add)
-            resultLeft = renderParenthesis(resultLeft);
+            terms[currentChild] = renderParenthesis(terms[currentChild]);
         if (currentChild != nc-1)
-        {
-            if (exp.getSignForChild(currentChild+1) == Expressions::Sign::p)
-                resultRight = renderBinaryOp("+", resultLeft, resultRight, true);
-            else
-                resultRight = renderBinaryOp("-", resultLeft, resultRight, true);
-        }
-        else
-            resultRight = resultLeft;
+            ops[currentChild] = (exp.getSignForChild(currentChild+1) == Expressions::Sign::p) ? "+" : "-";
     }
+    T result = renderChain(terms, ops, true);
     if (exp.getSignForChild(0) == Expressions::Sign::n)
-        resultRight = renderUnaryOp("-", resultRight, false);
+        result = renderUnaryOp("-", result, false);
 
-    this->childResults.push(resultRight);
+    this->childResults.push(result);
     return true;
 }
 template<typename T>
@@ -137,19 +145,15 @@ template<typename T>
 bool Infix<T>::visitMultiply(const Multiply& exp)
 {
     unsigned int nc = exp.numberOfChildren();
-    T resultLeft, resultRight;
+    vector<T> factors(nc);
     for (unsigned int currentChild = nc-1; (currentChild+1) >= 1; currentChild--)
     {
-        resultLeft = getPop(this->childResults);
+        factors[currentChild] = getPop(this->childResults);
         Expressions::ID id = exp.getChild(currentChild)->id();
         if (id == Expressions::ID::add || id == Expressions::ID::modulus)
-            resultLeft = renderParenthesis(resultLeft);
-        if (currentChild != nc-1)
-            resultRight = renderBinaryOp("*", resultLeft, resultRight, false);
-        else
-            resultRight = resultLeft;
+            factors[currentChild] = renderParenthesis(factors[currentChild]);
     }
-    this->childResults.push(resultRight);
+    this->childResults.push(renderChain(factors, vector<string>(nc-1, "*"), false));
     return true;
 }
 template<typename T>
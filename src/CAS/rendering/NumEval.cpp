@@ -10,7 +10,10 @@ namespace CAS         {
 namespace Expressions {
 namespace Visitors    {
 
-NumEval::NumEval() { }
+NumEval::NumEval(bool _shareSubtrees)
+    : shareSubtrees(_shareSubtrees), evaluated(0), saved(0)
+{
+}
 
 NumEval::~NumEval() { }
 
@@ -21,6 +24,30 @@ NumberP NumEval::result(void)
     return getPop(childResults);
 }
 
+bool NumEval::visitExpression(ExprConstSP exp)
+{
+    if (!shareSubtrees)
+        return Visitor::visitExpression(exp);
+
+    subtrees.number(*exp);
+    values.clear();
+    for (const SharedSubtrees::Step& step : subtrees.getSteps())
+    {
+        for (unsigned int i = 0; i < step.node->numberOfChildren(); i++)
+            childResults.push(values[subtrees.child(step, i)]);
+        if (!visitNode(*step.node))
+        {
+            reset();
+            return false;
+        }
+        values.push_back(getPop(childResults));
+    }
+    childResults.push(values[subtrees.getRoot()]);
+    evaluated = subtrees.getSteps().size();
+    saved = subtrees.repeatedNodes();
+    return true;
+}
+
 bool NumEval::visitAdd(const Add& exp)
 {
     NumberP sum = getPop(childResults);
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <stack>
+#include <vector>
 #include <stdexcept>
 #include "NumberProxy.hpp"
 #include "Visitor.hpp"
+#include "exprs.hpp"
+#include "Structure.hpp"
 #include "Templates.hpp"
 
 //using namespace std;
@@ -15,10 +18,14 @@ namespace CAS         {
 namespace Expressions {
 namespace Visitors    {
 
+// With shareSubtrees, structurally equal subtrees (a shared node, or
+// equal copies of one, as substituting _ several times leaves) are
+// evaluated once and their value reused; evaluationsSaved() tells how
+// many node evaluations that spared the last visit.
 class NumEval: public DS::CAS::Expressions::Visitor
 {
 public:
-    NumEval();
+    explicit NumEval(bool _shareSubtrees = false);
     virtual ~NumEval();
 
     virtual void reset(void)
@@ -26,6 +33,10 @@ public:
         clearStack(childResults);
     }
 
+    virtual bool visitExpression(ExprConstSP);
+    size_t evaluations(void) const { return evaluated; }
+    size_t evaluationsSaved(void) const { return saved; }
+
     virtual bool visitAdd(const Add&);
     virtual bool visitDivide(const Divide&);
     virtual bool visitFactorial(const Factorial&);
@@ -39,7 +50,157 @@ public:
     virtual Numbers::Proxy::NumberP result(void);
 
 protected:
-    std::stack<Numbers::Proxy::NumberP> childResults;
+    ResultStack<Numbers::Proxy::NumberP> childResults;
+
+private:
+    bool shareSubtrees;
+    SharedSubtrees subtrees;
+    std::vector<Numbers::Proxy::NumberP> values;
+    size_t evaluated;
+    size_t saved;
+};
+
+// Evaluates using a single concrete Number implementation N instead of
+// going through NumberProxy; intermediate results are held by value and
+// every arithmetic call is bound statically.  Literals of any other type
+// are converted through N::copyFrom.  Subtrees are shared as by NumEval.
+template<typename N>
+class NumEvalStatic: public DS::CAS::Expressions::Visitor
+{
+public:
+    explicit NumEvalStatic(bool _shareSubtrees = false)
+        : shareSubtrees(_shareSubtrees), evaluated(0), saved(0) {}
+    virtual ~NumEvalStatic() {}
+
+    virtual void reset(void)
+    {
+        childResults.clear();
+    }
+
+    virtual bool visitExpression(ExprConstSP exp)
+    {
+        if (!shareSubtrees)
+            return Visitor::visitExpression(exp);
+
+        // Each step's children are on hand as values, and its result
+        // becomes the value for its number
+        subtrees.number(*exp);
+        values.clear();
+        for (const SharedSubtrees::Step& step : subtrees.getSteps())
+        {
+            for (unsigned int i = 0; i < step.node->numberOfChildren(); i++)
+                childResults.push_back(values[subtrees.child(step, i)]);
+            if (!visitNode(*step.node))
+            {
+                reset();
+                return false;
+            }
+            values.push_back(childResults.back());
+            childResults.pop_back();
+        }
+        childResults.push_back(values[subtrees.getRoot()]);
+        evaluated = subtrees.getSteps().size();
+        saved = subtrees.repeatedNodes();
+        return true;
+    }
+    size_t evaluations(void) const { return evaluated; }
+    size_t evaluationsSaved(void) const { return saved; }
+
+    virtual bool visitAdd(const Add& exp)
+    {
+        unsigned int nc = exp.numberOfChildren();
+        N* first = &childResults[childResults.size()-nc];
+        N& sum = first[nc-1];
+        if (exp.getSignForChild(nc-1) == Expressions::Sign::n)
+            sum.negate();
+        for (int i = static_cast<int>(nc)-2; i >= 0; i--)
+        {
+            N& term = first[i];
+            if (exp.getSignForChild(static_cast<unsigned int>(i)) == Expressions::Sign::n)
+                term.negate();
+            sum.add(term);
+        }
+        first[0] = sum;
+        childResults.resize(childResults.size()-nc+1);
+        return true;
+    }
+    virtual bool visitDivide(const Divide&)
+    {
+        N& right = childResults.back();
+        N& left  = childResults[childResults.size()-2];
+        left.divideBy(right);
+        childResults.pop_back();
+        return true;
+    }
+    virtual bool visitFactorial(const Factorial&)
+    {
+        throw std::invalid_argument("NumEvalStatic::visitFactorial not implemented");
+        return true;
+    }
+    virtual bool visitLiteral(const Literal& exp)
+    {
+        const N* number = Numbers::number_static_cast<N>(exp.getNumber());
+        if (number != NULL)
+            childResults.push_back(*number);
+        else
+        {
+            childResults.push_back(N());
+            childResults.back().copyFrom(exp.getNumber());
+        }
+        return true;
+    }
+    virtual bool visitModulus(const Modulus&)
+    {
+        throw std::invalid_argument("NumEvalStatic::visitModulus not implemented");
+        return true;
+    }
+    virtual bool visitMultiply(const Multiply& exp)
+    {
+        unsigned int nc = exp.numberOfChildren();
+        N* first = &childResults[childResults.size()-nc];
+        N& product = first[nc-1];
+        for (int i = static_cast<int>(nc)-2; i >= 0; i--)
+            product.multiply(first[i]);
+        first[0] = product;
+        childResults.resize(childResults.size()-nc+1);
+        return true;
+    }
+    virtual bool visitNegate(const Negate&)
+    {
+        childResults.back().negate();
+        return true;
+    }
+    virtual bool visitPower(const Power&)
+    {
+        N& exponent = childResults.back();
+        N& base     = childResults[childResults.size()-2];
+        base.raiseToPower(exponent);
+        childResults.pop_back();
+        return true;
+    }
+    virtual bool visitSymbol(const Symbol&)
+    {
+        return false;
+    }
+
+    virtual Numbers::Proxy::NumberP result(void)
+    {
+        if (childResults.size() != 1)
+            throw std::logic_error("childResults.size() != 1 in Expressions::Visitors::NumEvalStatic::result");
+        Numbers::Proxy::NumberP result(new N(childResults.back()));
+        childResults.clear();
+        return result;
+    }
+
+protected:
+    std::vector<N> childResults;
+
+private:
+    bool shareSubtrees;
+    SharedSubtrees subtrees;
+    std::vector<N> values;
+    size_t evaluated;
+    size_t saved;
 };
 
 } /* namespace Visitors */
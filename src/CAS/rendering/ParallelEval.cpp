@@ -0,0 +1,29 @@
+#include <cmath>
+#include "ParallelEval.hpp"
+#include "exprs.hpp"
+
+namespace DS          {
+namespace CAS         {
+namespace Expressions {
+namespace Visitors    {
+
+double evaluationCost(const Expr& node, unsigned int precision)
+{
+    double units = (precision > 0) ? precision : 1;
+    // Newton's method and the AGM both double the bits right each step
+    double steps = std::log2(units*UNIT_T_BITS);
+    switch (node.id())
+    {
+        case ID::add:      return node.numberOfChildren()/units;
+        case ID::negate:   return 1/units;
+        case ID::multiply: return node.numberOfChildren() - 1.0;
+        case ID::divide:   return steps;
+        case ID::power:    return steps*steps*steps;
+        default:           return 0;
+    }
+}
+
+} /* namespace Visitors */
+} /* namespace Expressions */
+} /* namespace CAS */
+} /* namespace DS */
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include "Float.hpp"
+#include "NumberProxy.hpp"
+#include "NumEval.hpp"
+#include "Structure.hpp"
+#include "TaskPool.hpp"
+
+namespace DS          {
+namespace CAS         {
+namespace Expressions {
+namespace Visitors    {
+
+// Estimated cost of evaluating node alone, given its children, in
+// multiplications of numbers of precision mantissa units: + and
+// negation are linear, division an inverse by Newton's method, and a
+// power a logarithm and an exponential, each iterating over square
+// roots and inverses
+double evaluationCost(const Expr& node, unsigned int precision);
+
+/****************************************************************************
+ * Evaluates an expression with the threads of a TaskPool, using a single
+ * concrete Number implementation N as NumEvalStatic does.  The distinct
+ * subtrees (numbered by SharedSubtrees, so equal ones are evaluated once)
+ * form a dataflow graph: a subtree is ready once its children have been
+ * evaluated, and the thread that evaluates the last of them goes straight
+ * on to it, unless its estimated cost reaches the threshold, in which case
+ * it is spawned as a task for an idle thread to steal.  So independent
+ * expensive subtrees, like the powers of 2^(1/3) + 3^(1/5)*5^(1/7), are
+ * evaluated at the same time, and cheap ones are not worth a task.
+ *
+ * The numbers are copied and dropped on several threads, which the
+ * reference counts of NumberProxy and of the digits of DS::Numbers make
+ * safe; one ParallelEval evaluates one expression at a time.  A step that
+ * throws (a division by zero, say) stops the evaluation: evaluate() waits
+ * for the tasks already spawned and rethrows the first exception on the
+ * calling thread, as NumEvalStatic would have thrown it.
+ ****************************************************************************/
+template<typename N>
+class ParallelEval
+{
+public:
+    static constexpr double defaultThreshold = 16;
+
+    explicit ParallelEval(TaskPool& _pool, double _threshold = defaultThreshold,
+                          unsigned int _precision = DS::Numbers::Float::precision())
+        : pool(_pool), threshold(_threshold), precision(_precision), spawned(0),
+          outstanding(0), finished(false), failed(false) {}
+
+    ParallelEval(ParallelEval const&) = delete;
+    ParallelEval const& operator= (ParallelEval const&) = delete;
+
+    // False, evaluating nothing, if exp has a symbol, a factorial or
+    // a modulus, as NumEvalStatic would fail or throw on them
+    bool evaluate(ExprConstSP exp)
+    {
+        subtrees.number(*exp);
+        const std::vector<SharedSubtrees::Step>& steps = subtrees.getSteps();
+        unsigned int count = steps.size();
+
+        costs.resize(count);
+        for (unsigned int s = 0; s < count; s++)
+        {
+            ID id = steps[s].node->id();
+            if (id == ID::symbol || id == ID::factorial || id == ID::modulus)
+                return false;
+            costs[s] = evaluationCost(*steps[s].node, precision);
+        }
+
+        // The parents of each step, once for each time it is their child
+        firstParent.assign(count + 1, 0);
+        for (unsigned int child : subtrees.getChildren())
+            firstParent[child + 1]++;
+        for (unsigned int s = 0; s < count; s++)
+            firstParent[s + 1] += firstParent[s];
+        parents.resize(subtrees.getChildren().size());
+        std::vector<unsigned int> next(firstParent.begin(), firstParent.end() - 1);
+        pending.reset(new std::atomic<unsigned int>[count]);
+        std::vector<unsigned int> leaves;
+        for (unsigned int s = 0; s < count; s++)
+        {
+            unsigned int nc = steps[s].node->numberOfChildren();
+            for (unsigned int i = 0; i < nc; i++)
+                parents[next[subtrees.child(steps[s], i)]++] = s;
+            pending[s].store(nc, std::memory_order_relaxed);
+            if (nc == 0)
+                leaves.push_back(s);
+        }
+
+        values.assign(count, N());
+        spawned = 0;
+        outstanding.store(0);
+        finished.store(false);
+        failed.store(false);
+        error = nullptr;
+        try {
+            run(leaves);
+        } catch (...) {
+            fail(std::current_exception());
+        }
+        // Tasks still queued or running use the members, so they are
+        // drained even once the root is done or a step has failed
+        pool.helpUntil([this]() {
+            return (finished.load(std::memory_order_acquire) || failed.load(std::memory_order_acquire))
+                && outstanding.load(std::memory_order_acquire) == 0;
+        });
+        if (failed.load())
+        {
+            finished.store(false);
+            std::rethrow_exception(error);
+        }
+        return true;
+    }
+
+    Numbers::Proxy::NumberP result(void)
+    {
+        if (!finished.load())
+            throw std::logic_error("nothing evaluated in Expressions::Visitors::ParallelEval::result");
+        finished.store(false);
+        return Numbers::Proxy::NumberP(new N(values[subtrees.getRoot()]));
+    }
+
+    // Subtrees of the last evaluation that went to the pool as tasks
+    size_t tasksSpawned(void) const { return spawned; }
+    size_t evaluations(void) const { return subtrees.getSteps().size(); }
+    size_t evaluationsSaved(void) const { return subtrees.repeatedNodes(); }
+
+private:
+    // Evaluates one step at a time by NumEvalStatic's visitX
+    class StepEval: public NumEvalStatic<N>
+    {
+    public:
+        void evaluate(const SharedSubtrees& subtrees, unsigned int s, std::vector<N>& values)
+        {
+            const SharedSubtrees::Step& step = subtrees.getSteps()[s];
+            for (unsigned int i = 0; i < step.node->numberOfChildren(); i++)
+                this->childResults.push_back(values[subtrees.child(step, i)]);
+            this->visitNode(*step.node);
+            values[s] = this->childResults.back();
+            this->childResults.pop_back();
+        }
+    };
+
+    // Keeps the first exception of an evaluation for evaluate() to
+    // rethrow; the other steps stop at their next one
+    void fail(std::exception_ptr e)
+    {
+        std::lock_guard<std::mutex> guard(errorLock);
+        if (!failed.load())
+        {
+            error = e;
+            failed.store(true, std::memory_order_release);
+        }
+    }
+
+    // A step spawned as a task; an exception must not leave it, as it
+    // would leave a thread of the pool
+    void task(unsigned int s)
+    {
+        try {
+            run(std::vector<unsigned int>(1, s));
+        } catch (...) {
+            fail(std::current_exception());
+        }
+        outstanding.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    // Evaluates the given steps and whatever cheap steps they make
+    // ready, until the root is done or a step has failed
+    void run(std::vector<unsigned int> ready)
+    {
+        StepEval eval;
+        unsigned int root = subtrees.getRoot();
+        while (!ready.empty() && !failed.load(std::memory_order_relaxed))
+        {
+            unsigned int s = ready.back();
+            ready.pop_back();
+            eval.evaluate(subtrees, s, values);
+            if (s == root)
+            {
+                finished.store(true, std::memory_order_release);
+                return;
+            }
+            unsigned int first = firstParent[s], last = firstParent[s + 1];
+            for (unsigned int p = first; p < last; p++)
+            {
+                unsigned int parent = parents[p];
+                if (pending[parent].fetch_sub(1, std::memory_order_acq_rel) != 1)
+                    continue;
+                if (costs[parent] < threshold)
+                    ready.push_back(parent);
+                else
+                {
+                    spawned++;
+                    outstanding.fetch_add(1, std::memory_order_acq_rel);
+                    pool.spawn([this, parent]() { task(parent); });
+                }
+            }
+        }
+    }
+
+    TaskPool& pool;
+    double threshold;
+    unsigned int precision;
+
+    SharedSubtrees subtrees;
+    std::vector<double> costs;
+    std::vector<unsigned int> firstParent;
+    std::vector<unsigned int> parents;
+    std::unique_ptr<std::atomic<unsigned int>[]> pending;
+    std::vector<N> values;
+    std::atomic<size_t> spawned;
+    // Tasks spawned and not yet returned
+    std::atomic<unsigned int> outstanding;
+    std::atomic<bool> finished;
+    std::atomic<bool> failed;
+    std::mutex errorLock;
+    std::exception_ptr error;
+};
+
+} /* namespace Visitors */
+} /* namespace Expressions */
+} /* namespace CAS */
+} /* namespace DS */
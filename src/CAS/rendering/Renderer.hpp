@@ -30,7 +30,7 @@ public:
     }
 
 protected:
-    std::stack<T> childResults;
+    ResultStack<T> childResults;
     std::shared_ptr<Numbers::NumberFormatter> formatter;
 };
 
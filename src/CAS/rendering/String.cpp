@@ -28,6 +28,14 @@ string String::renderBinaryOp(const string& op, const string& leftArg, const str
     string space = spaces ? " " : "";
     return leftArg + space + op + space + rightArg;
 }
+string String::renderChain(const vector<string>& operands, const vector<string>& ops, bool spaces)
+{
+    string space = spaces ? " " : "";
+    string result = operands[0];
+    for (size_t i = 1; i < operands.size(); i++)
+        result += space + ops[i-1] + space + operands[i];
+    return result;
+}
 string String::renderUnaryOp(const string& op, const string& arg, bool leftRight)
 {
     if (leftRight)
@@ -26,6 +26,7 @@ protected:
     virtual string renderAdjacent(const string& leftArg, const string& rightArg);
     virtual string renderString(const string& arg);
     virtual string renderBinaryOp(const string& op, const string& leftArg, const string& rightArg, bool spaces);
+    virtual string renderChain(const vector<string>& operands, const vector<string>& ops, bool spaces);
     virtual string renderUnaryOp(const string& op, const string& arg, bool leftRight);
     virtual string renderSuperscript(const string& base, const string& super);
     virtual string renderFraction(const string& top, const string& bottom);
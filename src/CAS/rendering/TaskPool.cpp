@@ -0,0 +1,146 @@
+#include "TaskPool.hpp"
+
+namespace DS          {
+namespace CAS         {
+namespace Expressions {
+
+namespace {
+
+// The pool the current thread belongs to, and its index in it; the
+// thread in helpUntil() is index 0
+struct Membership
+{
+    const TaskPool* pool;
+    unsigned int    index;
+};
+thread_local Membership membership = { nullptr, 0 };
+
+// Makes the current thread a member of a pool for its lifetime, and
+// restores what it was a member of before, however helpUntil() is left
+class Joining
+{
+public:
+    Joining(const TaskPool* pool, unsigned int index) : outer(membership)
+    {
+        membership = Membership{ pool, index };
+    }
+    ~Joining() { membership = outer; }
+
+    Joining(Joining const&) = delete;
+    Joining const& operator= (Joining const&) = delete;
+
+private:
+    Membership outer;
+};
+
+} // namespace
+
+TaskPool::TaskPool(unsigned int count)
+    : queued(0), stolen(0), stopping(false)
+{
+    if (count == 0)
+        count = 1;
+    for (unsigned int i = 0; i < count; i++)
+        queues.emplace_back(new Queue);
+    for (unsigned int i = 1; i < count; i++)
+        threads.emplace_back(&TaskPool::work, this, i);
+}
+
+TaskPool::~TaskPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+unsigned int TaskPool::self(void) const
+{
+    return (membership.pool == this) ? membership.index : 0;
+}
+
+void TaskPool::spawn(Task task)
+{
+    Queue& queue = *queues[self()];
+    {
+        std::lock_guard<std::mutex> guard(queue.lock);
+        queue.tasks.push_back(std::move(task));
+    }
+    queued.fetch_add(1);
+    // A thread between finding nothing queued and sleeping holds
+    // sleepLock, so it cannot miss this
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+    }
+    wake.notify_one();
+}
+
+bool TaskPool::take(unsigned int thread, Task& task)
+{
+    if (queued.load() == 0)
+        return false;
+    for (unsigned int i = 0; i < queues.size(); i++)
+    {
+        unsigned int victim = (thread + i) % queues.size();
+        Queue& queue = *queues[victim];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (queue.tasks.empty())
+            continue;
+        if (i == 0)
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            stolen.fetch_add(1, std::memory_order_relaxed);
+        }
+        queued.fetch_sub(1);
+        return true;
+    }
+    return false;
+}
+
+void TaskPool::work(unsigned int thread)
+{
+    membership = Membership{ this, thread };
+    Task task;
+    while (true)
+    {
+        if (take(thread, task))
+        {
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(sleepLock);
+        wake.wait(guard, [this]() { return stopping || queued.load() != 0; });
+        if (stopping)
+            return;
+    }
+}
+
+void TaskPool::helpUntil(const std::function<bool (void)>& done)
+{
+    Joining joining(this, self());
+    Task task;
+    while (!done())
+    {
+        if (take(membership.index, task))
+        {
+            task();
+            task = nullptr;
+        }
+        else
+            std::this_thread::yield();
+    }
+}
+
+} /* namespace Expressions */
+} /* namespace CAS */
+} /* namespace DS */
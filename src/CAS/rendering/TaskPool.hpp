@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DS          {
+namespace CAS         {
+namespace Expressions {
+
+/****************************************************************************
+ * A fixed set of threads sharing out tasks by work stealing.  Each thread
+ * has its own deque: it pushes the tasks it spawns on the back and takes
+ * its next task from the back, so it works depth first on what it started
+ * itself, and a thread with nothing to do steals from the front of another
+ * thread's deque, where the oldest (and usually biggest) tasks are.
+ *
+ * The thread that calls helpUntil() is one of the threads of the pool
+ * (numberOfThreads() counts it), so only one thread outside the pool may
+ * use it at a time.
+ ****************************************************************************/
+class TaskPool
+{
+public:
+    typedef std::function<void (void)> Task;
+
+    // threads is at least 1; a pool of 1 starts no threads and runs
+    // everything in helpUntil()
+    explicit TaskPool(unsigned int threads = std::thread::hardware_concurrency());
+    ~TaskPool();
+
+    TaskPool(TaskPool const&) = delete;
+    TaskPool const& operator= (TaskPool const&) = delete;
+
+    unsigned int numberOfThreads(void) const { return queues.size(); }
+
+    // Queues task on the calling thread's deque; from a task, or from
+    // the thread in helpUntil().  The task must not throw: nothing on
+    // the threads of the pool would catch it.
+    void spawn(Task task);
+
+    // Runs tasks of the pool until done() is true; done is polled
+    // between tasks, and must become true through tasks of the pool
+    void helpUntil(const std::function<bool (void)>& done);
+
+    // Tasks run by a thread other than the one that spawned them,
+    // since the pool was made
+    unsigned long tasksStolen(void) const { return stolen; }
+
+private:
+    struct Queue
+    {
+        std::mutex       lock;
+        std::deque<Task> tasks;
+    };
+
+    unsigned int self(void) const;
+    bool take(unsigned int thread, Task& task);
+    void work(unsigned int thread);
+
+    std::vector<std::unique_ptr<Queue> > queues;
+    std::vector<std::thread> threads;
+
+    // Tasks in all the deques; threads with none to take sleep on wake
+    std::atomic<unsigned long> queued;
+    std::atomic<unsigned long> stolen;
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    bool stopping;
+};
+
+} /* namespace Expressions */
+} /* namespace CAS */
+} /* namespace DS */
@@ -0,0 +1,159 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Float.hpp"
+#include "NumberDouble.hpp"
+#include "NumberFactoryStatic.hpp"
+#include "NumberFormatterStandard.hpp"
+#include "scanner-builder.hpp"
+#include "tokenizer.hpp"
+#include "Standard.hpp"
+#include "infix-parser.hpp"
+#include "exprs.hpp"
+#include "NumEval.hpp"
+#include "Batch.hpp"
+
+using std::cout;
+using std::endl;
+using std::function;
+using std::string;
+using std::vector;
+
+using namespace DS::CAS;
+using namespace DS::CAS::Numbers;
+using namespace DS::CAS::Expressions;
+
+typedef NumberDouble<DS::Numbers::Float> NumberImp;
+
+namespace {
+
+std::shared_ptr<castle::scanner_builder> scannerBuilder(new castle::scanner_builder);
+std::shared_ptr<castle::tokenizer>       tokenizer(new castle::tokenizer);
+std::shared_ptr<NumberFactory>           nFactory(new NumberFactoryStatic<NumberImp>());
+std::shared_ptr<NumberFormatter>         nFormatter(new NumberFormatterStandard(nFactory, scannerBuilder, 30));
+std::shared_ptr<Builder>                 eBuilder(new Builders::Standard);
+
+double time_fn(function<void ()> f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+typedef std::unordered_map<Atom, ExprConstSP, Atom::Hash> Bindings;
+
+ExprConstSP substitute(ExprConstSP exp, const Bindings& bindings)
+{
+    if (exp->id() == ID::symbol && exp->numberOfChildren() == 0)
+    {
+        Bindings::const_iterator it = bindings.find(static_cast<const Symbol&>(*exp).getAtom());
+        return (it == bindings.end()) ? exp : it->second;
+    }
+    if (exp->numberOfChildren() == 0)
+        return exp;
+    vector<ExprConstSP> children;
+    for (const ExprConstSP& child : exp->getChildren())
+        children.push_back(substitute(child, bindings));
+    return eBuilder->rebuild(*exp, children);
+}
+
+// The points per second of one NumEval tree walk per point, with the
+// point substituted into the expression as literals
+double numEvalRate(ExprConstSP exp, const vector<Atom>& variables, const vector<vector<double> >& columns, size_t count)
+{
+    double seconds = time_fn([&]() {
+        for (size_t p = 0; p < count; p++)
+        {
+            Bindings bindings;
+            for (size_t v = 0; v < variables.size(); v++)
+                bindings[variables[v]] = eBuilder->literal(new NumberImp(DS::Numbers::Float(columns[v][p])));
+            Visitors::NumEvalStatic<NumberImp> eval;
+            eval.visitExpression(substitute(exp, bindings));
+        }
+    });
+    return count/seconds;
+}
+
+// Evaluates text at points points, with the variables spread over the
+// given ranges, by each way there is
+void compare(const string& text, const vector<string>& names, const vector<double>& from, const vector<double>& to, size_t points)
+{
+    Parsers::Infix parser(scannerBuilder, eBuilder, nFormatter, tokenizer);
+    ExprConstSP exp = parser.parse(text);
+    vector<Atom> variables(names.begin(), names.end());
+    Bytecode::Compiler compiler(variables);
+    if (!exp || !compiler.visitExpression(exp))
+    {
+        cout << "  cannot compile " << text << endl;
+        return;
+    }
+    Bytecode::Program program = compiler.result();
+
+    vector<vector<double> > columns(variables.size(), vector<double>(points));
+    vector<const double*> pointers;
+    for (size_t v = 0; v < variables.size(); v++)
+    {
+        // Each variable goes through its range at a different rate
+        double rate = 1.0 + 0.6180339887498949*v;
+        for (size_t p = 0; p < points; p++)
+        {
+            double fraction = std::fmod(rate*p/points, 1.0);
+            columns[v][p] = from[v] + (to[v] - from[v])*fraction;
+        }
+        pointers.push_back(columns[v].data());
+    }
+
+    cout << text << " (" << program.getInstructions().size() << " instructions)" << endl;
+
+    size_t sample = std::min<size_t>(points, 2000);
+    cout << "  NumEval on Float:   " << numEvalRate(exp, variables, columns, sample) << " points/s" << endl;
+
+    vector<double> expected(points), inputs(variables.size());
+    Bytecode::Machine<double> machine(program);
+    double seconds = time_fn([&]() {
+        for (size_t p = 0; p < points; p++)
+        {
+            for (size_t v = 0; v < variables.size(); v++)
+                inputs[v] = columns[v][p];
+            expected[p] = machine.run(inputs.data());
+        }
+    });
+    cout << "  Machine<double>:    " << points/seconds << " points/s" << endl;
+
+    const Bytecode::Kernels kernels[] = { Bytecode::Kernels::sse2, Bytecode::Kernels::avx2, Bytecode::Kernels::avx512 };
+    for (Bytecode::Kernels k : kernels)
+    {
+        if (!Bytecode::Batch::supported(k))
+            continue;
+        Bytecode::Batch batch(program, k);
+        vector<double> real(points), imaginary(points);
+        seconds = time_fn([&]() { batch.run(pointers, points, real.data(), imaginary.data()); });
+
+        // Relative to the larger of the value and 1, at the real points
+        double error = 0;
+        for (size_t p = 0; p < points; p++)
+            if (std::isfinite(expected[p]))
+                error = std::max(error, std::fabs(real[p] - expected[p])/std::max(1.0, std::fabs(expected[p])));
+        string name = batch.kernelName();
+        cout << "  Batch (" << name << "):" << string(12 - name.size(), ' ') << points/seconds << " points/s, "
+             << "max error " << error << ", " << batch.complexPoints() << " complex points" << endl;
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t points = (argc > 1) ? std::atol(argv[1]) : 1000000;
+    compare("sin(x)*exp(-y/3) + ln(1 + x^2 + y^2) - (x - y)^3/7", { "x", "y" }, { -10, -3 }, { 10, 3 }, points);
+    compare("x^y + cos(x*y)/(1 + x)",                               { "x", "y" }, { 0.1, -4 }, { 10, 4 }, points);
+    compare("sqrt(x) + ln(x)*x",                                    { "x" },      { -1 },      { 1 },     points);
+    return 0;
+}
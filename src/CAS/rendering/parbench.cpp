@@ -0,0 +1,111 @@
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "Float.hpp"
+#include "NumberDouble.hpp"
+#include "NumberFactoryStatic.hpp"
+#include "NumberFormatterStandard.hpp"
+#include "scanner-builder.hpp"
+#include "tokenizer.hpp"
+#include "Standard.hpp"
+#include "infix-parser.hpp"
+#include "NumEval.hpp"
+#include "ParallelEval.hpp"
+#include "TaskPool.hpp"
+
+using std::cout;
+using std::endl;
+using std::function;
+using std::string;
+
+using namespace DS::CAS;
+using namespace DS::CAS::Numbers;
+using namespace DS::CAS::Expressions;
+using namespace DS::CAS::Expressions::Visitors;
+
+typedef NumberDouble<DS::Numbers::Float> NumberImp;
+
+namespace {
+
+std::shared_ptr<castle::scanner_builder> scannerBuilder(new castle::scanner_builder);
+std::shared_ptr<castle::tokenizer>       tokenizer(new castle::tokenizer);
+std::shared_ptr<NumberFactory>           nFactory(new NumberFactoryStatic<NumberImp>());
+std::shared_ptr<NumberFormatter>         nFormatter(new NumberFormatterStandard(nFactory, scannerBuilder, 30));
+std::shared_ptr<Builder>                 eBuilder(new Builders::Standard);
+
+double time_fn(function<void ()> f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// A sum of terms products of powers, all of them independent
+string powers(unsigned int terms)
+{
+    const unsigned int primes[] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37 };
+    string text;
+    for (unsigned int t = 0; t < terms; t++)
+    {
+        unsigned int p = primes[t % 12], q = primes[(t + 5) % 12];
+        text += (t ? " + " : "") + std::to_string(p) + "^(1/" + std::to_string(q + t) + ")*"
+              + std::to_string(q) + "^(" + std::to_string(t + 1) + "/" + std::to_string(p + 1) + ")";
+    }
+    return text;
+}
+
+// Times NumEvalStatic, then ParallelEval on 1, 2, 4, ... threads up to
+// twice the hardware's, on text
+void compare(const string& text, unsigned int repeats)
+{
+    Parsers::Infix parser(scannerBuilder, eBuilder, nFormatter, tokenizer);
+    ExprConstSP exp = parser.parse(text);
+    cout << text.substr(0, 60) << (text.size() > 60 ? " ..." : "") << endl;
+
+    string expected;
+    double serial = time_fn([&]() {
+        for (unsigned int r = 0; r < repeats; r++)
+        {
+            NumEvalStatic<NumberImp> eval(true);
+            eval.visitExpression(exp);
+            expected = nFormatter->formatRealPart(eval.result());
+        }
+    });
+    cout << "  NumEvalStatic:      " << serial/repeats << " s" << endl;
+
+    unsigned int hardware = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int threads = 1; threads <= 2*hardware; threads *= 2)
+    {
+        TaskPool pool(threads);
+        ParallelEval<NumberImp> eval(pool);
+        string value;
+        double seconds = time_fn([&]() {
+            for (unsigned int r = 0; r < repeats; r++)
+            {
+                eval.evaluate(exp);
+                value = nFormatter->formatRealPart(eval.result());
+            }
+        });
+        cout << "  " << threads << " thread" << (threads > 1 ? "s: " : ":  ") << string(threads < 10 ? 12 : 11, ' ')
+             << seconds/repeats << " s, speedup " << serial/seconds << ", "
+             << eval.tasksSpawned() << " tasks, " << pool.tasksStolen() << " stolen"
+             << (value == expected ? "" : ", WRONG VALUE") << endl;
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    unsigned int repeats = (argc > 1) ? std::atoi(argv[1]) : 3;
+    cout << "hardware threads: " << std::thread::hardware_concurrency() << endl;
+    compare(powers(4), repeats);
+    compare(powers(16), repeats);
+    compare("(2^(1/3) + 3^(1/5))^(1/7) * (5^(1/9) - 7^(1/11))^(2/3)", repeats);
+    return 0;
+}
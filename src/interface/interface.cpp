@@ -21,12 +21,14 @@
 #include "tokenizer.hpp"
 #include "token.hpp"
 #include "NumberFactory.hpp"
-#include "NumberFactoryPrototype.hpp"
+#include "NumberFactoryStatic.hpp"
 #include "NumberFormatter.hpp"
 #include "NumberFormatterStandard.hpp"
 #include "NumberProxy.hpp"
 #include "NumberDouble.hpp"
 #include "Standard.hpp"
+#include "Folding.hpp"
+#include "Region.hpp"
 #include "parser.hpp"
 #include "infix-parser.hpp"
 #include "InfixRender.hpp"
@@ -59,9 +61,12 @@ typedef CAS::Numbers::NumberDouble<FloatType>     NumberImp;
 
 std::shared_ptr<scanner_builder>        scannerBuilder_ptr  (new scanner_builder);
 std::shared_ptr<tokenizer>              tokenizer_ptr       (new tokenizer);
-std::shared_ptr<NumberFactory>          nFactory_ptr        (new NumberFactoryPrototype(Proxy::NumberP(new NumberImp())));
+std::shared_ptr<NumberFactory>          nFactory_ptr        (new NumberFactoryStatic<NumberImp>());
 std::shared_ptr<NumberFormatter>        nFormatter_ptr      (new NumberFormatterStandard(nFactory_ptr, scannerBuilder_ptr, sigFigs));
 std::shared_ptr<Builder>                eBuilder_ptr        (new Builders::Standard);
+// The passes fold literal arithmetic as they build; the parser does not,
+// so the input is shown as it was written
+std::shared_ptr<Builder>                rBuilder_ptr        (new Builders::Folding(eBuilder_ptr));
 std::shared_ptr<Parser>                 parser_ptr          (new Parsers::Infix(scannerBuilder_ptr, eBuilder_ptr, nFormatter_ptr, tokenizer_ptr));
 
 // ===============================================================
@@ -71,29 +76,36 @@ std::shared_ptr<Parser>                 parser_ptr          (new Parsers::Infix(
 template<typename T>
 auto reduce( ExprConstSP& exp ) -> ExprConstSP
 {
-    auto visitor = std::make_unique<T>( nFactory_ptr, eBuilder_ptr );
+    auto visitor = std::make_unique<T>( nFactory_ptr, rBuilder_ptr );
     auto success = visitor->visitExpression(exp);
     if ( !success )
         throw std::logic_error("success == false in reduce()");
     return visitor->result();
 }
 
-auto simplify( ExprConstSP exp ) -> ExprConstSP
+auto simplify( ExprConstSP exp, bool saturate ) -> ExprConstSP
 {
     ExprConstSP res;
     res = reduce<BasicSymbols>(exp);
     res = reduce<ComplexSplitter>(res);
     res = reduce<Rationalizer>(res);
+    res = reduce<Expand>(res);
+    res = reduce<Cancel>(res);
 
-    for (int k = 0; k < 20; k++)
+    if ( saturate )
     {
-        res = reduce<ComplexNormalizer>(res);
-        res = reduce<GCDLiteral>(res);
-        res = reduce<SizeOneArray>(res);
-        res = reduce<SelfNesting>(res);
-        res = reduce<Negatives>(res);
-        res = reduce<FirstOrderBasic>(res);
-        res = reduce<NumberReducerBasic>(res);
+        SaturatingSimplifier simplifier( nFactory_ptr, rBuilder_ptr );
+        res = simplifier.run( res );
+    }
+    else
+    {
+        for (int k = 0; k < 20; k++)
+        {
+            ExprConstSP before = res;
+            res = reduce<Simplifier>(res);
+            if (res == before) // nothing was rewritten, so nothing will be
+                break;
+        }
     }
 
     res = reduce<ComplexExpander>(res);
@@ -201,7 +213,7 @@ struct MaybeNumber {
 
 auto evaluate( ExprConstSP exp ) -> MaybeNumber
 {
-    NumEval eval;
+    NumEvalStatic<NumberImp> eval;
     if ( !eval.visitExpression( exp ) )
         return MaybeNumber();
 
@@ -231,12 +243,25 @@ static CI_ResultComponent component( Rendered const& r )
 
 CI_Result* CI_submit( char const* _input )
 {
-    CI_Result* res = new CI_Result;
-
-    ExprConstSP input = parse( std::string( _input ) );
+    // Every expression built for this request lives in the
+    // region; only strings are handed back in the CI_Result,
+    // so the whole region goes away when this returns.
+    Region region;
+    Region::Scope scope( &region );
+
+    // "egraph: e" simplifies e by equality saturation rather than
+    // by the passes
+    std::string expString( _input );
+    bool saturate = ( expString.compare( 0, 7, "egraph:" ) == 0 );
+    if( saturate )
+        expString.erase( 0, 7 );
+
+    ExprConstSP input = parse( expString );
     if( !input )
         return NULL;
-    ExprConstSP output = simplify( input );
+
+    CI_Result* res = new CI_Result;
+    ExprConstSP output = simplify( input, saturate );
     MaybeNumber n_may = evaluate( output );
 
     Rendered r_input  = render( input );
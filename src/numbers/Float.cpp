@@ -207,17 +207,11 @@ void Float::sqrt(void)
         throw invalid_argument("sqrt of a negative number in Float::sqrt");
 #endif
 
-    static Float one(Integer(1)), two(Integer(2)), six(Integer(6)), ten(Integer(10));
-    static Float oneHalf, guessCache[2][10];
-
-    if (oneHalf.isZero())
-    {
-        oneHalf = one/two;
-#ifndef NO_FLOAT_EXCEPTIONS
-        if (oneHalf.numberOfMantissaUnits() != 1)
-            throw logic_error("oneHalf.numberOfMantissaDecimalDigits() != 1 in Float::sqrt");
-#endif
-    }
+    // The constants here and below are initialized once, by whichever
+    // thread gets to them first, so that numbers can be worked on in
+    // several threads at once
+    static const Float one(Integer(1)), two(Integer(2));
+    static const Float oneHalf(one/two);
 
     Float x = Float(std::sqrt(toDouble()));
 
@@ -243,10 +237,7 @@ void Float::sqrt(void)
 
 const Float& Float::pi(void)
 {
-    static Float Pi;
-
-    if (Pi.isZero())
-    {
+    static const Float Pi = []() {
         Float a, g, t, p, aTemp;
         Float one(Integer(1)), two(Integer(2)), four(Integer(4));
         Float oneHalf(one/two), oneFourth(one/four);
@@ -279,17 +270,15 @@ const Float& Float::pi(void)
         if (i == maxIterations)
             throw logic_error("i == maxIterations in Float::pi()");
 #endif
-        Pi = (a+g)*(a+g)/(four*t);
-    }
+        return (a+g)*(a+g)/(four*t);
+    }();
     return Pi;
 }
 
 void Float::AG_mean(const Float& _g) // make sure this doesn't go into an infinite loop
 {
     Float a(*this), g(_g);
-    static Float oneHalf;
-    if (oneHalf.isZero())
-        oneHalf = Float(Integer(1))/Float(Integer(2));
+    static const Float oneHalf(Float(Integer(1))/Float(Integer(2)));
 
     unsigned int maxIterations = 20 + (unsigned int)(.5 + log(double(Float::maxMantissaDigits*UNIT_T_BITS))/log(2));
                                 // unneeded + (base + scaling)
@@ -314,10 +303,7 @@ void Float::AG_mean(const Float& _g) // make sure this doesn't go into an infini
 
 const Float& Float::lnTwo(void)
 {
-    static Float lnTwoVar;
-
-    if (lnTwoVar.isZero())
-    {
+    static const Float lnTwoVar = []() {
         unsigned int m = 2 + (unsigned int)(double(Float::maxMantissaDigits)*13 + .5);
 
         Float two(Integer(2)), four(Integer(4));
@@ -328,8 +314,8 @@ const Float& Float::lnTwo(void)
             s *= two;
 
         AGM.AG_mean(four/s);
-        lnTwoVar = Float::pi() / (AGM*two*Float(Integer((BaseArray::unit_t)m)));
-    }
+        return Float::pi() / (AGM*two*Float(Integer((BaseArray::unit_t)m)));
+    }();
     return lnTwoVar;
 }
 
@@ -364,17 +350,14 @@ void Float::ln(void)
     }
 
     const unsigned int m = 2 + (unsigned int)(double(Float::maxMantissaDigits)*13 + .5);
-    static Integer mInt((BaseArray::unit_t)m);
-    static Float s, fourOverS, piOverTwo, mFloat(mInt), mFloatLnTwo;
-    if (s.isZero())
-    {
-        s = one;
+    static const Float fourOverS = [m]() {
+        Float s(one);
         for (unsigned int i = 0; i < m; i++)
             s *= two;
-        fourOverS = four/s;
-        piOverTwo = Float::pi()/two;
-        mFloatLnTwo = mFloat*Float::lnTwo();
-    }
+        return four/s;
+    }();
+    static const Float piOverTwo(Float::pi()/two);
+    static const Float mFloatLnTwo(Float(Integer((BaseArray::unit_t)m))*Float::lnTwo());
 
     Float AGM(one);
     AGM.AG_mean(fourOverS/(*this));
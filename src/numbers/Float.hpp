@@ -82,6 +82,8 @@ public:
     bool isZero(void) const;
 
     int  numberOfMantissaUnits(void) const;
+    // Mantissa units every result is rounded to
+    static int precision(void) { return maxMantissaDigits; }
     void multiplyByBase(int);
     void divideByBase(int);
     void divideByTwo(void);
@@ -113,6 +115,11 @@ inline Float floor(const Float& number)
     return result;
 }
 
+inline double toDouble(const Float& number)
+{
+    return number.toDouble();
+}
+
 inline void createPi(Float& number)
 {
     number = Float::pi();
@@ -348,8 +348,10 @@ void Integer::multiply_Karatsuba(const Integer& _number) // only seems to be fas
 
 void Integer::operator*= (const Integer& _number)
 {
-    //multiply_Karatsuba(_number);
-    multiply_SchoolBook(_number); // faster for digits <~ 100
+    if (numberOfDigits() > 100 && _number.numberOfDigits() > 100)
+        multiply_Karatsuba(_number);
+    else
+        multiply_SchoolBook(_number); // faster for digits <~ 100
 }
 
 void Integer::operator%= (const Integer& number)
@@ -381,6 +383,8 @@ bool Integer::isLessThan(const Integer& number) const
             --it;
             --it2;
         }
+        if (digits[it] == number.digits[it2]) // equal, whatever the sign
+            return false;
         return (digits[it] < number.digits[it2])^signFlip;
     }
     else
@@ -505,6 +509,7 @@ void Integer::modByUnits(int power)
         return;
 
     digits.cutToSize(static_cast<unsigned int>(power));
+    digits.removeLeadingZeros();
 }
 
 BaseArray::unit_t  Integer::getModByOneUnit(void) const
@@ -27,7 +27,10 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstddef>
+#include <new>
+#include <type_traits>
 
 namespace DS {
 namespace Numbers {
@@ -71,7 +74,9 @@ private:
 
     struct control
     {
-        using ref_count_t = unsigned long;
+        // Atomic so that copies of one array can be made and dropped
+        // on different threads
+        using ref_count_t = std::atomic<unsigned long>;
 
         control()                                 = delete;
         ~control()                                = delete;
@@ -105,7 +110,7 @@ template<typename T>
 shared_array<T>::shared_array(size_t size)
     : m_ctl(reinterpret_cast<control*>(new char[offsetof(control, elem) + sizeof(T)*size]))
 {
-    m_ctl->ref_count = 1;
+    new (&m_ctl->ref_count) typename control::ref_count_t(1);
 }
 
 template<typename T>
@@ -118,7 +123,7 @@ template<typename T>
 void shared_array<T>::release()
 {
     if (m_ctl) {
-        if (!(--(m_ctl->ref_count)))
+        if (m_ctl->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
             delete[] reinterpret_cast<char*>(m_ctl);
         m_ctl = nullptr;
     }
@@ -133,7 +138,7 @@ inline shared_array<T>::shared_array(const shared_array<T>& sa)
     : m_ctl(sa.m_ctl)
 {
     if (m_ctl)
-        ++(m_ctl->ref_count);
+        m_ctl->ref_count.fetch_add(1, std::memory_order_relaxed);
 }
 
 template<typename T>
@@ -146,7 +151,7 @@ const shared_array<T>& shared_array<T>::operator= (const shared_array<T>& rhs)
     release();
     m_ctl = rhs.m_ctl;
     if (m_ctl)
-        ++(m_ctl->ref_count);
+        m_ctl->ref_count.fetch_add(1, std::memory_order_relaxed);
     return *this;
 }
 
@@ -0,0 +1,138 @@
+#include "dfa.hpp"
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+
+using namespace std;
+
+namespace castle {
+
+int nfa::add_state() {
+    m_epsilons.emplace_back();
+    m_edges.emplace_back();
+    return m_edges.size() - 1;
+}
+
+void nfa::add_epsilon( int from, int to ) {
+    m_epsilons[from].push_back( to );
+}
+
+void nfa::add_chars( int from, int to, char_set const& chars ) {
+    m_edges[from].push_back( edge{ to, chars } );
+}
+
+namespace {
+
+// The states reachable from the given ones by epsilon moves, sorted
+vector<int> closure( nfa const& machine, vector<int> states ) {
+    vector<bool> seen( machine.size(), false );
+    vector<int> work;
+    for( int state : states )
+        if( !seen[state] ) {
+            seen[state] = true;
+            work.push_back( state );
+        }
+    states = work;
+    while( !work.empty() ) {
+        int state = work.back();
+        work.pop_back();
+        for( int next : machine.epsilons( state ) )
+            if( !seen[next] ) {
+                seen[next] = true;
+                states.push_back( next );
+                work.push_back( next );
+            }
+    }
+    sort( states.begin(), states.end() );
+    return states;
+}
+
+} // namespace
+
+// The subset construction, each set of machine states becoming one state
+dfa::dfa( vector<scanner::ptr> const& scanners ) {
+    if( scanners.size() > 32 )
+        throw invalid_argument( "more than 32 scanners in dfa::dfa" );
+
+    nfa machine;
+    vector<int> owners, starts, finals;
+    for( size_t i = 0; i < scanners.size(); ++i ) {
+        starts.push_back( machine.add_state() );
+        finals.push_back( machine.add_state() );
+        scanners[i]->compile( machine, starts.back(), finals.back() );
+        owners.resize( machine.size(), i );
+    }
+
+    map<vector<int>, int> ids;
+    vector<vector<int>> sets;
+    auto add = [&]( vector<int> const& set ) {
+        auto found = ids.find( set );
+        if( found != ids.end() )
+            return found->second;
+        int id = sets.size();
+        ids[set] = id;
+        sets.push_back( set );
+        uint32_t accepts = 0, alive = 0;
+        for( int state : set )
+            alive |= uint32_t( 1 ) << owners[state];
+        for( size_t i = 0; i < finals.size(); ++i )
+            if( binary_search( set.begin(), set.end(), finals[i] ) )
+                accepts |= uint32_t( 1 ) << i;
+        m_accepts.push_back( accepts );
+        m_alive.push_back( alive );
+        return id;
+    };
+    add( vector<int>() );
+    add( closure( machine, starts ) );
+
+    for( size_t id = start; id < sets.size(); ++id ) {
+        m_next.resize( 256*sets.size(), dead );
+        for( int c = 0; c < 256; ++c ) {
+            vector<int> moved;
+            for( int state : sets[id] )
+                for( nfa::edge const& e : machine.edges( state ) )
+                    if( e.chars[c] )
+                        moved.push_back( e.to );
+            if( moved.empty() )
+                continue;
+            int next = add( closure( machine, moved ) );
+            m_next.resize( 256*sets.size(), dead );
+            m_next[256*id + c] = next;
+        }
+    }
+}
+
+bool dfa::tokenize( string const& source, vector<token_view>& destination ) {
+    char const* text = source.data();
+    size_t position = 0, size = source.size();
+    m_stop_loc = source.begin();
+    while( position < size ) {
+        int state = start, best = -1;
+        size_t end = position;
+        for( size_t i = position; i < size; ++i ) {
+            state = m_next[256*state + (unsigned char)text[i]];
+            if( state == dead )
+                break;
+            uint32_t accepts = m_accepts[state];
+            if( accepts != 0 ) {
+                int first = __builtin_ctz( accepts );
+                if( best < 0 || first <= best ) {
+                    best = first;
+                    end  = i + 1;
+                }
+            }
+            // Nothing at or before the best scanner can go on
+            if( best >= 0 && ( m_alive[state] & ( ( uint32_t( 2 ) << best ) - 1 ) ) == 0 )
+                break;
+        }
+        if( best < 0 )
+            return false;
+        destination.push_back( token_view( text + position, end - position, best ) );
+        position = end;
+        m_stop_loc = source.begin() + position;
+    }
+    return true;
+}
+
+} // namespace castle
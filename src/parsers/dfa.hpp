@@ -0,0 +1,94 @@
+#pragma once
+
+#include "token.hpp"
+#include "scanner.hpp"
+
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace castle {
+
+// A nondeterministic automaton over bytes, built up by the scanners'
+// compile() methods: each adds the paths between two states given to it.
+class nfa {
+
+public:
+
+    using char_set = std::bitset<256>;
+
+    struct edge {
+        int      to;
+        char_set chars;
+    };
+
+    nfa()                        = default;
+    nfa( nfa const& )            = delete;
+    nfa& operator=( nfa const& ) = delete;
+
+    int  add_state();
+    void add_epsilon( int from, int to );
+    void add_chars( int from, int to, char_set const& chars );
+
+    int size() const { return m_edges.size(); }
+
+    std::vector<int>  const& epsilons( int state ) const { return m_epsilons[state]; }
+    std::vector<edge> const& edges( int state )    const { return m_edges[state];    }
+
+protected:
+
+    std::vector<std::vector<int>>  m_epsilons;
+    std::vector<std::vector<edge>> m_edges;
+
+};
+
+// The scanners of a tokenizer::tokenize_priority call compiled into one
+// table driven automaton, which splits the source in a single pass with
+// no backtracking into the scanners and no copying of the tokens.
+//
+// At each position the token is the one of the first scanner in the list
+// to match there, as long as it matches: the automaton runs all of the
+// scanners side by side, stopping once no scanner before the best so far
+// can still match.  An or_list or optional_list compiles to the regular
+// alternation or sequence, whose longest match is what the scanner itself
+// finds for every scanner scanner_builder makes (each alternative of an
+// or_list is there to match where the earlier ones do not).  A not_ compiles
+// only around a set of single characters.
+class dfa {
+
+public:
+
+    // Throws std::invalid_argument for more than 32 scanners, or for a
+    // scanner with no regular equivalent
+    explicit dfa( std::vector<scanner::ptr> const& scanners );
+
+    dfa( dfa const& )            = delete;
+    dfa& operator=( dfa const& ) = delete;
+
+    bool tokenize( std::string const&        source,
+                   std::vector<token_view>&  destination );
+
+    std::string::const_iterator stop_location() const {
+        return m_stop_loc;
+    }
+
+    int states() const { return m_accepts.size(); }
+
+protected:
+
+    static constexpr int dead  = 0;
+    static constexpr int start = 1;
+
+    // m_next[256*state + byte]
+    std::vector<int>           m_next;
+    // The scanners that match on reaching each state, and those that
+    // still might on reading further
+    std::vector<std::uint32_t> m_accepts;
+    std::vector<std::uint32_t> m_alive;
+
+    std::string::const_iterator m_stop_loc;
+
+};
+
+} // namespace castle
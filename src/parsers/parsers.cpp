@@ -1,4 +1,5 @@
 #include "parsers.hpp"
+#include "dfa.hpp"
 
 #include <stdexcept>
 
@@ -150,5 +151,77 @@ scanner::bounds repeat::scan(scanner::bounds bounds) {
     return bounds;
 }
 
+//_______________________________________________________________
+// Compiling into a dfa
+
+void char_str::compile( nfa& machine, int entry, int exit ) const {
+    if( m_scan_str.empty() )
+        return;
+    int from = entry;
+    for( size_t i = 0; i < m_scan_str.length(); ++i ) {
+        int to = ( i+1 == m_scan_str.length() ) ? exit : machine.add_state();
+        nfa::char_set chars;
+        chars.set( (unsigned char)m_scan_str[i] );
+        machine.add_chars( from, to, chars );
+        from = to;
+    }
+}
+
+bool char_str::char_set( std::bitset<256>& chars ) const {
+    if( m_scan_str.length() != 1 )
+        return false;
+    chars.reset();
+    chars.set( (unsigned char)m_scan_str[0] );
+    return true;
+}
+
+// Up to the first character the repeated scanner matches at
+void not_::compile( nfa& machine, int entry, int exit ) const {
+    nfa::char_set chars;
+    if( !m_repeated->char_set( chars ) )
+        throw invalid_argument( "not_ of more than single characters "
+                                "in not_::compile" );
+    chars.flip();
+    int middle = machine.add_state();
+    machine.add_chars( entry, middle, chars );
+    machine.add_chars( middle, middle, chars );
+    machine.add_epsilon( middle, exit );
+}
+
+void optional_list::compile( nfa& machine, int entry, int exit ) const {
+    int from = entry;
+    for( size_t i = 0; i < m_list.size(); ++i ) {
+        int to = ( i+1 == m_list.size() ) ? exit : machine.add_state();
+        m_list[i]->compile( machine, from, to );
+        if( m_optional_flags[i] )
+            machine.add_epsilon( from, to );
+        from = to;
+    }
+}
+
+void or_list::compile( nfa& machine, int entry, int exit ) const {
+    for( scanner::ptr const& alternative : m_list )
+        alternative->compile( machine, entry, exit );
+}
+
+bool or_list::char_set( std::bitset<256>& chars ) const {
+    std::bitset<256> all, one;
+    for( scanner::ptr const& alternative : m_list ) {
+        if( !alternative->char_set( one ) )
+            return false;
+        all |= one;
+    }
+    chars = all;
+    return true;
+}
+
+void repeat::compile( nfa& machine, int entry, int exit ) const {
+    int first = machine.add_state(), last = machine.add_state();
+    machine.add_epsilon( entry, first );
+    m_repeated->compile( machine, first, last );
+    machine.add_epsilon( last, first );
+    machine.add_epsilon( last, exit );
+}
+
 } // namespace scanners
 } // namespace castle
@@ -19,6 +19,8 @@ public:
     char_str( char        const  c ) : m_scan_str( 1, c ) {}
 
     virtual scanner::bounds scan( scanner::bounds );
+    virtual void compile( nfa&, int, int ) const;
+    virtual bool char_set( std::bitset<256>& ) const;
 
     std::string const& get_string() const { return m_scan_str; }
 
@@ -37,6 +39,7 @@ public:
     not_( scanner::ptr repeated ) : m_repeated( repeated ) {}
 
     virtual scanner::bounds scan( scanner::bounds );
+    virtual void compile( nfa&, int, int ) const;
 
 protected:
 
@@ -55,6 +58,7 @@ public:
                    std::vector<bool> const& );
 
     virtual scanner::bounds scan( scanner::bounds );
+    virtual void compile( nfa&, int, int ) const;
 
 protected:
 
@@ -72,6 +76,8 @@ public:
     or_list( std::vector<scanner::ptr> const& );
 
     virtual scanner::bounds scan( scanner::bounds );
+    virtual void compile( nfa&, int, int ) const;
+    virtual bool char_set( std::bitset<256>& ) const;
 
 protected:
 
@@ -88,6 +94,7 @@ public:
     repeat( scanner::ptr repeated ) : m_repeated( repeated ) {}
 
     virtual scanner::bounds scan( scanner::bounds );
+    virtual void compile( nfa&, int, int ) const;
 
 protected:
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <bitset>
 #include <iterator>
 #include <string>
 #include <utility>
@@ -7,6 +8,8 @@
 
 namespace castle {
 
+class nfa;
+
 class scanner {
 
 public:
@@ -24,6 +27,16 @@ public:
 
     virtual bounds scan( bounds abound ) = 0;
 
+    // Adds paths from entry to exit in the machine for the strings this
+    // scanner matches (see dfa.hpp)
+    virtual void compile( nfa& machine, int entry, int exit ) const = 0;
+
+    // Whether this scanner matches exactly the single characters of a set,
+    // which is then returned in chars
+    virtual bool char_set( std::bitset<256>& ) const {
+        return false;
+    }
+
     scanner( scanner const& )            = delete;
     scanner& operator=( scanner const& ) = delete;
 
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
+#include <string_view>
 
 namespace castle {
 
@@ -30,4 +32,25 @@ protected:
 
 };
 
+// A token that refers to its characters where they lie in the source
+// rather than copying them; the source must outlive it.
+class token_view {
+
+public:
+
+    token_view( char const* first, std::size_t length, int const id )
+        : m_text( first, length ), m_id( id ) { }
+
+    std::string_view text()   const { return m_text;                }
+    std::string      string() const { return std::string( m_text ); }
+    std::size_t      length() const { return m_text.length();       }
+    int              id()     const { return m_id;                  }
+
+protected:
+
+    std::string_view m_text;
+    int              m_id;
+
+};
+
 } // namespace castle
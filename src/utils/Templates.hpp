@@ -9,17 +9,18 @@
 #define TEMPLATES_H_
 
 #include <stack>
+#include <utility>
 
-template <typename T>
-T getPop(std::stack<T>& aStack)
+template <typename T, typename Container>
+T getPop(std::stack<T, Container>& aStack)
 {
-    T result = aStack.top();
+    T result = std::move(aStack.top());
     aStack.pop();
     return result;
 }
 
-template <typename T>
-void clearStack(std::stack<T>& aStack)
+template <typename T, typename Container>
+void clearStack(std::stack<T, Container>& aStack)
 {
     while (!aStack.empty())
         aStack.pop();